@@ -0,0 +1,148 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_balance.cpp
+
+Benchmark for skewed workloads.
+
+Runs a computation in which the work per virtual processor is skewed
+towards the low pids, once with the static task mapper and once with
+bsp::LoadBalancingTaskMapper, which remaps processors after the first
+superstep.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <cmath>
+#include <iostream>
+
+class SkewedBenchmark : public bsp::Context {
+public:
+	SkewedBenchmark () {
+		CONTEXT_SHARED_INIT(work, double);
+		CONTEXT_SHARED_INIT(supersteps, int);
+		CONTEXT_SHARED_INIT(skew, double);
+	}
+
+	void run () {
+		BSP_SCOPE(SkewedBenchmark);
+
+		double t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			BSP_BEGIN();
+			// processor pid spends work * skew^(-pid / p) seconds
+			double t = work * pow (skew, - (double)bsp_pid() / bsp_nprocs());
+			double t1 = bsp_time();
+			while (bsp_time() - t1 < t) ;
+			BSP_END();
+
+			if (s == 0) {
+				get_mapper()->rebalance();
+			}
+		}
+		time_per_superstep = (bsp_time() - t0) / supersteps;
+	}
+
+	double work;
+	int supersteps;
+	double skew;
+	double time_per_superstep;
+};
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int processors, supersteps;
+	double work, skew;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("processors,p", value<int>()->default_value(4 * bsp_nprocs()),
+			"Number of virtual processors.")
+			("work,w", value<double>()->default_value(0.01),
+			"Work per superstep on the busiest processor (seconds).")
+			("skew,k", value<double>()->default_value(10),
+			"Ratio of the work on the busiest and the least busy processor.")
+			("supersteps,t", value<int>()->default_value(20),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		processors = vm["processors"].as<int>();
+		work = vm["work"].as<double>();
+		skew = vm["skew"].as<double>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (processors < 1 || work < 0 || skew < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		double t_static, t_balanced;
+		{
+			bsp::Runner<SkewedBenchmark> r (processors);
+			r.work = work;
+			r.skew = skew;
+			r.supersteps = supersteps;
+			r.run();
+			t_static = r.time_per_superstep;
+		}
+		{
+			bsp::Runner<SkewedBenchmark, bsp::LoadBalancingTaskMapper> r (processors);
+			r.work = work;
+			r.skew = skew;
+			r.supersteps = supersteps;
+			r.run();
+			t_balanced = r.time_per_superstep;
+		}
+
+		if (bsp_pid() == 0) {
+			cout << "mapper\ttime/superstep (s)" << endl;
+			cout << "static\t" << t_static << endl;
+			cout << "balanced\t" << t_balanced << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
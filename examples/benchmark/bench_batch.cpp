@@ -0,0 +1,127 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_batch.cpp
+
+Benchmark for many small puts.
+
+Measures how many 8-byte puts per second each processor can issue and
+deliver (including bsp_sync) to random locations on random processors,
+using one bsp_put per value and using bsp_put_batch.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <iostream>
+#include <vector>
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int values, supersteps, table_size;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("values,n", value<int>()->default_value(1000000),
+			"Number of puts per processor and superstep.")
+			("table,m", value<int>()->default_value(65536),
+			"Number of table entries per processor.")
+			("supersteps,t", value<int>()->default_value(5),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		values = vm["values"].as<int>();
+		table_size = vm["table"].as<int>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (values < 1 || table_size < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		vector<double> table (table_size, 0);
+		vector<double> data (values);
+		vector<int> pids (values);
+		vector<long> offsets (values);
+
+		srand (bsp_pid() + 1);
+		for (int k = 0; k < values; ++k) {
+			pids[k] = rand() % bsp_nprocs();
+			offsets[k] = (rand() % table_size) * sizeof(double);
+			data[k] = k;
+		}
+
+		bsp_push_reg (&table[0], table_size * sizeof(double));
+		bsp_sync();
+
+		double t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			for (int k = 0; k < values; ++k) {
+				bsp_put (pids[k], &data[k], &table[0], offsets[k], sizeof(double));
+			}
+			bsp_sync();
+		}
+		double t_scalar = bsp_time() - t0;
+
+		t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			bsp_put_batch (&table[0], &pids[0], &offsets[0], &data[0], sizeof(double), values);
+			bsp_sync();
+		}
+		double t_batch = bsp_time() - t0;
+
+		bsp_pop_reg (&table[0]);
+		bsp_sync();
+
+		if (bsp_pid() == 0) {
+			double puts = (double) values * supersteps;
+			cout << "p\tvalues\tbsp_put (puts/s)\tbsp_put_batch (puts/s)" << endl;
+			cout << bsp_nprocs() << "\t" << values << "\t"
+				<< puts / t_scalar << "\t" << puts / t_batch << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
@@ -0,0 +1,151 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_counters.cpp
+
+Benchmark for distributed counters.
+
+Every processor increments counters on random processors and needs the
+previous value of each counter. Measures the increments per second using
+bsp_fetch_op (one superstep), and using a BSMP round trip in which the
+owner of each counter increments it and sends back the old value (two
+supersteps).
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <iostream>
+#include <vector>
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int values, supersteps, table_size;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("values,n", value<int>()->default_value(100000),
+			"Number of increments per processor and superstep.")
+			("table,m", value<int>()->default_value(1024),
+			"Number of counters per processor.")
+			("supersteps,t", value<int>()->default_value(5),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		values = vm["values"].as<int>();
+		table_size = vm["table"].as<int>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (values < 1 || table_size < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		vector<long> counters (table_size, 0);
+		vector<long> previous (values);
+		vector<int> pids (values);
+		vector<int> indices (values);
+		long one = 1;
+
+		srand (bsp_pid() + 1);
+		for (int k = 0; k < values; ++k) {
+			pids[k] = rand() % bsp_nprocs();
+			indices[k] = rand() % table_size;
+		}
+
+		bsp_push_reg (&counters[0], table_size * sizeof(long));
+		size_t tagsize = sizeof(int);
+		bsp_set_tagsize (&tagsize);
+		bsp_sync();
+
+		double t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			for (int k = 0; k < values; ++k) {
+				bsp_fetch_op (pids[k], &counters[0], indices[k] * sizeof(long), 
+					&one, &previous[k], bsp_op_sum, bsp_type_long);
+			}
+			bsp_sync();
+		}
+		double t_fetch = bsp_time() - t0;
+
+		t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			// request: tag = request number, payload = counter index
+			for (int k = 0; k < values; ++k) {
+				bsp_send (pids[k], &k, &indices[k], sizeof(int));
+			}
+			bsp_sync();
+
+			// the owner increments and replies with the old value
+			bsp_message_t m;
+			for (int more = bsp_messages_begin (&m); more; more = bsp_messages_next (&m)) {
+				int index;
+				memcpy (&index, m.payload, sizeof(int));
+				bsp_send (m.source, m.tag, &counters[index], sizeof(long));
+				counters[index]++;
+			}
+			bsp_sync();
+
+			for (int more = bsp_messages_begin (&m); more; more = bsp_messages_next (&m)) {
+				int request;
+				memcpy (&request, m.tag, sizeof(int));
+				memcpy (&previous[request], m.payload, sizeof(long));
+			}
+		}
+		double t_bsmp = bsp_time() - t0;
+
+		bsp_pop_reg (&counters[0]);
+		bsp_sync();
+
+		if (bsp_pid() == 0) {
+			double increments = (double) values * supersteps;
+			cout << "p\tvalues\tbsp_fetch_op (inc/s)\tBSMP round trip (inc/s)" << endl;
+			cout << bsp_nprocs() << "\t" << values << "\t"
+				<< increments / t_fetch << "\t" << increments / t_bsmp << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
@@ -0,0 +1,146 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_memreg.cpp
+
+Benchmark for registration-heavy workloads.
+
+Measures the superstep time when every virtual processor pushes and pops
+a number of registrations in every superstep, for a range of processor
+counts.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <iostream>
+#include <vector>
+
+class MemRegBenchmark : public bsp::Context {
+public:
+	MemRegBenchmark () {
+		CONTEXT_SHARED_INIT(registrations, int);
+		CONTEXT_SHARED_INIT(supersteps, int);
+	}
+
+	void run () {
+		BSP_SCOPE(MemRegBenchmark);
+
+		BSP_BEGIN();
+		areas.resize(registrations);
+		BSP_END();
+
+		double t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			BSP_BEGIN();
+			for (int r = 0; r < registrations; ++r) {
+				bsp_push_reg (&areas[r], sizeof(int));
+			}
+			BSP_END();
+
+			BSP_BEGIN();
+			for (int r = 0; r < registrations; ++r) {
+				bsp_pop_reg (&areas[r]);
+			}
+			BSP_END();
+		}
+		time_per_superstep = (bsp_time() - t0) / (2*supersteps);
+	}
+
+	int registrations;
+	int supersteps;
+	double time_per_superstep;
+
+private:
+	std::vector<int> areas;
+};
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int pmin, pmax, pstep, registrations, supersteps;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("pmin,l", value<int>()->default_value(1),
+			"Minimum number of processors.")
+			("pmax,r", value<int>()->default_value(64),
+			"Maximum number of processors.")
+			("pstep,s", value<int>()->default_value(2),
+			"Factor to multiply the number of processors by.")
+			("registrations,n", value<int>()->default_value(16),
+			"Number of registrations per processor and superstep.")
+			("supersteps,t", value<int>()->default_value(20),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		pmin = vm["pmin"].as<int>();
+		pmax = vm["pmax"].as<int>();
+		pstep = vm["pstep"].as<int>();
+		registrations = vm["registrations"].as<int>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (pmin < 1 || pmin > pmax || pstep < 2 || registrations < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		if (bsp_pid() == 0) {
+			cout << "p\tregistrations\ttime/superstep (s)" << endl;
+		}
+
+		for (int p = pmin; p <= pmax; p *= pstep) {
+			bsp::Runner<MemRegBenchmark> r (p);
+			r.registrations = registrations;
+			r.supersteps = supersteps;
+			r.run();
+
+			if (bsp_pid() == 0) {
+				cout << p << "\t" << registrations << "\t" << r.time_per_superstep << endl;
+			}
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
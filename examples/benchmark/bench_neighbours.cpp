@@ -0,0 +1,157 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_neighbours.cpp
+
+Benchmark for halo exchanges.
+
+The processors form a periodic 3D grid, and every processor puts a halo
+to each of its (up to 26) neighbours in every superstep. Measures the 
+time per superstep with bsp_sync over all processors, and after 
+declaring the neighbours with bsp_set_neighbours.
+
+To see how both scale, run with increasing p, e.g. up to 
+mpirun --oversubscribe -np 1024 on a single node.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+/** split p into three factors which are as close as possible */
+static void grid_dims (int p, int dims[3]) {
+	dims[0] = dims[1] = dims[2] = 1;
+	for (int f = 2; p > 1; ) {
+		if (p % f != 0) {
+			++f;
+			continue;
+		}
+		p /= f;
+		*std::min_element (dims, dims + 3) *= f;
+	}
+}
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int halo, supersteps;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("halo,n", value<int>()->default_value(1024),
+			"Size of each halo in bytes.")
+			("supersteps,t", value<int>()->default_value(100),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		halo = vm["halo"].as<int>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (halo < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		int dims[3], c[3];
+		int p = bsp_pid();
+		grid_dims (bsp_nprocs(), dims);
+		c[0] = p % dims[0];
+		c[1] = (p / dims[0]) % dims[1];
+		c[2] = p / (dims[0] * dims[1]);
+
+		vector<int> neighbours;
+		for (int dz = -1; dz <= 1; ++dz) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					int x = (c[0] + dx + dims[0]) % dims[0];
+					int y = (c[1] + dy + dims[1]) % dims[1];
+					int z = (c[2] + dz + dims[2]) % dims[2];
+					int q = x + dims[0] * (y + dims[1] * z);
+					if (q != p) {
+						neighbours.push_back (q);
+					}
+				}
+			}
+		}
+		sort (neighbours.begin(), neighbours.end());
+		neighbours.erase (unique (neighbours.begin(), neighbours.end()), neighbours.end());
+
+		// halos of different neighbours may overwrite each other, only the
+		// timing matters
+		vector<char> out (halo, (char) p), in (27 * halo);
+		bsp_push_reg (&in[0], in.size());
+		bsp_sync();
+
+		double t[2];
+		for (int mode = 0; mode < 2; ++mode) {
+			if (mode == 1) {
+				bsp_set_neighbours (&neighbours[0], (int) neighbours.size());
+			}
+			bsp_sync();
+			double t0 = bsp_time();
+			for (int s = 0; s < supersteps; ++s) {
+				for (size_t k = 0; k < neighbours.size(); ++k) {
+					bsp_put (neighbours[k], &out[0], &in[0], (p % 27) * halo, halo);
+				}
+				bsp_sync();
+			}
+			t[mode] = (bsp_time() - t0) / supersteps;
+		}
+		bsp_set_neighbours (NULL, -1);
+
+		bsp_pop_reg (&in[0]);
+		bsp_sync();
+
+		if (bsp_pid() == 0) {
+			cout << "p\tneighbours\thalo (bytes)\tall (s/superstep)\tneighbours (s/superstep)" << endl;
+			cout << bsp_nprocs() << "\t" << neighbours.size() << "\t" << halo << "\t" 
+				<< t[0] << "\t" << t[1] << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
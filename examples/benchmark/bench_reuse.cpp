@@ -0,0 +1,126 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_reuse.cpp
+
+Benchmark for short computations.
+
+Measures how many short BSP computations (a single put exchange) can be 
+run per second when a new bsp::Runner is created for every computation, 
+and when one runner is reused.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <iostream>
+
+class ShortComputation : public bsp::Context {
+public:
+	void init () {
+		value = -1;
+	}
+
+	void run () {
+		BSP_SCOPE(ShortComputation);
+
+		BSP_BEGIN();
+		bsp_push_reg (&value, sizeof(int));
+		BSP_SYNC();
+		int pid = bsp_pid();
+		bsp_put ((bsp_pid() + 1) % bsp_nprocs(), &pid, &value, 0, sizeof(int));
+		BSP_SYNC();
+		bsp_pop_reg (&value);
+		BSP_END();
+	}
+
+private:
+	int value;
+};
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int processors, runs;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("processors,p", value<int>()->default_value(-1),
+			"Number of virtual processors (default: automatic).")
+			("runs,n", value<int>()->default_value(1000),
+			"Number of computations to run.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		processors = vm["processors"].as<int>();
+		runs = vm["runs"].as<int>();
+
+		if (runs < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		double t0 = bsp_time();
+		for (int r = 0; r < runs; ++r) {
+			bsp::Runner<ShortComputation> (processors).run();
+		}
+		double t_new = bsp_time() - t0;
+
+		t0 = bsp_time();
+		{
+			bsp::Runner<ShortComputation> runner (processors);
+			for (int r = 0; r < runs; ++r) {
+				runner.run();
+			}
+		}
+		double t_reuse = bsp_time() - t0;
+
+		if (bsp_pid() == 0) {
+			cout << "runner\truns/s" << endl;
+			cout << "new\t" << runs / t_new << endl;
+			cout << "reused\t" << runs / t_reuse << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
@@ -0,0 +1,155 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bench_stream.cpp
+
+STREAM-style memory bandwidth benchmark for task contexts.
+
+Every virtual processor runs the STREAM triad a = b + s * c on its own 
+arrays. The benchmark is run with the basic task mapper, and with 
+bsp::NumaTaskMapper, which first-touches every context's arrays on its
+NUMA node and keeps executing the context there.
+
+@author Peter Krusche
+*/
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include <iostream>
+#include <vector>
+
+class StreamBenchmark : public bsp::Context {
+public:
+	StreamBenchmark () {
+		CONTEXT_SHARED_INIT(n, int);
+		CONTEXT_SHARED_INIT(supersteps, int);
+	}
+
+	void run () {
+		BSP_SCOPE(StreamBenchmark);
+
+		// arrays are allocated and first touched by the thread which 
+		// executes the context
+		BSP_BEGIN();
+		a.resize(n, 0.0);
+		b.resize(n, 1.0);
+		c.resize(n, 2.0);
+		BSP_END();
+
+		double t0 = bsp_time();
+		for (int s = 0; s < supersteps; ++s) {
+			BSP_BEGIN();
+			const double scalar = 3.0;
+			double * RESTRICT pa = &a[0];
+			const double * RESTRICT pb = &b[0];
+			const double * RESTRICT pc = &c[0];
+			for (int j = 0; j < n; ++j) {
+				pa[j] = pb[j] + scalar * pc[j];
+			}
+			BSP_END();
+		}
+		time_per_superstep = (bsp_time() - t0) / supersteps;
+	}
+
+	int n;
+	int supersteps;
+	double time_per_superstep;
+
+private:
+	std::vector<double> a, b, c;
+};
+
+/** run the benchmark with a given task mapper, and return the 
+ *  bandwidth per node in MB/s */
+template <class _mapper>
+double run_stream (int processors, int n, int supersteps) {
+	bsp::Runner<StreamBenchmark, _mapper> r (processors);
+	r.n = n;
+	r.supersteps = supersteps;
+	r.run();
+	return 3.0 * sizeof(double) * n * r.get_mapper()->procs_this_node() 
+		/ r.time_per_superstep / (1024.0 * 1024.0);
+}
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+	int processors, n, supersteps;
+
+	try {
+		using namespace bsp;
+		using namespace boost::program_options;
+		options_description opts;
+		opts.add_options()
+			("help,h", "produce a help message")
+			("processors,p", value<int>()->default_value(0),
+			"Number of virtual processors (default: one per CPU).")
+			("size,n", value<int>()->default_value(4*1024*1024),
+			"Number of array elements per processor.")
+			("supersteps,t", value<int>()->default_value(20),
+			"Number of supersteps to time.")
+			;
+		variables_map vm;
+
+		bsp_command_line(argc, argv, opts, vm);
+
+		if (vm.count ("help") > 0) {
+			if (bsp_pid() == 0) {
+				cout << opts << endl;
+			}
+			bsp_sync();
+			bsp_end();
+			exit(0);
+		}
+
+		processors = vm["processors"].as<int>();
+		n = vm["size"].as<int>();
+		supersteps = vm["supersteps"].as<int>();
+
+		if (processors == 0) {
+			processors = bsp_nprocs() * NumaTopology::get().total_cpus();
+		}
+
+		if (processors < 1 || n < 1 || supersteps < 1) {
+			throw std::runtime_error ("Invalid parameters.");
+		}
+
+		double bw_basic = run_stream<bsp::TaskMapper> (processors, n, supersteps);
+		double bw_numa = run_stream<bsp::NumaTaskMapper> (processors, n, supersteps);
+
+		if (bsp_pid() == 0) {
+			cout << "NUMA nodes: " << NumaTopology::get().nodes() 
+				 << ", CPUs: " << NumaTopology::get().total_cpus() << endl;
+			cout << "mapper\ttriad bandwidth per node (MB/s)" << endl;
+			cout << "basic\t" << bw_basic << endl;
+			cout << "numa\t" << bw_numa << endl;
+		}
+	} catch (std::runtime_error e) {
+		string s = e.what();
+		s+= "\n";
+		bsp_abort(s.c_str());
+	}
+
+	bsp_end();
+}
@@ -54,12 +54,97 @@ writing a BSP program and is therefore  part of the installation.
 #define BSP_MEMREG_MIN_SIZE  1	
 #endif
 
+/** Size of the symmetric heap, which is reserved at the first call of 
+ *  bsp_symmetric_alloc() */
+#ifndef BSP_SYMMETRIC_HEAP_SIZE
+#define BSP_SYMMETRIC_HEAP_SIZE (64*1024*1024)
+#endif
+
+/** Number of puts after which incoming columns are received, and 
+ *  completed sends are freed, when columns are sent during the superstep
+ *  (see bsp_set_eager_threshold()) */
+#ifndef BSP_EAGER_POLL_INTERVAL
+#define BSP_EAGER_POLL_INTERVAL 64
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
 	typedef int bsp_global_handle_t;
 
+	/** A subset of the processors which synchronises independently, see bsp_team_split */
+	typedef struct _bsp_team * bsp_team_t;
+
+	/** A recorded communication pattern, see bsp_pattern_begin */
+	typedef struct _bsp_pattern * bsp_pattern_t;
+
+	/** Distributions of global arrays, see bsp_global_alloc_dist */
+	typedef enum {
+		bsp_dist_block,			/**< one contiguous slice per processor */
+		bsp_dist_block_cyclic,	/**< blocks dealt to processors round robin */
+		bsp_dist_custom			/**< blocks placed by a bsp_global_owner_fn */
+	} bsp_dist_t;
+
+	/** Owner of a block of a global array with a custom distribution. 
+	 *  Must give the same result on all processors. */
+	typedef int (*bsp_global_owner_fn) (size_t block, int nprocs);
+
+	/** Statistics of the cache of a global array, see bsp_global_cache */
+	typedef struct {
+		unsigned long hits;				/**< cache lines read without communication */
+		unsigned long misses;			/**< cache lines which were fetched */
+		unsigned long invalidations;	/**< cached lines discarded after a write */
+	} bsp_global_cache_stats_t;
+
+	/** A block of an indexed put or get, see bsp_put_indexed */
+	typedef struct {
+		long src_offset;	/**< offset of the block from the source */
+		long dst_offset;	/**< offset of the block from the destination */
+		size_t nbytes;		/**< size of the block in bytes */
+	} bsp_block_t;
+
+	/** Operations for bsp_put_accumulate and bsp_fetch_op */
+	typedef enum {
+		bsp_op_sum, bsp_op_min, bsp_op_max, 
+		bsp_op_band, bsp_op_bor, bsp_op_bxor,	/**< bitwise, integer types only */
+		bsp_op_user								/**< first user-defined operation */
+	} bsp_op_t;
+
+	/** Element types for bsp_put_accumulate, bsp_fetch_op and bsp_cas */
+	typedef enum {
+		bsp_type_int, bsp_type_long, bsp_type_float, bsp_type_double
+	} bsp_type_t;
+
+	/** User-defined accumulate operation: combine nbytes of src into 
+	 *  accumulated */
+	typedef void (*bsp_accumulate_fn) (void * accumulated, const void * src, size_t nbytes);
+
+	/** Key of a message for sender-side combining. Messages to the same 
+	 *  destination with the same key (>= 0) are combined, messages with 
+	 *  negative keys are sent unchanged. */
+	typedef long (*bsp_combiner_key_fn) (const void * tag, const void * payload, size_t nbytes);
+
+	/** Associative function which combines the payload of a message into
+	 *  the payload of a buffered message with the same key (both nbytes) */
+	typedef void (*bsp_combiner_fn) (void * accumulated, const void * payload, size_t nbytes);
+
+	/** A received BSMP message, see bsp_messages_begin */
+	typedef struct {
+		int source;				/**< pid of the sender */
+		const void * tag;		/**< the message tag */
+		const void * payload;	/**< the message payload */
+		size_t nbytes;			/**< payload size in bytes */
+
+		/* iteration state */
+		const char * next_;
+		unsigned int remaining_;
+		const char * base_;
+		size_t column_bytes_;
+		size_t tag_offset_;
+		size_t payload_offset_;
+	} bsp_message_t;
+
 	/** @name Initialisation */
 	/*@{*/
 	void BSP_CALLING bsp_init (int*, char **[]);
@@ -81,6 +166,7 @@ extern "C" {
 	/*@{*/
 	void BSP_CALLING bsp_sync ();
 	void BSP_CALLING bsp_reset_buffers();
+	void BSP_CALLING bsp_set_eager_threshold(size_t nbytes);
 	/*@}*/
 
 	/** @name DRMA */
@@ -89,6 +175,16 @@ extern "C" {
 	void BSP_CALLING bsp_pop_reg (const void *);
 	void BSP_CALLING bsp_put (int, const void *, void *, long int, size_t);
 	void BSP_CALLING bsp_get (int, const void *, long int, void *, size_t);
+	void BSP_CALLING bsp_put_strided (int, const void *, long int, void *, long int, long int, size_t, int);
+	void BSP_CALLING bsp_get_strided (int, const void *, long int, long int, void *, long int, size_t, int);
+	void BSP_CALLING bsp_put_indexed (int, const void *, void *, const bsp_block_t *, int);
+	void BSP_CALLING bsp_get_indexed (int, const void *, void *, const bsp_block_t *, int);
+	void BSP_CALLING bsp_put_batch (void *, const int *, const long int *, const void *, size_t, int);
+	void BSP_CALLING bsp_get_batch (const void *, const int *, const long int *, void *, size_t, int);
+	void BSP_CALLING bsp_put_accumulate (int, const void *, void *, long int, size_t, bsp_op_t, bsp_type_t);
+	bsp_op_t BSP_CALLING bsp_register_op (bsp_accumulate_fn);
+	void BSP_CALLING bsp_fetch_op (int, const void *, long int, const void *, void *, bsp_op_t, bsp_type_t);
+	void BSP_CALLING bsp_cas (int, const void *, long int, const void *, const void *, void *, bsp_type_t);
 	/*@}*/
 
 	/** @name BSMP */
@@ -98,6 +194,7 @@ extern "C" {
 	void BSP_CALLING bsp_get_tag (int * RESTRICT , void * RESTRICT );
 	void BSP_CALLING bsp_move (void *, size_t);
 	void BSP_CALLING bsp_set_tagsize (size_t *);
+	void BSP_CALLING bsp_set_combiner (bsp_combiner_key_fn, bsp_combiner_fn);
 	/*@}*/
 
 	/** @name High Performance */
@@ -107,14 +204,56 @@ extern "C" {
 	int BSP_CALLING bsp_hpmove (void **, void **);
 	/*@}*/
 
+	/** @name Bulk message access */
+	/*@{*/
+	int BSP_CALLING bsp_messages_begin (bsp_message_t *);
+	int BSP_CALLING bsp_messages_next (bsp_message_t *);
+	void * BSP_CALLING bsp_messages_keep ();
+	void BSP_CALLING bsp_messages_release (void *);
+	/*@}*/
+
+	/** @name Neighbourhoods */
+	/*@{*/
+	void BSP_CALLING bsp_set_neighbours(const int * pids, int n);
+	/*@}*/
+
+	/** @name Communication patterns */
+	/*@{*/
+	void BSP_CALLING bsp_pattern_begin(void);
+	bsp_pattern_t BSP_CALLING bsp_pattern_end(void);
+	void BSP_CALLING bsp_pattern_sync(bsp_pattern_t pattern);
+	void BSP_CALLING bsp_pattern_free(bsp_pattern_t pattern);
+	/*@}*/
+
+	/** @name Teams */
+	/*@{*/
+	bsp_team_t BSP_CALLING bsp_team_split(int color, int key);
+	void BSP_CALLING bsp_team_enter(bsp_team_t team);
+	void BSP_CALLING bsp_team_leave(void);
+	void BSP_CALLING bsp_team_free(bsp_team_t team);
+	/*@}*/
+
+	/** @name Symmetric heap */
+	/*@{*/
+	void * BSP_CALLING bsp_symmetric_alloc(size_t size);
+	void BSP_CALLING bsp_symmetric_free(void * ptr);
+	/*@}*/
+
 	/** @name Global DRMA */
 	/*@{*/
 	bsp_global_handle_t BSP_CALLING bsp_global_alloc(size_t array_size);
+	bsp_global_handle_t BSP_CALLING bsp_global_alloc_dist(size_t array_size, bsp_dist_t dist, size_t block_size, bsp_global_owner_fn owner);
+	int BSP_CALLING bsp_global_owner(bsp_global_handle_t handle, size_t offset);
 	void BSP_CALLING bsp_global_free(bsp_global_handle_t ptr);
 	void BSP_CALLING bsp_global_get(bsp_global_handle_t src, size_t offset, void * dest, size_t size);
 	void BSP_CALLING bsp_global_put(const void * src, bsp_global_handle_t dest, size_t offset, size_t size);
 	void BSP_CALLING bsp_global_hpget(bsp_global_handle_t src, size_t offset, void * dest, size_t size);
 	void BSP_CALLING bsp_global_hpput(const void * src, bsp_global_handle_t dest, size_t offset, size_t size);
+	void BSP_CALLING bsp_global_put_accumulate(const void * src, bsp_global_handle_t dest, size_t offset, size_t size, bsp_op_t op, bsp_type_t type);
+	void BSP_CALLING bsp_global_gather(bsp_global_handle_t src, const size_t * indices, size_t n, void * dest, size_t nbytes);
+	void BSP_CALLING bsp_global_scatter(const void * src, bsp_global_handle_t dest, const size_t * indices, size_t n, size_t nbytes);
+	void BSP_CALLING bsp_global_cache(bsp_global_handle_t handle, size_t line_size);
+	void BSP_CALLING bsp_global_cache_stats(bsp_global_handle_t handle, bsp_global_cache_stats_t * stats);
 	/*@}*/
 
 	/** @name Timing and benchmarking */
@@ -33,6 +33,8 @@
  * Error number defintions and their translation
  */
 /*@{*/
+/** when an accumulate operation is not defined for a type */
+#define ERR_INVALID_OPERATION 6
 /** When a 'bsp_get' gets delivered. <= this is impossible */
 #define ERR_GET_DELIVERED   5
 /** used in MemoryRegister when the stack counter becomes to big */
@@ -51,6 +53,7 @@
 	, "bsp_pop_reg without bsp_push_reg\n"\
 	, "stack counter overflow"\
 	, "a bsp_get() is delivered! contact the library maintainer"\
+	, "invalid accumulate operation"\
 	}
 /*@}*/
 
@@ -0,0 +1,96 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file Accumulate.h
+
+Typed helpers for bsp_put_accumulate:
+
+	struct Mul { double operator() (double a, double b) const { return a*b; } };
+	bsp_op_t mul = bsp::register_op<double, Mul> ();	// on every node, same order
+	...
+	accumulate (pid, src, a, 10, bsp_op_sum, 5);	// data[10..14] on pid += src[0..4]
+	accumulate (pid, src, a, 0, mul);
+
+@author Peter Krusche
+*/
+
+#ifndef __bsp_Accumulate_H__
+#define __bsp_Accumulate_H__
+
+#include "bsp.h"
+
+#include <stddef.h>
+
+namespace bsp {
+
+	/** element type for accumulate operations. Only built-in types
+	 *  have a bsp_type_t; for other element types, use a user-defined
+	 *  operation, which ignores the element type. */
+	template <class T> 
+	struct AccumulateType {
+		static const bsp_type_t type = bsp_type_int;
+		static const bool builtin = false;
+	};
+
+	template <> struct AccumulateType<int> {
+		static const bsp_type_t type = bsp_type_int;
+		static const bool builtin = true;
+	};
+
+	template <> struct AccumulateType<long> {
+		static const bsp_type_t type = bsp_type_long;
+		static const bool builtin = true;
+	};
+
+	template <> struct AccumulateType<float> {
+		static const bsp_type_t type = bsp_type_float;
+		static const bool builtin = true;
+	};
+
+	template <> struct AccumulateType<double> {
+		static const bsp_type_t type = bsp_type_double;
+		static const bool builtin = true;
+	};
+
+	/** elementwise user-defined operation: a[i] = Op()(a[i], b[i]) */
+	template <class T, class Op> 
+	void accumulate_elements (void * accumulated, const void * src, size_t nbytes) {
+		T * a = (T *) accumulated;
+		const T * b = (const T *) src;
+		Op op;
+		for (size_t i = 0; i < nbytes / sizeof(T); ++i) {
+			a[i] = op (a[i], b[i]);
+		}
+	}
+
+	/** register Op as a user-defined operation on elements of type T. 
+	 *  Must be called outside of parallel sections, in the same order
+	 *  on all nodes. */
+	template <class T, class Op> 
+	inline bsp_op_t register_op () {
+		return ::bsp_register_op (accumulate_elements<T, Op>);
+	}
+
+};
+
+#endif // __bsp_Accumulate_H__
@@ -0,0 +1,122 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file Array.h
+
+Typed handles for registered memory.
+
+Registering through a handle avoids the lookup by address which 
+bsp_put/bsp_get need:
+
+	bsp::Array<double> a = bsp_push_array (data, 100);
+	BSP_SYNC();
+	put (pid, src, a, 10, 5);		// data[10..14] on pid = src[0..4]
+	put<3> (pid, src, a, 20);		// fixed size put of 3 elements
+	get (pid, a, 0, dst, 5);
+
+@author Peter Krusche
+*/
+
+#ifndef __bsp_Array_H__
+#define __bsp_Array_H__
+
+#include <stdlib.h>
+
+namespace bsp {
+
+	/** Handle to a registered memory area. The handle is the same 
+	 *  on all processors, and becomes valid after the next sync. */
+	class Registration {
+	public:
+		Registration () : serial ((size_t)-1) {}
+		explicit Registration (size_t _serial) : serial (_serial) {}
+
+		/** the registration serial */
+		inline size_t get_serial () const {
+			return serial;
+		}
+
+		/** true if this handle refers to a registration */
+		inline bool valid () const {
+			return serial != (size_t)-1;
+		}
+
+	private:
+		size_t serial;
+	};
+
+	/** A registered array of count elements of type T */
+	template <class T>
+	class Array {
+	public:
+		typedef T value_type;
+
+		Array () : data (NULL), count (0) {}
+
+		Array (Registration const & _reg, T * _data, size_t _count) : 
+			reg (_reg), data (_data), count (_count) {}
+
+		/** the registration of this array */
+		inline Registration const & registration () const {
+			return reg;
+		}
+
+		/** the local copy */
+		inline T * local () const {
+			return data;
+		}
+
+		/** number of elements in the local copy */
+		inline size_t size () const {
+			return count;
+		}
+
+		/** local element access */
+		inline T & operator[] (size_t i) const {
+			return data[i];
+		}
+
+	private:
+		Registration reg;
+		T * data;
+		size_t count;
+	};
+
+	/** A single registered variable */
+	template <class T>
+	class Registered : public Array<T> {
+	public:
+		Registered () {}
+
+		Registered (Registration const & _reg, T * _data) : 
+			Array<T> (_reg, _data, 1) {}
+
+		/** the local value */
+		inline T & operator* () const {
+			return *this->local();
+		}
+	};
+
+};
+
+#endif // __bsp_Array_H__
@@ -0,0 +1,168 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file Channel.h
+
+Typed message channels.
+
+A channel transfers fixed-size (tag, payload) records. Records are 
+appended to one column per destination without any per-message header, 
+and are received as a contiguous array in the next superstep:
+
+	class MyContext : public bsp::Context {
+	public:
+		MyContext () : edges (this) {}
+
+		void run () {
+			...
+			edges.send (pid, vertex, weight);
+			BSP_SYNC();
+			for (Channel<int, double>::const_iterator it = edges.begin(); 
+				it != edges.end(); ++it) {
+				... it->tag, it->payload ...
+			}
+			...
+		}
+
+		bsp::Channel<int, double> edges;
+	};
+
+Tag and payload types must be copyable using memcpy. Every context must 
+create the same channels in the same order (e.g. as members of the 
+context class), and channels are independent of each other and of 
+bsp_send. Records which have not been read when a context is moved to 
+a different node are lost.
+
+@author Peter Krusche
+*/
+
+#ifndef __bsp_Channel_H__
+#define __bsp_Channel_H__
+
+#include <vector>
+
+#include "Context.h"
+
+namespace bsp {
+
+	/** Type-independent part of a channel. */
+	class ChannelBase {
+	public:
+		ChannelBase (Context * _owner, size_t _record_size) :
+			owner (_owner), rsize (_record_size), inbox_count (0) {
+			owner->add_channel (this);
+		}
+
+		virtual ~ChannelBase () {}
+
+		/** size of a single record in bytes */
+		inline size_t record_size () const {
+			return rsize;
+		}
+
+		/** number of records received in the last sync */
+		inline size_t size () const {
+			return inbox_count;
+		}
+
+		/** discard all queued and received records */
+		inline void clear () {
+			for (size_t j = 0; j < destinations.size(); ++j) {
+				outbox[destinations[j]].clear();
+			}
+			destinations.clear();
+			inbox.clear();
+			inbox_count = 0;
+		}
+
+	protected:
+		/** append a record for pid, and return its location */
+		inline char * append (int pid) {
+			if (outbox.empty()) {
+				outbox.resize (owner->bsp_nprocs());
+			}
+			std::vector<char> & column (outbox[pid]);
+			if (column.empty()) {
+				destinations.push_back (pid);
+			}
+			size_t pos = column.size();
+			column.resize (pos + rsize);
+			return &column[pos];
+		}
+
+		/** the received records */
+		inline const char * received () const {
+			return inbox.empty() ? NULL : &inbox[0];
+		}
+
+	private:
+		/** synchronization moves records from outboxes to inboxes */
+		friend class ContextImpl;
+
+		Context * owner;						///< the context which sends on this channel
+		size_t rsize;							///< record size
+		std::vector< std::vector<char> > outbox;	///< one column of records per destination pid
+		std::vector<int> destinations;			///< pids with non-empty columns
+		std::vector<char> inbox;				///< records received in the last sync
+		size_t inbox_count;						///< number of records in inbox
+	};
+
+	/** Channel for records of type (Tag, Payload) */
+	template <class Tag, class Payload>
+	class Channel : public ChannelBase {
+	public:
+		struct Record {
+			Tag tag;
+			Payload payload;
+		};
+
+		typedef const Record * const_iterator;
+
+		Channel (Context * _owner) : ChannelBase (_owner, sizeof (Record)) {}
+
+		/** send a record to processor pid */
+		inline void send (int pid, Tag const & tag, Payload const & payload) {
+			Record * r = (Record *) append (pid);
+			r->tag = tag;
+			r->payload = payload;
+		}
+
+		/** first record received in the last sync */
+		inline const_iterator begin () const {
+			return (const_iterator) received ();
+		}
+
+		/** end of the records received in the last sync */
+		inline const_iterator end () const {
+			return begin () + size ();
+		}
+
+		/** access a received record */
+		inline Record const & operator[] (size_t j) const {
+			return begin ()[j];
+		}
+	};
+
+};
+
+#endif // __bsp_Channel_H__
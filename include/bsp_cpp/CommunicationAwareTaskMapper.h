@@ -0,0 +1,137 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file CommunicationAwareTaskMapper.h
+
+Task mapper which places virtual processors that communicate a lot
+on the same node.
+
+Usage:
+
+	bsp::Runner<MyContext, bsp::CommunicationAwareTaskMapper> r (procs);
+
+and in MyContext::run(), after a few representative supersteps:
+
+	get_mapper()->rebalance();
+
+@author Peter Krusche
+*/
+
+#ifndef __CommunicationAwareTaskMapper_H__
+#define __CommunicationAwareTaskMapper_H__
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "TaskMapper.h"
+
+namespace bsp {
+
+	/**
+	 * Task mapper which records how many bytes every pair of virtual 
+	 * processors exchanges via put, get and send, and which partitions
+	 * this communication graph across the nodes when rebalance() is called.
+	 *
+	 * Every node receives the same number of processors as with the
+	 * basic TaskMapper, but processors are grouped to minimize the
+	 * volume which has to go through the global delivery tables.
+	 *
+	 * Only the E pairs of processors which communicated are recorded, 
+	 * exchanged and stored, as adjacency lists. For V virtual processors,
+	 * assign() takes O((V + E) log E) time per refinement pass, for at 
+	 * most max_refine_passes passes, since only processors on the 
+	 * boundary between two parts are considered for swaps.
+	 */
+	class CommunicationAwareTaskMapper : public TaskMapper {
+	public:
+		CommunicationAwareTaskMapper (int _processors,
+			ContextFactoryPtr factory,
+			double _min_gain = 0.05 ) :
+			TaskMapper (_processors, factory), min_gain (_min_gain) {
+			set_measure_comm (true);
+		}
+
+		/**
+		 * Re-partition the communication recorded since the last call
+		 * (node-level collective).
+		 *
+		 * Virtual processors are only moved when this reduces the inter-node
+		 * volume by more than a fraction min_gain.
+		 */
+		void rebalance ();
+
+		/**
+		 * Symmetric communication graph which was used for the last 
+		 * placement: for every pid, the pids it communicated with and 
+		 * the bytes, sorted by pid.
+		 */
+		inline std::vector< std::vector< std::pair<int, double> > > const & get_comm_graph () const {
+			return graph;
+		}
+
+		/** 
+		 * Bytes which are communicated between nodes given a placement
+		 */
+		double internode_volume (std::vector<int> const & nodes) const;
+
+	protected:
+		/**
+		 * Partition the communication graph.
+		 *
+		 * The default implementation grows one part per node greedily
+		 * from the processor with the largest volume, refines the result 
+		 * by swapping processors on the boundaries between parts, and then
+		 * labels the parts to keep as many processors as possible on their
+		 * current node. Refinement stops after max_refine_passes passes, or
+		 * after a pass which reduces the inter-node volume by at most a 
+		 * fraction min_gain.
+		 *
+		 * @param nodes the current node for each pid on input, the new
+		 *        node on output
+		 */
+		virtual void assign (std::vector<int> & nodes);
+
+		/** collect the communication graph from all nodes, and reset
+		 *  the measurements (node-level collective) */
+		void collect_graph ();
+
+		/** bytes communicated between processors i and j */
+		double edge_volume (int i, int j) const;
+
+		/** bytes communicated between processor i and every part it is 
+		 *  connected to, given a part for every processor */
+		void part_volumes (int i, std::vector<int> const & part, 
+			std::map<int, double> & volumes) const;
+
+		/** maximum number of refinement passes in assign() */
+		static const int max_refine_passes = 4;
+
+		/** last measured communication graph (see get_comm_graph()) */
+		std::vector< std::vector< std::pair<int, double> > > graph;
+		double min_gain;			///< minimum relative improvement required for remapping
+	};
+
+};
+
+#endif // __CommunicationAwareTaskMapper_H__
@@ -8,14 +8,47 @@
 
 #include <stdexcept>
 #include <list>
+#include <vector>
+
+#include <string.h>
 
 #include "TaskMapper.h"
+#include "Array.h"
+#include "Accumulate.h"
 #include "Shared/SharedVariable.h"
 #include "Shared/SharedVariableSet.h"
 #include "Shared/SharedArray.h"
 
 namespace bsp {
 
+	class ChannelBase;
+
+	/** A received BSMP message, see Context::bsp_messages */
+	struct Message {
+		int source;				///< pid of the sender
+		const void * tag;		///< the message tag
+		const void * payload;	///< the message payload
+		size_t nbytes;			///< payload size in bytes
+	};
+
+	/** Range of received messages */
+	class MessageRange {
+	public:
+		typedef const Message * const_iterator;
+
+		MessageRange (const Message * _begin, const Message * _end) : 
+			b (_begin), e (_end) {}
+
+		inline const_iterator begin () const { return b; }
+		inline const_iterator end () const { return e; }
+		inline size_t size () const { return (size_t)(e - b); }
+		inline bool empty () const { return b == e; }
+
+	private:
+		const Message * b;
+		const Message * e;
+	};
+
 	/**
 	 * BSP context. Subclass this to run parallel steps.
 	 * 
@@ -44,6 +77,13 @@ namespace bsp {
 		 */
 		inline virtual void init () { }
 
+		/**
+		 * This is called after init() when a context is reused for 
+		 * another run of the same Runner. Override this to release
+		 * state of the previous run which init() does not reset.
+		 */
+		inline virtual void reset () { }
+
 		/**
 		 * BSPWWW interface embedded in context.
 		 */
@@ -51,6 +91,8 @@ namespace bsp {
 		inline int bsp_nprocs() const {
 			if (impl != NULL) { 
 				return mapper->nprocs();
+			} else if (mapper != NULL) {
+				return mapper->nodes();
 			} else {
 				return ::bsp_nprocs();
 			}
@@ -59,11 +101,32 @@ namespace bsp {
 		inline int bsp_pid() const {
 			if (impl != NULL) { 
 				return pid;
+			} else if (mapper != NULL) {
+				return mapper->this_node();
 			} else {
 				return ::bsp_pid();
 			}
 		}
 
+		/** 
+		 * Nesting level of this context: 0 for the outermost runner, 
+		 * k for contexts of a runner nested k levels deep.
+		 * 
+		 * bsp_pid(), bsp_nprocs() and bsp_sync() always refer to the 
+		 * level of the context. Use bsp_enclosing() to get to the level above.
+		 */
+		inline int bsp_level() const {
+			return mapper != NULL ? mapper->get_level() : 0;
+		}
+
+		/**
+		 * For contexts in nested runners: the task-level context on the 
+		 * level above which runs the nested computation. NULL on level 0.
+		 */
+		inline Context * bsp_enclosing() const {
+			return mapper != NULL ? mapper->get_enclosing() : NULL;
+		}
+
 		inline int bsp_local_pid() const {
 			if (impl != NULL) { 
 				return local_pid;
@@ -81,6 +144,17 @@ namespace bsp {
 		 */
 		void bsp_sync();
 
+		/**
+		 * Node-level sync which also tells all nodes whether any of them
+		 * still has virtual processors which are running.
+		 *
+		 * @param running true if this node has running virtual processors
+		 * @param failed if not NULL, true if this node has failed. Set to
+		 *        true if any node has failed, so all nodes can throw together.
+		 * @return true if this or any other node passed running = true
+		 */
+		bool bsp_sync_running(bool running, bool * failed = NULL);
+
 		void bsp_reset_buffers();
 
 		/** @name DRMA */
@@ -89,6 +163,99 @@ namespace bsp {
 		void bsp_pop_reg (const void *);
 		void bsp_put (int, const void *, void *, long int, size_t);
 		void bsp_get (int, const void *, long int, void *, size_t);
+
+		/** Put which does not copy the source when the destination is on 
+		 *  the same node. The source must not change until the next sync,
+		 *  the data is then copied once. */
+		void bsp_put_deferred (int, const void *, void *, long int, size_t);
+
+		/** Strided put and get (see ::bsp_put_strided, ::bsp_get_strided).
+		 *  Blocks for other nodes are sent as a single item. */
+		void bsp_put_strided (int, const void *, long int, void *, long int, long int, size_t, int);
+		void bsp_get_strided (int, const void *, long int, long int, void *, long int, size_t, int);
+
+		/** Put which combines the data with the destination at sync time
+		 *  (see ::bsp_put_accumulate). */
+		void bsp_put_accumulate (int, const void *, void *, long int, size_t, bsp_op_t, bsp_type_t);
+
+		/** Remote fetch-and-op and compare-and-swap on one element (see 
+		 *  ::bsp_fetch_op, ::bsp_cas). Requests for the same node are 
+		 *  executed in the order of the requesting contexts. */
+		void bsp_fetch_op (int, const void *, long int, const void *, void *, bsp_op_t, bsp_type_t);
+		void bsp_cas (int, const void *, long int, const void *, const void *, void *, bsp_type_t);
+		/*@}*/
+
+		/** @name Typed DRMA 
+		 * 
+		 * Puts and gets through registration handles translate addresses
+		 * by registration serial rather than by lookup (see Array.h).
+		 * Offsets and counts are given in elements.
+		 */
+		/*@{*/
+		Registration bsp_push_reg_handle (const void *, size_t);
+		void bsp_put (int, const void *, Registration const &, long int, size_t);
+		void bsp_get (int, Registration const &, long int, void *, size_t);
+
+		/** Enqueue a node-local put of nbytes to a registration, and return 
+		 *  the buffer location to copy the data to before the next DRMA
+		 *  operation. Returns NULL if pid is on a different node. */
+		char * bsp_put_slot (int, Registration const &, long int, size_t);
+
+		/** register count elements starting at data */
+		template <class T> 
+		inline Array<T> bsp_push_array (T * data, size_t count) {
+			return Array<T> (bsp_push_reg_handle (data, count * sizeof(T)), data, count);
+		}
+
+		/** register a single variable */
+		template <class T> 
+		inline Registered<T> bsp_push_var (T & var) {
+			return Registered<T> (bsp_push_reg_handle (&var, sizeof(T)), &var);
+		}
+
+		/** deregister an array or variable */
+		template <class T> 
+		inline void bsp_pop_array (Array<T> const & a) {
+			bsp_pop_reg (a.local());
+		}
+
+		/** put count elements to dst[index...] on pid */
+		template <class T> 
+		inline void put (int pid, const T * src, Array<T> const & dst, size_t index, size_t count = 1) {
+			bsp_put (pid, src, dst.registration(), (long int)(index * sizeof(T)), count * sizeof(T));
+		}
+
+		/** put N elements to dst[index...] on pid. For node-local 
+		 *  destinations, data is buffered using a copy of fixed size. */
+		template <size_t N, class T> 
+		inline void put (int pid, const T * src, Array<T> const & dst, size_t index) {
+			char * slot = bsp_put_slot (pid, dst.registration(), (long int)(index * sizeof(T)), N * sizeof(T));
+			if (slot != NULL) {
+				memcpy (slot, src, N * sizeof(T));
+			} else {
+				bsp_put (pid, src, dst.registration(), (long int)(index * sizeof(T)), N * sizeof(T));
+			}
+		}
+
+		/** put a single value to a registered variable on pid */
+		template <class T> 
+		inline void put (int pid, T const & value, Registered<T> const & dst) {
+			put<1> (pid, &value, dst, 0);
+		}
+
+		/** combine count elements into dst[index...] on pid */
+		template <class T> 
+		inline void accumulate (int pid, const T * src, Array<T> const & dst, size_t index, 
+			bsp_op_t op, size_t count = 1) {
+			bsp_put_accumulate (pid, src, dst.local(), (long int)(index * sizeof(T)), 
+				count * sizeof(T), op, AccumulateType<T>::type);
+		}
+
+		/** get count elements from src[index...] on pid */
+		template <class T> 
+		inline void get (int pid, Array<T> const & src, size_t index, T * dst, size_t count = 1) {
+			bsp_get (pid, src.registration(), (long int)(index * sizeof(T)), dst, count * sizeof(T));
+		}
 		/*@}*/
 
 		/** @name BSMP */
@@ -99,6 +266,25 @@ namespace bsp {
 		void bsp_get_tag (int * , void * );
 		void bsp_move (void *, size_t);
 		void bsp_set_tagsize (size_t *);
+
+		/** Combine messages to the same pid with the same key before 
+		 *  they are sent (see ::bsp_set_combiner). The combiner is not
+		 *  kept when a context is migrated, so it should be set in init().
+		 *  bsp_hpsend does not combine messages.
+		 */
+		void bsp_set_combiner (bsp_combiner_key_fn key, bsp_combiner_fn combine);
+
+		/** Dequeue all messages received in the last superstep, and 
+		 *  iterate over them without copying:
+		 * 
+		 *  	bsp::MessageRange r = bsp_messages();
+		 *  	for (bsp::MessageRange::const_iterator it = r.begin(); it != r.end(); ++it) {
+		 *  		... it->source, it->tag, it->payload, it->nbytes ...
+		 *  	}
+		 * 
+		 *  Messages are valid until the next sync.
+		 */
+		MessageRange bsp_messages ();
 		/*@}*/
 
 		/** @name High Performance */
@@ -208,7 +394,15 @@ namespace bsp {
 		
 		inline void execute_step () {
 			ASSERT (mapper->get_next_step());
-			mapper->get_next_step() (this);
+			NumaBinding binding (mapper->numa_affinity_enabled(), 
+				mapper->numa_affinity_enabled() ? mapper->numa_node(local_pid) : -1);
+			if (mapper->measuring_time()) {
+				double t0 = ::bsp_time();
+				mapper->get_next_step() (this);
+				mapper->add_step_time(local_pid, ::bsp_time() - t0);
+			} else {
+				mapper->get_next_step() (this);
+			}
 		}
 
 		inline void set_task_mapper (TaskMapper * _m) {
@@ -224,7 +418,16 @@ namespace bsp {
 		/************************************************************************/
 		inline void * get_impl() { return impl; }
 
+		/** channels are added when they are constructed (see Channel.h) */
+		inline void add_channel(ChannelBase * c) { channels.push_back (c); }
+
+		/** all channels of this context, in order of construction */
+		inline std::vector<ChannelBase *> & get_channels() { return channels; }
+
 	protected:
+		/** the task mapper relocates contexts when remapping */
+		friend class TaskMapper;
+
 		Context * parentcontext;	///< this is the parent context 		
 		
 		TaskMapper*  mapper;		///< The process mapper object for this context
@@ -237,6 +440,8 @@ namespace bsp {
 	private:
 
 		void * impl;    ///< Implementation specific stuff
+
+		std::vector<ChannelBase *> channels;	///< typed message channels
 	};
 
 	/**
@@ -0,0 +1,281 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file Coroutine.h
+
+Coroutine-based supersteps.
+
+Instead of splitting a computation into supersteps using BSP_BEGIN/BSP_SYNC,
+a context can derive from bsp::CoroutineContext and implement its program
+as a single C++20 coroutine:
+
+	class MyComputation : public bsp::CoroutineContext {
+	public:
+		bsp::Coroutine process () {
+			bsp_push_reg (&x, sizeof(int));
+			co_await bsp_sync ();
+			bsp_put ( (bsp_pid() + 1) % bsp_nprocs(), &y, &x, 0, sizeof(int) );
+			co_await bsp_sync ();
+		}
+		int x, y;
+	};
+
+	bsp::Runner<MyComputation> (procs).run ();
+
+Every virtual processor is a stackless coroutine which is resumed once per
+superstep by the node-level context. Local variables survive bsp_sync(),
+and no task objects are allocated per superstep.
+
+This header is only available when the compiler supports coroutines
+(e.g. g++ -std=c++20).
+
+@author Peter Krusche
+*/
+
+#ifndef __BSP_COROUTINE_H__
+#define __BSP_COROUTINE_H__
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "Context.h"
+#include "TaskMapper.h"
+
+namespace bsp {
+
+	/** Coroutine type for the program of a virtual BSP processor.
+	 *
+	 * Coroutines start suspended and are resumed by CoroutineContext::run.
+	 */
+	class Coroutine {
+	public:
+		struct promise_type {
+			std::exception_ptr exception;
+
+			Coroutine get_return_object () {
+				return Coroutine (std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend () noexcept { return std::suspend_always(); }
+			std::suspend_always final_suspend () noexcept { return std::suspend_always(); }
+
+			void return_void () {}
+
+			void unhandled_exception () {
+				exception = std::current_exception();
+			}
+		};
+
+		Coroutine () {}
+
+		explicit Coroutine (std::coroutine_handle<promise_type> h) : handle (h) {}
+
+		Coroutine (Coroutine && rhs) : handle (rhs.handle) {
+			rhs.handle = nullptr;
+		}
+
+		Coroutine & operator= (Coroutine && rhs) {
+			if (&rhs != this) {
+				destroy();
+				handle = rhs.handle;
+				rhs.handle = nullptr;
+			}
+			return *this;
+		}
+
+		~Coroutine () {
+			destroy();
+		}
+
+		/** true if the coroutine has run to completion (or was never created) */
+		inline bool done () const {
+			return !handle || handle.done();
+		}
+
+		/** run the coroutine until the next bsp_sync() */
+		inline void resume () {
+			if (!done()) {
+				handle.resume();
+			}
+		}
+
+		/** rethrow any exception that escaped from the coroutine body */
+		inline void rethrow () {
+			if (handle && handle.promise().exception) {
+				std::exception_ptr e = handle.promise().exception;
+				handle.promise().exception = nullptr;
+				std::rethrow_exception (e);
+			}
+		}
+
+		/** free the coroutine frame */
+		inline void destroy () {
+			if (handle) {
+				handle.destroy();
+				handle = nullptr;
+			}
+		}
+
+	private:
+		Coroutine (Coroutine const &);
+		Coroutine & operator= (Coroutine const &);
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	/** Awaitable returned by CoroutineContext::bsp_sync.
+	 *
+	 * Awaiting it suspends the virtual processor until the
+	 * node-level context has synchronized all processors.
+	 */
+	struct SyncAwaiter {
+		bool await_ready () const noexcept { return false; }
+		void await_suspend (std::coroutine_handle<>) const noexcept {}
+		void await_resume () const noexcept {}
+	};
+
+	/** Context base class for coroutine-based computations.
+	 *
+	 * Subclasses implement process(), and use co_await bsp_sync()
+	 * to end a superstep.
+	 */
+	class CoroutineContext : public Context {
+	public:
+		/** The program of a single virtual BSP processor */
+		virtual Coroutine process () = 0;
+
+		/** End the current superstep */
+		inline SyncAwaiter bsp_sync () {
+			ASSERT (bsp_is_task_level());
+			return SyncAwaiter();
+		}
+
+		/** Node-level driver: resume all local coroutines superstep by
+		 *  superstep until all virtual processors have finished.
+		 */
+		void run () {
+			ASSERT (bsp_is_node_level());
+			TaskMapper * m = get_mapper();
+			ASSERT (m != NULL);
+
+			int local_procs = m->procs_this_node();
+			for (int lp = 0; lp < local_procs; ++lp) {
+				CoroutineContext * c = context(lp);
+				c->coroutine = c->process();
+			}
+
+			m->set_next_step (&CoroutineContext::resume_step);
+
+			// errors are passed to all nodes in the sync, so all nodes 
+			// throw together
+			std::exception_ptr error;
+			bool mismatch = false;
+			bool running = true;
+			while (running) {
+				if (!mismatch) {
+					tbb::parallel_for (tbb::blocked_range<int> (0, local_procs),
+						ResumeRange(m));
+				}
+
+				int done = 0;
+				for (int lp = 0; lp < local_procs; ++lp) {
+					CoroutineContext * c = context(lp);
+					try {
+						c->coroutine.rethrow();
+					} catch (...) {
+						if (!error) {
+							error = std::current_exception();
+						}
+					}
+					if (c->coroutine.done()) {
+						++done;
+					}
+				}
+
+				if (done > 0 && done < local_procs) {
+					mismatch = true;
+				}
+
+				bool active = done < local_procs;
+				bool failed = error || mismatch;
+				running = bsp_sync_running (active, &failed);
+
+				if (error) {
+					std::rethrow_exception (error);
+				}
+				if (mismatch) {
+					throw std::runtime_error("bsp_sync(): virtual processors executed different numbers of supersteps.");
+				}
+				if (failed) {
+					throw std::runtime_error("bsp_sync(): virtual processors on another node have failed.");
+				}
+
+				// other nodes are still running: they find out at the 
+				// next sync
+				if (running && !active && local_procs > 0) {
+					mismatch = true;
+				}
+			}
+
+			for (int lp = 0; lp < local_procs; ++lp) {
+				context(lp)->coroutine.destroy();
+			}
+		}
+
+	private:
+		inline CoroutineContext * context (int lp) {
+			return static_cast<CoroutineContext*> (get_mapper()->get_context(lp));
+		}
+
+		/** step function which resumes the coroutine of a context */
+		static void resume_step (Context * c) {
+			static_cast<CoroutineContext*> (c)->coroutine.resume();
+		}
+
+		/** parallel_for body which resumes a range of local coroutines */
+		struct ResumeRange {
+			ResumeRange (TaskMapper * _m) : m (_m) {}
+
+			void operator() (tbb::blocked_range<int> const & r) const {
+				for (int lp = r.begin(); lp != r.end(); ++lp) {
+					m->get_context(lp)->execute_step();
+				}
+			}
+
+			TaskMapper * m;
+		};
+
+		Coroutine coroutine;
+	};
+
+};
+
+#endif // __cpp_impl_coroutine
+
+#endif // __BSP_COROUTINE_H__
@@ -0,0 +1,106 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file LoadBalancingTaskMapper.h
+
+Task mapper which moves virtual processors between nodes to balance
+their measured compute time.
+
+Usage:
+
+	bsp::Runner<MyContext, bsp::LoadBalancingTaskMapper> r (procs);
+
+and in MyContext::run(), between two supersteps:
+
+	get_mapper()->rebalance();
+
+@author Peter Krusche
+*/
+
+#ifndef __LoadBalancingTaskMapper_H__
+#define __LoadBalancingTaskMapper_H__
+
+#include <vector>
+
+#include "TaskMapper.h"
+
+namespace bsp {
+
+	/**
+	 * Task mapper which records the compute time of every context
+	 * in every superstep, and which remaps virtual processors when
+	 * rebalance() is called.
+	 *
+	 * Contexts which are moved to a different node keep their shared
+	 * variables (see TaskMapper::remap).
+	 */
+	class LoadBalancingTaskMapper : public TaskMapper {
+	public:
+		LoadBalancingTaskMapper (int _processors,
+			ContextFactoryPtr factory,
+			double _min_gain = 0.05 ) :
+			TaskMapper (_processors, factory), min_gain (_min_gain) {
+			set_measure_time (true);
+		}
+
+		/**
+		 * Balance the compute time measured since the last call
+		 * (node-level collective).
+		 *
+		 * Virtual processors are only moved when this reduces the maximum
+		 * node load by more than a fraction min_gain.
+		 */
+		void rebalance ();
+
+		/**
+		 * Compute time per global pid which was used for the last
+		 * rebalancing.
+		 */
+		inline std::vector<double> const & get_load () const {
+			return load;
+		}
+
+	protected:
+		/**
+		 * Assign processors to nodes given their load.
+		 *
+		 * The default implementation is greedy (longest processing
+		 * time first), and prefers the current node on ties.
+		 *
+		 * @param load the load of each global pid
+		 * @param nodes the current node for each pid on input, the new
+		 *        node on output
+		 */
+		virtual void assign (std::vector<double> const & load, std::vector<int> & nodes);
+
+		/** collect the load per global pid from all nodes, and reset
+		 *  the time measurements (node-level collective) */
+		void collect_load ();
+
+		std::vector<double> load;	///< last measured load per global pid
+		double min_gain;			///< minimum relative improvement required for remapping
+	};
+
+};
+
+#endif // __LoadBalancingTaskMapper_H__
@@ -0,0 +1,74 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file NestedTaskMapper.h
+
+Task mapper for nested (multi-level) BSP computations.
+
+A task-level context can run a nested computation on a subset of the 
+machine, e.g. node -> socket -> core:
+
+	class Inner : public bsp::Context { ... };
+
+	class Outer : public bsp::Context {
+		void run () {
+			BSP_SCOPE(Outer);
+			BSP_BEGIN();
+			bsp::Runner<Inner, bsp::NestedTaskMapper> r (this, 8);
+			r.run ();
+			BSP_END();
+		}
+	};
+
+Supersteps of the inner computation only synchronize its own processors
+through shared memory; only supersteps of the outer level communicate 
+between nodes.
+
+@author Peter Krusche
+*/
+
+#ifndef __NestedTaskMapper_H__
+#define __NestedTaskMapper_H__
+
+#include "TaskMapper.h"
+
+namespace bsp {
+
+	/**
+	 * Node-local task mapper: all contexts live on the calling node, and
+	 * bsp_sync(), registrations and shared variables work without 
+	 * communication.
+	 *
+	 * Shared variables are initialized from and reduced into the nested 
+	 * Runner object. Copying them to shared variables of the enclosing 
+	 * context passes them on to the next level.
+	 */
+	class NestedTaskMapper : public TaskMapper {
+	public:
+		NestedTaskMapper (int _processors, ContextFactoryPtr factory) :
+			TaskMapper (_processors, factory, false, true) {}
+	};
+
+};
+
+#endif // __NestedTaskMapper_H__
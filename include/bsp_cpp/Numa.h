@@ -0,0 +1,130 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file Numa.h
+
+NUMA topology discovery and thread binding.
+
+The topology is read from sysfs (/sys/devices/system/node) on Linux, and
+restricted to the CPUs this process may run on. On other systems, or when
+sysfs is not available, all CPUs are reported as a single NUMA node and
+binding threads has no effect.
+
+@author Peter Krusche
+*/
+
+#ifndef __BSP_NUMA_H__
+#define __BSP_NUMA_H__
+
+#include <vector>
+
+namespace bsp {
+
+	/** NUMA nodes and their CPUs */
+	class NumaTopology {
+	public:
+		/** Get the topology of this machine (discovered on first call) */
+		static NumaTopology const & get ();
+
+		/** number of NUMA nodes which have CPUs we can use */
+		inline int nodes () const {
+			return (int)node_cpus.size();
+		}
+
+		/** the CPUs on a NUMA node */
+		inline std::vector<int> const & cpus (int node) const {
+			return node_cpus[node];
+		}
+
+		/** total number of CPUs we can use */
+		inline int total_cpus () const {
+			return ncpus;
+		}
+
+		/** 
+		 * Assign NUMA nodes to n consecutive local processors.
+		 * 
+		 * Processors are distributed in proportion to the number of 
+		 * CPUs on every node, and consecutive processors share a node.
+		 */
+		void distribute (int n, std::vector<int> & nodes) const;
+
+	private:
+		NumaTopology ();
+
+		std::vector< std::vector<int> > node_cpus;
+		int ncpus;
+	};
+
+	/** 
+	 * Bind the calling thread to the CPUs of a NUMA node. 
+	 * 
+	 * The last binding is remembered per thread, so calling this 
+	 * repeatedly with the same node is cheap.
+	 */
+	void numa_bind_thread (int node);
+
+	/** Allow the calling thread to run on all CPUs of the process again */
+	void numa_unbind_thread ();
+
+	/** The NUMA node the calling thread is bound to, or -1 */
+	int numa_bound_node ();
+
+	/** 
+	 * Binds the calling thread to a NUMA node while it exists, and 
+	 * restores the previous binding when it is destroyed. TBB workers 
+	 * run steps of contexts on different nodes, and other work between 
+	 * them.
+	 */
+	class NumaBinding {
+	public:
+		/** bind to node if enabled is true, otherwise do nothing */
+		NumaBinding (bool _enabled, int node) : 
+			enabled (_enabled), previous (numa_bound_node()) {
+			if (enabled) {
+				numa_bind_thread (node);
+			}
+		}
+
+		~NumaBinding () {
+			if (!enabled) {
+				return;
+			}
+			if (previous < 0) {
+				numa_unbind_thread ();
+			} else {
+				numa_bind_thread (previous);
+			}
+		}
+
+	private:
+		NumaBinding (NumaBinding const &);
+		NumaBinding & operator= (NumaBinding const &);
+
+		bool enabled;
+		int previous;
+	};
+
+};
+
+#endif // __BSP_NUMA_H__
@@ -0,0 +1,60 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file NumaTaskMapper.h
+
+Task mapper which binds contexts to NUMA nodes.
+
+Usage:
+
+	bsp::Runner<MyContext, bsp::NumaTaskMapper> r (procs);
+
+@author Peter Krusche
+*/
+
+#ifndef __NumaTaskMapper_H__
+#define __NumaTaskMapper_H__
+
+#include "TaskMapper.h"
+
+namespace bsp {
+
+	/**
+	 * Task mapper with NUMA affinity.
+	 *
+	 * Consecutive local processors are placed on the same NUMA node 
+	 * (see NumaTopology::distribute). Each context is created by a thread 
+	 * bound to its NUMA node, so memory allocated in its constructor or 
+	 * init() is first touched there, and every superstep of the context 
+	 * executes on a thread bound to the same node. This includes buffers 
+	 * allocated by the context's local delivery queue.
+	 */
+	class NumaTaskMapper : public TaskMapper {
+	public:
+		NumaTaskMapper (int _processors, ContextFactoryPtr factory) :
+			TaskMapper (_processors, factory, true) {}
+	};
+
+};
+
+#endif // __NumaTaskMapper_H__
@@ -79,6 +79,22 @@ namespace bsp {
 	};
 
 
+	/** Run a superstep on all contexts in a task mapper 
+	 *  (called at node level) */
+	inline void execute_superstep (TaskMapper * mapper) {
+		if (mapper->procs_this_node() > 1) {
+			ComputationSpawnTask & root = *new( tbb::task::allocate_root() ) 
+				ComputationSpawnTask ( mapper );
+
+			tbb::task::spawn_root_and_wait (root);
+		} else if (mapper->procs_this_node() == 1) {
+			// only one process? don't bother with tbb!
+			for(int k = 0; k < mapper->procs_this_node(); ++k) {
+				mapper->get_context(k)->execute_step();
+			}
+		} 
+	}
+
 	/** BSP Computation runner.
 	 * 
 	 * Given a BSP computation defined in class _context, this runner will set
@@ -88,17 +104,26 @@ namespace bsp {
 	 * by default, this is assumed to be the number of MPI processes times TBB's 
 	 * default number of threads.
 	 * 
+	 * The task mapper class can be given as a second template parameter
+	 * (e.g. bsp::LoadBalancingTaskMapper).
+	 * 
+	 * A runner can be run repeatedly. The task mapper and all contexts are
+	 * kept alive between runs, and their communication buffers are retained.
+	 * Before every run but the first, each context's init() and reset() 
+	 * are called.
+	 * 
 	 */
-	template <class _context>
+	template <class _context, class _mapper = TaskMapper>
 	class Runner : public _context {
 	public:
 		typedef _context bsp_context_t;
+		typedef _mapper mapper_t;
 
 		/** Create a runner
 		 * 
 		 * @param processors The number of processors (optional)
 		 */
-		Runner (int processors = -1)  {
+		Runner (int processors = -1) : runs (0) {
 			// automatic number of processors
 			if (processors < 0) {
 				processors = tbb::task_scheduler_init::default_num_threads() * ::bsp_nprocs();
@@ -107,7 +132,29 @@ namespace bsp {
 			factory = ContextFactoryPtr (
 				new ContextFactory< bsp_context_t >
 				(this) );
-			_context::set_task_mapper ( new bsp::TaskMapper (processors, factory) );
+			_context::set_task_mapper ( new mapper_t (processors, factory) );
+		}
+
+		/** Create a nested runner inside a task-level context.
+		 * 
+		 * The runner's supersteps synchronize only the processors it 
+		 * creates, without any communication between nodes. Use a 
+		 * node-local task mapper like bsp::NestedTaskMapper.
+		 * 
+		 * @param enclosing the task-level context which runs the computation
+		 * @param processors the number of processors to run on this level
+		 */
+		Runner ( Context * enclosing, int processors ) : runs (0) {
+			factory = ContextFactoryPtr (
+				new ContextFactory< bsp_context_t >
+				(this) );
+			_context::set_task_mapper ( new mapper_t (processors, factory) );
+			try {
+				_context::get_mapper()->set_enclosing (enclosing);
+			} catch (...) {
+				delete _context::get_mapper();
+				throw;
+			}
 		}
 
 		/** Destructor: destroy task mapper */
@@ -122,6 +169,9 @@ namespace bsp {
 
 			try {
 				_context::parentcontext = this;
+				if (runs++ > 0) {
+					_context::get_mapper()->reset_contexts ();
+				}
 				this->initialize_shared ( master_node );
 
 				bsp_context_t::run();
@@ -137,22 +187,12 @@ namespace bsp {
 		 */ 
 		void execute () {
 			ASSERT (this->bsp_is_node_level());
-
-			if (_context::mapper->procs_this_node() > 1) {
-				ComputationSpawnTask & root = *new( tbb::task::allocate_root() ) 
-					ComputationSpawnTask ( _context::mapper );
-
-				tbb::task::spawn_root_and_wait (root);
-			} else if (_context::mapper->procs_this_node() == 1) {
-				// only one process? don't bother with tbb!
-				for(int k = 0; k < _context::mapper->procs_this_node(); ++k) {
-					_context::mapper->get_context(k)->execute_step();
-				}
-			} 
+			execute_superstep (_context::mapper);
 		}
 
 	protected:
 		ContextFactoryPtr factory;
+		int runs;	///< number of times run() was called
 	};
 
 };
@@ -172,8 +212,7 @@ namespace bsp {
 		}												\
 	};													\
 	get_mapper()->set_next_step(&__R::runme);			\
-	dynamic_cast<bsp::Runner<bsp_context_t>*>(			\
-		get_parent_context())->execute();				\
+	bsp::execute_superstep(get_mapper());				\
 	bsp_sync();											\
 }
 
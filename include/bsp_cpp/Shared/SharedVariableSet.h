@@ -125,6 +125,15 @@ namespace bsp {
 		 */
 		void reduce_all(TaskMapper * _mapper);
 
+		/** @name Serialization of all variables 
+		 *  These are used to move a context's state to a different node.
+		 */
+		/*@{*/
+		size_t serialized_size_all ();
+		void serialize_all (void * target, size_t nbytes);
+		void deserialize_all (void * source, size_t nbytes);
+		/*@}*/
+
 		/** Function to add a shared variable to a SharedVariableSet
 		 *  for initialisation only.
 		 *  This is a friend function so we can keep SharedVariableSet 
@@ -6,6 +6,7 @@
 #define TaskMapper_h__
 
 #include <algorithm>
+#include <map>
 #include <vector>
 
 #include <setjmp.h>
@@ -15,6 +16,8 @@
 #include "bsp.h"
 #include "bsp_tools/utilities.h"
 
+#include "Numa.h"
+
 namespace bsp {
 
 	class TaskMapper;
@@ -61,46 +64,40 @@ namespace bsp {
 	 */
 	class TaskMapper {
 	public:
+		/**
+		 * Create a mapper and all local contexts.
+		 * 
+		 * @param _processors the number of virtual processors
+		 * @param factory the factory for creating contexts
+		 * @param _numa_affinity bind contexts to NUMA nodes (see NumaTaskMapper)
+		 * @param _node_local place all contexts on this node and synchronize
+		 *        them without communication (see NestedTaskMapper)
+		 */
 		TaskMapper (int _processors, 
-			ContextFactoryPtr factory
+			ContextFactoryPtr factory,
+			bool _numa_affinity = false,
+			bool _node_local = false
 		) : contextfactory(factory), step(NULL),
-			processors (_processors) {
+			processors (_processors), measure_time (false), measure_comm (false),
+			node_local (_node_local), level (0), enclosing (NULL),
+			numa_affinity (_numa_affinity) {
 			using namespace std;
 
 			where_is_node = new int [processors];
 			where_is_local = new int [processors];
 			where_is_local_here = new int [processors];
 			
-			procs_on_node = new int [::bsp_nprocs()];
-			memset(procs_on_node, 0, sizeof(int) * ::bsp_nprocs());
-
-			int my_node = ::bsp_pid();
-			procs_on_this_node = 0;
-			max_procs_per_node = 0;
-			for (int p = 0; p < processors; ++p) {
-				int n;
-				int lp;
-				where_is(processors, p, n, lp);
-				where_is_node[p] = n;
-				where_is_local[p] = lp;
-				++procs_on_node[n];
-				max_procs_per_node = max(max_procs_per_node, procs_on_node[n]);
+			node_count = node_local ? 1 : ::bsp_nprocs();
+			node_rank = node_local ? 0 : ::bsp_pid();
 
-				if (n == my_node) {
-					where_is_local_here[p] = lp;
-					++procs_on_this_node;
-				} else {
-					where_is_local_here[p] = -1;
-				}
-			}
+			procs_on_node = new int [node_count];
+			which_global = NULL;
 
-			which_global = new int [bsp_nprocs() * max_procs_per_node];
-			memset(which_global, -1, sizeof(int) * (bsp_nprocs() * max_procs_per_node));
+			std::vector<int> nodes (processors), local_pids (processors);
 			for (int p = 0; p < processors; ++p) {
-				int n = where_is_node[p];
-				int lp = where_is_local[p];
-				which_global[n*max_procs_per_node + lp] = p;
+				where_is(processors, p, nodes[p], local_pids[p]);
 			}
+			build_tables (nodes, local_pids);
 
 			// we create at least one context. We might not use this context,
 			// but the context implementation must need to be called at least
@@ -108,8 +105,9 @@ namespace bsp {
 			using namespace std;
 			context_store.resize( procs_on_this_node );
 			for (int i = 0, i_end = (int)context_store.size(); i < i_end; ++i ) {
-				context_store[i] = factory->create( this, local_to_global_pid(i) );
+				context_store[i] = create_context( local_to_global_pid(i) );
 			}
+			step_times.resize( procs_on_this_node, 0 );
 		}
 
 		virtual ~TaskMapper () {
@@ -123,6 +121,24 @@ namespace bsp {
 			delete [] which_global;
 		}
 
+		/**
+		 * Prepare all local contexts for another run (node-level).
+		 * 
+		 * Registrations and queued communication are discarded, delivery 
+		 * buffers are kept, and every context's init() and reset() are 
+		 * called. All registrations should have been popped at the end of
+		 * the previous run.
+		 */
+		void reset_contexts ();
+
+		/**
+		 * Re-run the placement of virtual processors (node-level collective).
+		 * 
+		 * Must be called between supersteps. The basic mapper places
+		 * processors statically, so this does nothing.
+		 */
+		virtual void rebalance () {}
+
 		/**
 		 * Number of processors in this mapper
 		 */
@@ -131,6 +147,23 @@ namespace bsp {
 			return processors;
 		}
 
+		/**
+		 * Number of nodes the processors are distributed across
+		 * (1 for node-local mappers)
+		 */
+
+		inline int nodes () const {
+			return node_count;
+		}
+
+		/**
+		 * Index of this node
+		 */
+
+		inline int this_node () const {
+			return node_rank;
+		}
+
 		/**
 		 * Number of maximum processors per node
 		 */
@@ -152,7 +185,7 @@ namespace bsp {
 		 */
 
 		inline int local_to_global_pid(int local_pid) const {
-			return which_global[max_procs_per_node * ::bsp_pid() + local_pid];
+			return which_global[max_procs_per_node * node_rank + local_pid];
 		}
 
 
@@ -203,22 +236,176 @@ namespace bsp {
 			return step;
 		}
 
+		/** Implementation specific data which is shared by all contexts 
+		 *  on this node */
+		inline boost::shared_ptr<void> & get_node_impl () {
+			return node_impl;
+		}
+
+		/** @name Superstep time measurement */
+		/*@{*/
+		/** true if contexts should report their superstep compute time */
+		inline bool measuring_time () const {
+			return measure_time;
+		}
+
+		/** add compute time for a local context. Each context only 
+		 *  writes its own entry, so this needs no locking. */
+		inline void add_step_time (int local_pid, double t) {
+			step_times[local_pid] += t;
+		}
+		/*@}*/
+
+		/** @name Nesting */
+		/*@{*/
+		/** true if all contexts are on this node, and synchronization 
+		 *  needs no communication */
+		inline bool is_node_local () const {
+			return node_local;
+		}
+
+		/** the nesting level: 0 for the outermost mapper */
+		inline int get_level () const {
+			return level;
+		}
+
+		/** the task-level context which runs this mapper's computation,
+		 *  NULL for the outermost mapper */
+		inline Context * get_enclosing () const {
+			return enclosing;
+		}
+
+		/** nest this mapper inside a task-level context */
+		void set_enclosing (Context * c);
+		/*@}*/
+
+		/** @name NUMA affinity */
+		/*@{*/
+		/** true if contexts are bound to NUMA nodes */
+		inline bool numa_affinity_enabled () const {
+			return numa_affinity;
+		}
+
+		/** the NUMA node a local context is bound to */
+		inline int numa_node (int local_pid) const {
+			return numa_nodes[local_pid];
+		}
+		/*@}*/
+
+		/** @name Communication volume measurement */
+		/*@{*/
+		/** true if contexts should report the bytes they communicate */
+		inline bool measuring_comm () const {
+			return measure_comm;
+		}
+
+		/** add communication volume between a local context and a global pid */
+		inline void add_comm_bytes (int local_pid, int global_pid, size_t nbytes) {
+			comm_bytes[local_pid][global_pid] += (double) nbytes;
+		}
+		/*@}*/
+
 	protected:
 		/** 
 		 * Find out where a given global processor context is held. 
 		 */
 		virtual void where_is (int processors, int global_pid, int & node, int & local_pid) {
-			int mppn = ICD (processors, ::bsp_nprocs());
+			int mppn = ICD (processors, node_count);
 
 			node = global_pid / mppn;
 			local_pid = global_pid - node * mppn;
 		}
 
+		/** 
+		 * Move virtual processors to different nodes (node-level collective).
+		 * 
+		 * Contexts which change node are destroyed on their old node and 
+		 * re-created on the new one. Their shared variables 
+		 * (see CONTEXT_SHARED_INIT) are transferred using the 
+		 * ByteSerializable interface, all other state is re-initialized
+		 * through init(). Migrating contexts must not have any registered
+		 * memory or unread messages.
+		 * 
+		 * @param nodes the new node for every global pid (must be the same on all nodes)
+		 */
+		void remap (std::vector<int> const & nodes);
+
+		/** switch superstep time measurement on or off */
+		inline void set_measure_time (bool m) {
+			measure_time = m;
+		}
+
+		/** switch communication volume measurement on or off */
+		inline void set_measure_comm (bool m) {
+			measure_comm = m;
+			comm_bytes.assign (m ? procs_on_this_node : 0, std::map<int, double> ());
+		}
+
+		/** accumulated compute time of all local contexts */
+		std::vector<double> step_times;
+
+		/** bytes communicated by every local context, for every global pid
+		 *  it has communicated with */
+		std::vector< std::map<int, double> > comm_bytes;
+
 	private:
+		/**
+		 * Create the context for a global pid which is located on this node.
+		 * With NUMA affinity, the calling thread is bound to the context's 
+		 * NUMA node while it is created, so the context's memory is first 
+		 * touched there. 
+		 */
+		inline Context * create_context (int global_pid) {
+			NumaBinding binding (numa_affinity, 
+				numa_affinity ? numa_nodes[where_is_local_here[global_pid]] : -1);
+			return contextfactory->create( this, global_pid );
+		}
+
+		/** 
+		 * Build location tables from a node and local pid assignment
+		 */
+		void build_tables (std::vector<int> const & nodes, std::vector<int> const & local_pids) {
+			using namespace std;
+			memset(procs_on_node, 0, sizeof(int) * node_count);
+
+			int my_node = node_rank;
+			procs_on_this_node = 0;
+			max_procs_per_node = 0;
+			for (int p = 0; p < processors; ++p) {
+				int n = nodes[p];
+				int lp = local_pids[p];
+				where_is_node[p] = n;
+				where_is_local[p] = lp;
+				++procs_on_node[n];
+				max_procs_per_node = max(max_procs_per_node, procs_on_node[n]);
+
+				if (n == my_node) {
+					where_is_local_here[p] = lp;
+					++procs_on_this_node;
+				} else {
+					where_is_local_here[p] = -1;
+				}
+			}
+
+			delete [] which_global;
+			which_global = new int [node_count * max_procs_per_node];
+			memset(which_global, -1, sizeof(int) * (node_count * max_procs_per_node));
+			for (int p = 0; p < processors; ++p) {
+				int n = where_is_node[p];
+				int lp = where_is_local[p];
+				which_global[n*max_procs_per_node + lp] = p;
+			}
+
+			if (numa_affinity) {
+				NumaTopology::get().distribute (procs_on_this_node, numa_nodes);
+			}
+		}
+
 		CONTEXTRUNNER step;
 
 		std::vector<Context *> context_store;
 		ContextFactoryPtr contextfactory;
+		boost::shared_ptr<void> node_impl;
 
 		int * where_is_node;		///< which node contains logical processor p
 		int * where_is_local;		///< which context contains logical processor p
@@ -229,6 +416,19 @@ namespace bsp {
 		int processors;				///< overall number of logical processors
 		int procs_on_this_node;		///< how many logical processors on our node
 		int max_procs_per_node;		///< max over procs_on_node
+
+		bool measure_time;			///< true if superstep times are recorded
+		bool measure_comm;			///< true if communication volumes are recorded
+
+		int node_count;				///< number of nodes
+		int node_rank;				///< index of this node
+
+		bool node_local;			///< true if all contexts are on this node
+		int level;					///< nesting level
+		Context * enclosing;		///< enclosing task-level context for nested mappers
+
+		bool numa_affinity;			///< true if contexts are bound to NUMA nodes
+		std::vector<int> numa_nodes;	///< NUMA node for every local context
 	};
 
 };
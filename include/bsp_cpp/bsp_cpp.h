@@ -20,7 +20,14 @@
 
 #include "bsp_commandline.h"
 #include "TaskMapper.h"
+#include "LoadBalancingTaskMapper.h"
+#include "CommunicationAwareTaskMapper.h"
+#include "NumaTaskMapper.h"
+#include "NestedTaskMapper.h"
+#include "Array.h"
 #include "Context.h"
 #include "Runner.h"
+#include "Channel.h"
+#include "Coroutine.h"
 
 #endif
@@ -49,6 +49,14 @@ public:
 
 	/** buffer a data block, expand storage vector if necessary */
 	inline size_t buffer (const void * src, size_t nbytes) {
+		size_t pos = reserve (nbytes);
+		memcpy ((char*)(storage.data + pos), src, nbytes);
+		return pos;
+	}
+
+	/** reserve space for a data block which is written by the caller
+	 *  using get_writable (offset). */
+	inline size_t reserve (size_t nbytes) {
 		size_t pos = storage_end;
 		// this relies on the fact that double variables are 8 bytes long. as they should be.
 		ASSERT (sizeof(double) == 8);
@@ -58,7 +66,6 @@ public:
 			s = storage_end + BSP_DELIVTAB_MIN_SIZE + 1;
 			storage.resize(s);
 		}
-		memcpy ((char*)(storage.data + pos), src, nbytes);
 		return pos;
 	}
 
@@ -67,6 +74,12 @@ public:
 		return storage.data + offset;
 	}
 
+	/** get a buffered data block start for writing. This is only 
+	 *  valid until the next call to buffer or reserve. */
+	inline void * get_writable (size_t offset) {
+		return storage.data + offset;
+	}
+
 	/** get the size of this buffer */
 	inline size_t size () {
 		return storage.exact_size() * sizeof (double);
@@ -78,6 +91,11 @@ public:
 		storage_end = 0;
 	}
 
+	/** empty the buffer, but keep its memory */
+	inline void rewind() {
+		storage_end = 0;
+	}
+
 private:
 	storagevector storage;
 	size_t storage_end;
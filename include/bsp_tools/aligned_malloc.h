@@ -26,7 +26,7 @@
 #include <stdlib.h>
 
 static inline void *aligned_malloc(size_t size, int alignment) {
-	char *block = malloc(size + 2*alignment + 4);
+	char *block = (char *) malloc(size + 2*alignment + 4);
 
 	char** aligned = (char**)(((size_t)block + alignment + sizeof(char*)) & (~(alignment-1)));
 	aligned[-1] = block;
@@ -0,0 +1,134 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_accumulate.c
+
+Implements the reduction kernels. The loops work on non-aliasing typed 
+arrays, so the compiler can vectorize them.
+
+@author Peter Krusche
+*/
+
+#include <string.h>
+
+#include "bsp_accumulate.h"
+#include "bsp_abort.h"
+
+/** a reduction kernel */
+typedef void (*AccumulateKernel) (char * RESTRICT, const char * RESTRICT, size_t);
+
+#define ACCUMULATE_KERNEL(name, T, expr) \
+	static void name (char * RESTRICT dst, const char * RESTRICT src, size_t nbytes) \
+	{ \
+		T * RESTRICT a = (T *) dst; \
+		const T * RESTRICT b = (const T *) src; \
+		size_t i, n = nbytes / sizeof(T); \
+		for (i = 0; i < n; i++) \
+			a[i] = (expr); \
+	}
+
+#define ACCUMULATE_ARITHMETIC(T) \
+	ACCUMULATE_KERNEL(sum_##T, T, a[i] + b[i]) \
+	ACCUMULATE_KERNEL(min_##T, T, b[i] < a[i] ? b[i] : a[i]) \
+	ACCUMULATE_KERNEL(max_##T, T, b[i] > a[i] ? b[i] : a[i])
+
+#define ACCUMULATE_BITWISE(T) \
+	ACCUMULATE_KERNEL(band_##T, T, a[i] & b[i]) \
+	ACCUMULATE_KERNEL(bor_##T, T, a[i] | b[i]) \
+	ACCUMULATE_KERNEL(bxor_##T, T, a[i] ^ b[i])
+
+ACCUMULATE_ARITHMETIC(int)
+ACCUMULATE_ARITHMETIC(long)
+ACCUMULATE_ARITHMETIC(float)
+ACCUMULATE_ARITHMETIC(double)
+ACCUMULATE_BITWISE(int)
+ACCUMULATE_BITWISE(long)
+
+/** built-in kernels by operation and type (see bsp_op_t and bsp_type_t) */
+static const AccumulateKernel kernels[bsp_op_user][4] = 
+{
+	{ sum_int, sum_long, sum_float, sum_double },
+	{ min_int, min_long, min_float, min_double },
+	{ max_int, max_long, max_float, max_double },
+	{ band_int, band_long, NULL, NULL },
+	{ bor_int, bor_long, NULL, NULL },
+	{ bxor_int, bxor_long, NULL, NULL },
+};
+
+/** user-defined operations, in the order of registration */
+static bsp_accumulate_fn user_ops[BSP_MAX_USER_OPS];
+static unsigned int user_op_count = 0;
+
+int 
+	accumulate_valid (const unsigned int op, const unsigned int type)
+{
+	if (op >= bsp_op_user)
+		return op - bsp_op_user < user_op_count;
+	return type <= bsp_type_double && kernels[op][type] != NULL;
+}
+
+void 
+	accumulate_apply (char * RESTRICT dst, const char * RESTRICT src, 
+	const size_t nbytes, const unsigned int op, const unsigned int type)
+{
+	if (op >= bsp_op_user)
+		user_ops[op - bsp_op_user] (dst, src, nbytes);
+	else
+		kernels[op][type] (dst, src, nbytes);
+}
+
+size_t 
+	accumulate_type_size (const unsigned int type)
+{
+	switch (type)
+	{
+	case bsp_type_int: return sizeof(int);
+	case bsp_type_long: return sizeof(long);
+	case bsp_type_float: return sizeof(float);
+	case bsp_type_double: return sizeof(double);
+	default: return 0;
+	}
+}
+
+void 
+	accumulate_fetch (char * RESTRICT target, char * RESTRICT result, 
+	const char * RESTRICT operand, const char * RESTRICT compare, 
+	const size_t nbytes, const unsigned int op, const unsigned int type)
+{
+	memcpy (result, target, nbytes);
+	if (op == BSP_OP_CAS)
+	{
+		if (memcmp (target, compare, nbytes) == 0)
+			memcpy (target, operand, nbytes);
+	}
+	else
+		accumulate_apply (target, operand, nbytes, op, type);
+}
+
+bsp_op_t 
+	accumulate_register (bsp_accumulate_fn fn)
+{
+	if (user_op_count == BSP_MAX_USER_OPS)
+		bsp_intern_abort (ERR_INVALID_OPERATION, __func__, __FILE__, __LINE__);
+	user_ops[user_op_count] = fn;
+	return (bsp_op_t) (bsp_op_user + user_op_count++);
+}
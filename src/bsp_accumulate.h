@@ -0,0 +1,74 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_accumulate.h
+
+Reduction kernels for bsp_put_accumulate() and bsp_fetch_op(). Built-in operations are 
+looked up in a table by operation and element type, user-defined 
+operations are registered in the same order on all processors so their
+numbers agree.
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_ACCUMULATE_H
+#define BSP_ACCUMULATE_H
+
+#include "bsp.h"
+#include "bsp_config.h"
+
+/** maximum number of user-defined operations */
+#define BSP_MAX_USER_OPS 64
+
+/** operation number of compare-and-swap requests (see accumulate_fetch()) */
+#define BSP_OP_CAS 0xFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** returns 1 if an operation is defined for an element type */
+int accumulate_valid (const unsigned int op, const unsigned int type);
+
+/** combine nbytes of src into dst using an operation (which must be valid 
+ *  for the element type) */
+void accumulate_apply (char * RESTRICT dst, const char * RESTRICT src, 
+	const size_t nbytes, const unsigned int op, const unsigned int type);
+
+/** size of an element type in bytes, or 0 if the type is invalid */
+size_t accumulate_type_size (const unsigned int type);
+
+/** fetch an element from target to result, and combine operand into 
+ *  target. If op is BSP_OP_CAS, replace target with operand if it is 
+ *  bitwise equal to compare instead. */
+void accumulate_fetch (char * RESTRICT target, char * RESTRICT result, 
+	const char * RESTRICT operand, const char * RESTRICT compare, 
+	const size_t nbytes, const unsigned int op, const unsigned int type);
+
+/** register a user-defined operation, and return its number */
+bsp_op_t accumulate_register (bsp_accumulate_fn fn);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
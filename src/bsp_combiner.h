@@ -0,0 +1,208 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_combiner.h
+Defines CombinerTable, which finds messages sent in the current superstep 
+by destination and key, so further messages with the same key can be 
+combined into them before they are communicated.
+
+Every destination has a separate hash table (open addressing, linear
+probing) which maps keys to the location of the buffered message. The 
+meaning of locations is up to the caller (e.g. an offset in a column of 
+a DeliveryTable). All tables are cleared in every bsp_sync().
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_COMBINER_H
+#define BSP_COMBINER_H
+
+#include <string.h>
+
+#include "bsp.h"
+#include "bsp_config.h"
+#include "bsp_alloc.h"
+
+/** Messages with the same key to one destination */
+typedef struct
+{
+	unsigned int capacity;	/**< number of hash slots (0 or a power of two) */
+	unsigned int count;		/**< number of used slots */
+	long * RESTRICT keys;	/**< keys, or -1 for empty slots */
+	size_t * RESTRICT locations;	/**< location of the buffered message */
+	size_t * RESTRICT sizes;		/**< payload size of the buffered message */
+} CombinerColumn;
+
+/** Combiner state of a sender */
+typedef struct
+{
+	bsp_combiner_key_fn key;		/**< key extractor, NULL if no combiner is set */
+	bsp_combiner_fn combine;		/**< combine function */
+	unsigned int ncolumns;			/**< number of destinations */
+	CombinerColumn * RESTRICT columns;
+	unsigned long combined;			/**< number of messages combined so far */
+} CombinerTable;
+
+/** initializes a CombinerTable 
+@param table Reference to a CombinerTable
+@param ncolumns number of destinations
+*/
+static inline void
+	combinerTable_initialize (CombinerTable * RESTRICT table, const unsigned int ncolumns)
+{
+	table->key = NULL;
+	table->combine = NULL;
+	table->ncolumns = ncolumns;
+	table->columns = (CombinerColumn *) bsp_calloc (ncolumns, sizeof(CombinerColumn));
+	table->combined = 0;
+}
+
+/** frees memory taken by a CombinerTable 
+@param table Reference to a CombinerTable
+*/
+static inline void
+	combinerTable_destruct (CombinerTable * RESTRICT table)
+{
+	unsigned int c;
+	for (c = 0; c < table->ncolumns; c++)
+	{
+		bsp_free (table->columns[c].keys);
+		bsp_free (table->columns[c].locations);
+		bsp_free (table->columns[c].sizes);
+	}
+	bsp_free (table->columns);
+}
+
+/** forget all buffered messages (but keep the memory of all tables)
+@param table Reference to a CombinerTable
+*/
+static inline void
+	combinerTable_reset (CombinerTable * RESTRICT table)
+{
+	unsigned int c;
+	for (c = 0; c < table->ncolumns; c++)
+	{
+		CombinerColumn * RESTRICT col = table->columns + c;
+		if (col->count > 0)
+		{
+			memset (col->keys, -1, col->capacity * sizeof(long));
+			col->count = 0;
+		}
+	}
+}
+
+/** hash slot for a key */
+static inline unsigned int
+	combinerColumn_slot (const long key, const unsigned int capacity)
+{
+	unsigned long h = (unsigned long) key;
+	h ^= h >> 16;
+	h *= 0x45d9f3bUL;
+	h ^= h >> 16;
+	return (unsigned int) (h & (capacity - 1));
+}
+
+/** find a buffered message 
+@param table Reference to a CombinerTable
+@param column destination 
+@param key message key
+@param nbytes payload size 
+@param location set to the location of the buffered message if found
+@return 1 if a message with the same key and size was found, 0 otherwise
+*/
+static inline int
+	combinerTable_find (const CombinerTable * RESTRICT table, const unsigned int column, 
+	const long key, const size_t nbytes, size_t * RESTRICT location)
+{
+	const CombinerColumn * RESTRICT col = table->columns + column;
+	unsigned int s;
+
+	if (col->count == 0)
+		return 0;
+
+	s = combinerColumn_slot (key, col->capacity);
+	while (col->keys[s] != -1)
+	{
+		if (col->keys[s] == key)
+		{
+			if (col->sizes[s] != nbytes)
+				return 0;
+			*location = col->locations[s];
+			return 1;
+		}
+		s = (s + 1) & (col->capacity - 1);
+	}
+	return 0;
+}
+
+/** remember a buffered message. If a message with the same key exists, 
+    it is replaced.
+@param table Reference to a CombinerTable
+@param column destination 
+@param key message key
+@param location location of the buffered message
+@param nbytes payload size 
+*/
+static inline void
+	combinerTable_insert (CombinerTable * RESTRICT table, const unsigned int column, 
+	const long key, const size_t location, const size_t nbytes)
+{
+	CombinerColumn * RESTRICT col = table->columns + column;
+	unsigned int s;
+
+	if (2 * (col->count + 1) > col->capacity)
+	{
+		/* grow and rehash */
+		CombinerColumn old = *col;
+		unsigned int i;
+		col->capacity = old.capacity ? 2 * old.capacity : 16;
+		col->keys = (long *) bsp_malloc (col->capacity, sizeof(long));
+		col->locations = (size_t *) bsp_malloc (col->capacity, sizeof(size_t));
+		col->sizes = (size_t *) bsp_malloc (col->capacity, sizeof(size_t));
+		memset (col->keys, -1, col->capacity * sizeof(long));
+		for (i = 0; i < old.capacity; i++)
+		{
+			if (old.keys[i] == -1)
+				continue;
+			s = combinerColumn_slot (old.keys[i], col->capacity);
+			while (col->keys[s] != -1)
+				s = (s + 1) & (col->capacity - 1);
+			col->keys[s] = old.keys[i];
+			col->locations[s] = old.locations[i];
+			col->sizes[s] = old.sizes[i];
+		}
+		bsp_free (old.keys);
+		bsp_free (old.locations);
+		bsp_free (old.sizes);
+	}
+
+	s = combinerColumn_slot (key, col->capacity);
+	while (col->keys[s] != -1 && col->keys[s] != key)
+		s = (s + 1) & (col->capacity - 1);
+	if (col->keys[s] == -1)
+		col->count++;
+	col->keys[s] = key;
+	col->locations[s] = location;
+	col->sizes[s] = nbytes;
+}
+
+#endif
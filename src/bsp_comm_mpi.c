@@ -26,6 +26,8 @@
   */  
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "bsp_config.h"
 #include "bsp_private.h"
@@ -79,6 +81,314 @@ void BSP_MPI_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets
 				  bsp_communicator);
 }
 
+/** Split the current communicator (MPI_Comm_split wrapper)
+	@param color processors with the same color form a team, or a negative
+	       value to join no team
+	@param key determines the ranks in the team
+	@param nprocs returns the size of the team
+	@param rank returns the rank in the team
+	@return the communicator of the team, or NULL 
+ */
+void * BSP_MPI_TEAM_SPLIT (int color, int key, int * nprocs, int * rank) {
+	MPI_Comm * comm = (MPI_Comm *) bsp_malloc (1, sizeof(MPI_Comm));
+	MPI_Comm_split(bsp_communicator, color < 0 ? MPI_UNDEFINED : color, key, comm);
+	if (*comm == MPI_COMM_NULL) {
+		bsp_free(comm);
+		return NULL;
+	}
+	MPI_Comm_size(*comm, nprocs);
+	MPI_Comm_rank(*comm, rank);
+	return comm;
+}
+
+/** Exchange the communicator used by all communication routines with 
+    the communicator of a team. Calling this twice restores the previous
+    communicator. 
+	@param comm the communicator of a team
+ */
+void BSP_MPI_TEAM_SWAP (void * comm) {
+	MPI_Comm previous = bsp_communicator;
+	bsp_communicator = *(MPI_Comm *) comm;
+	*(MPI_Comm *) comm = previous;
+}
+
+/** Free the communicator of a team 
+	@param comm the communicator of a team
+ */
+void BSP_MPI_TEAM_FREE (void * comm) {
+	MPI_Comm_free((MPI_Comm *) comm);
+	bsp_free(comm);
+}
+
+/** A neighbourhood: a distributed graph communicator, and the neighbours
+    in the order used by the neighbourhood collectives */
+typedef struct {
+	MPI_Comm comm;
+	int n;				/**< number of neighbours */
+	int nprocs;
+	int * pids;			/**< the neighbours, sorted */
+	int * counts;		/**< 4n counts and offsets for MPI_Neighbor_alltoallv */
+	char * buffer;		/**< packed buffer for MPI_Neighbor_alltoall */
+	int buffer_size;
+} Neighbourhood;
+
+/** the neighbourhood used by the neighbourhood communication routines */
+static Neighbourhood * current_neighbourhood = NULL;
+
+static int compare_ints (const void * a, const void * b) {
+	return *(const int *) a - *(const int *) b;
+}
+
+/** Create a distributed graph communicator from the current communicator
+	(MPI_Dist_graph_create_adjacent wrapper). The processor itself is 
+	always a neighbour, since the delivery table sends to itself.
+	@param pids the neighbours, which must be symmetric
+	@param n the number of neighbours
+	@param nprocs the number of processors in the current communicator
+	@param rank the rank in the current communicator
+	@return the neighbourhood, or NULL if neighbourhood collectives are 
+	        not supported
+ */
+void * BSP_MPI_NEIGHBOURHOOD_CREATE (const int * pids, int n, int nprocs, int rank) {
+#if MPI_VERSION >= 3
+	Neighbourhood * nb = (Neighbourhood *) bsp_malloc (1, sizeof(Neighbourhood));
+	int i, m = 0;
+
+	nb->pids = (int *) bsp_malloc (n + 1, sizeof(int));
+	memcpy (nb->pids, pids, n * sizeof(int));
+	nb->pids[n] = rank;
+	qsort (nb->pids, n + 1, sizeof(int), compare_ints);
+	for (i = 0; i <= n; i++) {
+		if (i == 0 || nb->pids[i] != nb->pids[m - 1]) {
+			nb->pids[m++] = nb->pids[i];
+		}
+	}
+	nb->n = m;
+	nb->nprocs = nprocs;
+	nb->counts = (int *) bsp_malloc (4 * m, sizeof(int));
+	nb->buffer = NULL;
+	nb->buffer_size = 0;
+
+	/* unit weights instead of MPI_UNWEIGHTED, which some MPI 
+	   implementations define as an invalid pointer that compilers 
+	   warn about */
+	for (i = 0; i < m; i++) {
+		nb->counts[i] = 1;
+	}
+	MPI_Dist_graph_create_adjacent (bsp_communicator, m, nb->pids, nb->counts, 
+		m, nb->pids, nb->counts, MPI_INFO_NULL, 0, &nb->comm);
+	return nb;
+#else
+	return NULL;
+#endif
+}
+
+/** Free a neighbourhood
+	@param neighbourhood the neighbourhood
+ */
+void BSP_MPI_NEIGHBOURHOOD_FREE (void * neighbourhood) {
+	Neighbourhood * nb = (Neighbourhood *) neighbourhood;
+	if (nb == NULL) {
+		return;
+	}
+	if (current_neighbourhood == nb) {
+		current_neighbourhood = NULL;
+	}
+	MPI_Comm_free (&nb->comm);
+	bsp_free (nb->pids);
+	bsp_free (nb->counts);
+	bsp_free (nb->buffer);
+	bsp_free (nb);
+}
+
+/** Select the neighbourhood for the neighbourhood communication routines
+	@param neighbourhood the neighbourhood
+ */
+void BSP_MPI_NEIGHBOURHOOD_SELECT (void * neighbourhood) {
+	current_neighbourhood = (Neighbourhood *) neighbourhood;
+}
+
+#if MPI_VERSION >= 3
+
+/** MPI_Neighbor_alltoall wrapper. The buffers hold a block for every 
+	processor, blocks of processors which are not neighbours are not sent,
+	and are received as zeros. */
+void BSP_MPI_NEIGHBOUR_ALLTOALL_COMM (void * sendbuf, int sendcount, void * recvbuf, int recvcount) {
+	Neighbourhood * nb = current_neighbourhood;
+	int i, size = nb->n * ( sendcount + recvcount );
+	char * packed;
+
+	if (nb->buffer_size < size) {
+		bsp_free (nb->buffer);
+		nb->buffer = (char *) bsp_malloc (size, sizeof(char));
+		nb->buffer_size = size;
+	}
+	packed = nb->buffer + nb->n * sendcount;
+	for (i = 0; i < nb->n; i++) {
+		memcpy (nb->buffer + i * sendcount, 
+			(char *) sendbuf + nb->pids[i] * sendcount, sendcount);
+	}
+	MPI_Neighbor_alltoall (nb->buffer, sendcount, MPI_BYTE, 
+		packed, recvcount, MPI_BYTE, nb->comm);
+	memset (recvbuf, 0, nb->nprocs * recvcount);
+	for (i = 0; i < nb->n; i++) {
+		memcpy ((char *) recvbuf + nb->pids[i] * recvcount, 
+			packed + i * recvcount, recvcount);
+	}
+}
+
+/** MPI_Neighbor_alltoallv wrapper. Counts and offsets are given for every
+	processor, and only those of the neighbours are used. */
+void BSP_MPI_NEIGHBOUR_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets ) {
+	Neighbourhood * nb = current_neighbourhood;
+	int * sc = nb->counts, * so = sc + nb->n, * rc = so + nb->n, * ro = rc + nb->n;
+	int i;
+	for (i = 0; i < nb->n; i++) {
+		sc[i] = sendcounts[nb->pids[i]];
+		so[i] = sendoffsets[nb->pids[i]];
+		rc[i] = recvcounts[nb->pids[i]];
+		ro[i] = recvoffsets[nb->pids[i]];
+	}
+	MPI_Neighbor_alltoallv (sendbuf, sc, so, MPI_BYTE, 
+		recvbuf, rc, ro, MPI_BYTE, nb->comm);
+}
+
+#else
+
+void BSP_MPI_NEIGHBOUR_ALLTOALL_COMM (void * sendbuf, int sendcount, void * recvbuf, int recvcount) {
+	BSP_MPI_ALLTOALL_COMM (sendbuf, sendcount, recvbuf, recvcount);
+}
+
+void BSP_MPI_NEIGHBOUR_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets ) {
+	BSP_MPI_ALLTOALLV_COMM (sendbuf, sendcounts, sendoffsets, recvbuf, recvcounts, recvoffsets);
+}
+
+#endif
+
+/** tag of the messages of communication patterns */
+#define BSP_PATTERN_TAG 0x5053
+
+/** the persistent requests of a communication pattern */
+typedef struct {
+	int n;
+	MPI_Request * requests;
+} PatternTransfers;
+
+/** Create persistent point-to-point requests which transfer a block of 
+	the send buffer to every processor with a nonzero send count, and a 
+	block of the receive buffer from every processor with a nonzero 
+	receive count (MPI_Send_init / MPI_Recv_init wrapper).
+	@return the requests, to be started with BSP_MPI_PATTERN_RUN
+ */
+void * BSP_MPI_PATTERN_CREATE (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets ) {
+	PatternTransfers * t = (PatternTransfers *) bsp_malloc (1, sizeof(PatternTransfers));
+	int nprocs, p;
+
+	MPI_Comm_size (bsp_communicator, &nprocs);
+	t->requests = (MPI_Request *) bsp_malloc (2 * nprocs, sizeof(MPI_Request));
+	t->n = 0;
+	for (p = 0; p < nprocs; p++) {
+		if (recvcounts[p] > 0) {
+			MPI_Recv_init ((char *) recvbuf + recvoffsets[p], recvcounts[p], MPI_BYTE,
+				p, BSP_PATTERN_TAG, bsp_communicator, &t->requests[t->n++]);
+		}
+	}
+	for (p = 0; p < nprocs; p++) {
+		if (sendcounts[p] > 0) {
+			MPI_Send_init ((char *) sendbuf + sendoffsets[p], sendcounts[p], MPI_BYTE,
+				p, BSP_PATTERN_TAG, bsp_communicator, &t->requests[t->n++]);
+		}
+	}
+	return t;
+}
+
+/** Start the requests of a pattern, and wait until all have completed 
+	(MPI_Startall / MPI_Waitall wrapper)
+	@param transfers the requests
+ */
+void BSP_MPI_PATTERN_RUN (void * transfers) {
+	PatternTransfers * t = (PatternTransfers *) transfers;
+	if (t->n > 0) {
+		MPI_Startall (t->n, t->requests);
+		MPI_Waitall (t->n, t->requests, MPI_STATUSES_IGNORE);
+	}
+}
+
+/** Free the requests of a pattern
+	@param transfers the requests
+ */
+void BSP_MPI_PATTERN_FREE (void * transfers) {
+	PatternTransfers * t = (PatternTransfers *) transfers;
+	int i;
+	for (i = 0; i < t->n; i++) {
+		MPI_Request_free (&t->requests[i]);
+	}
+	bsp_free (t->requests);
+	bsp_free (t);
+}
+
+/** tag of the columns which are sent during a superstep */
+#define BSP_EAGER_TAG 0x4541
+
+/** MPI_Isend wrapper for the eager channel
+	@return the request
+ */
+void * BSP_MPI_EAGER_ISEND (int pid, void * buf, int size) {
+	MPI_Request * request = (MPI_Request *) bsp_malloc (1, sizeof(MPI_Request));
+	MPI_Isend (buf, size, MPI_BYTE, pid, BSP_EAGER_TAG, bsp_communicator, request);
+	return request;
+}
+
+/** MPI_Test / MPI_Wait wrapper for the eager channel
+	@param request a request returned by BSP_MPI_EAGER_ISEND, which is 
+	       freed when it has completed
+	@param wait nonzero to wait for completion
+	@return nonzero if the request has completed
+ */
+int BSP_MPI_EAGER_COMPLETE (void * request, int wait) {
+	int flag = 1;
+	if (wait) {
+		MPI_Wait ((MPI_Request *) request, MPI_STATUS_IGNORE);
+	} else {
+		MPI_Test ((MPI_Request *) request, &flag, MPI_STATUS_IGNORE);
+	}
+	if (flag) {
+		bsp_free (request);
+	}
+	return flag;
+}
+
+/** MPI_Probe / MPI_Iprobe wrapper for the eager channel
+	@param pid the source to wait for, or set to the source of the 
+	       message if not waiting
+	@param wait nonzero to wait for a message from *pid
+	@return the size of the message, or -1 if there is none
+ */
+int BSP_MPI_EAGER_PROBE (int * pid, int wait) {
+	MPI_Status status;
+	int count;
+	if (wait) {
+		MPI_Probe (*pid, BSP_EAGER_TAG, bsp_communicator, &status);
+	} else {
+		int flag;
+		MPI_Iprobe (MPI_ANY_SOURCE, BSP_EAGER_TAG, bsp_communicator, &flag, &status);
+		if (!flag) {
+			return -1;
+		}
+		*pid = status.MPI_SOURCE;
+	}
+	MPI_Get_count (&status, MPI_BYTE, &count);
+	return count;
+}
+
+/** MPI_Recv wrapper for the eager channel */
+void BSP_MPI_EAGER_RECV (int pid, void * buf, int size) {
+	MPI_Recv (buf, size, MPI_BYTE, pid, BSP_EAGER_TAG, bsp_communicator, MPI_STATUS_IGNORE);
+}
+
 /** MPI_Abort wrapper */
 void BSP_ABORT_MPI (int err) {
 	int flag;
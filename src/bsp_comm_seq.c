@@ -31,6 +31,7 @@
 
 #include "bsp_config.h"
 #include "bsp_private.h"
+#include "bsp_alloc.h"
 #include "bspx_comm_seq.h"
 
 
@@ -62,6 +63,73 @@ void BSP_SEQ_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets
 
 }
 
+/** Team creation on one processor: every team has one member */
+void * BSP_SEQ_TEAM_SPLIT (int color, int key, int * nprocs, int * rank) {
+	if (color < 0)
+		return NULL;
+	*nprocs = 1;
+	*rank = 0;
+	return bsp_malloc(1, sizeof(int));
+}
+
+/** There is no communicator to exchange */
+void BSP_SEQ_TEAM_SWAP (void * comm) {}
+
+/** Free the dummy communicator of a team */
+void BSP_SEQ_TEAM_FREE (void * comm) {
+	bsp_free(comm);
+}
+
+/** On one processor, every processor is a neighbour */
+void * BSP_SEQ_NEIGHBOURHOOD_CREATE (const int * pids, int n, int nprocs, int rank) {
+	return NULL;
+}
+
+void BSP_SEQ_NEIGHBOURHOOD_FREE (void * neighbourhood) {}
+
+void BSP_SEQ_NEIGHBOURHOOD_SELECT (void * neighbourhood) {}
+
+/** The transfers of a pattern on one processor: a copy from the send 
+    buffer to the receive buffer */
+typedef struct {
+	char * src;
+	char * dst;
+	int size;
+} PatternTransfers;
+
+void * BSP_SEQ_PATTERN_CREATE (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets ) {
+	PatternTransfers * t = (PatternTransfers *) bsp_malloc(1, sizeof(PatternTransfers));
+	t->src = (char *) sendbuf + sendoffsets[0];
+	t->dst = (char *) recvbuf + recvoffsets[0];
+	t->size = sendcounts[0] > recvcounts[0] ? recvcounts[0] : sendcounts[0];
+	return t;
+}
+
+void BSP_SEQ_PATTERN_RUN (void * transfers) {
+	PatternTransfers * t = (PatternTransfers *) transfers;
+	memcpy(t->dst, t->src, t->size);
+}
+
+void BSP_SEQ_PATTERN_FREE (void * transfers) {
+	bsp_free(transfers);
+}
+
+/** On one processor, no columns are sent during a superstep */
+void * BSP_SEQ_EAGER_ISEND (int pid, void * buf, int size) {
+	return NULL;
+}
+
+int BSP_SEQ_EAGER_COMPLETE (void * request, int wait) {
+	return 1;
+}
+
+int BSP_SEQ_EAGER_PROBE (int * pid, int wait) {
+	return -1;
+}
+
+void BSP_SEQ_EAGER_RECV (int pid, void * buf, int size) {}
+
 /** abort wrapper */
 void BSP_ABORT_SEQ (int err) {
 	exit (err);
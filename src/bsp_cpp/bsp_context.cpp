@@ -70,6 +70,12 @@ void bsp::Context::bsp_sync () {
 	ContextImpl::bsp_sync( mapper );
 }
 
+bool bsp::Context::bsp_sync_running (bool running, bool * failed) {
+	ASSERT (!impl);	/// only the parent context can call bsp_sync.
+	ASSERT (mapper);/// we can only sync if we have a task mapper
+	return ContextImpl::bsp_sync( mapper, running, failed );
+}
+
 void bsp::Context::bsp_reset_buffers () {
 	if (impl != NULL) {
 		BSP->bsp_reset_buffers();
@@ -94,10 +100,56 @@ void bsp::Context::bsp_put (int pid, const void *src, void *dst, long int offset
 	BSP->bsp_put(pid, src, dst, offset, nbytes);
 }
 
+void bsp::Context::bsp_put_deferred (int pid, const void *src, void *dst, long int offset, size_t nbytes) {
+	BSP->bsp_put_deferred(pid, src, dst, offset, nbytes);
+}
+
 void bsp::Context::bsp_get (int pid, const void *src, long int offset, void *dst, size_t nbytes) {
 	BSP->bsp_get(pid, src, offset, dst, nbytes);
 }
 
+void bsp::Context::bsp_put_strided (int pid, const void *src, long int src_stride, 
+	void *dst, long int offset, long int dst_stride, size_t nbytes, int count) {
+	BSP->bsp_put_strided(pid, src, src_stride, dst, offset, dst_stride, nbytes, count);
+}
+
+void bsp::Context::bsp_get_strided (int pid, const void *src, long int offset, long int src_stride, 
+	void *dst, long int dst_stride, size_t nbytes, int count) {
+	BSP->bsp_get_strided(pid, src, offset, src_stride, dst, dst_stride, nbytes, count);
+}
+
+void bsp::Context::bsp_put_accumulate (int pid, const void *src, void *dst, long int offset, 
+	size_t nbytes, bsp_op_t op, bsp_type_t type) {
+	BSP->bsp_put_accumulate(pid, src, dst, offset, nbytes, op, type);
+}
+
+void bsp::Context::bsp_fetch_op (int pid, const void *src, long int offset, const void *operand, 
+	void *result, bsp_op_t op, bsp_type_t type) {
+	BSP->bsp_fetch_op(pid, src, offset, operand, result, op, type);
+}
+
+void bsp::Context::bsp_cas (int pid, const void *src, long int offset, const void *compare, 
+	const void *value, void *result, bsp_type_t type) {
+	BSP->bsp_cas(pid, src, offset, compare, value, result, type);
+}
+
+bsp::Registration bsp::Context::bsp_push_reg_handle (const void * data, size_t len) {
+	TSLOCK();
+	return Registration (BSP->bsp_push_reg(data, len));
+}
+
+void bsp::Context::bsp_put (int pid, const void *src, Registration const & dst, long int offset, size_t nbytes) {
+	BSP->bsp_put(pid, src, dst.get_serial(), offset, nbytes);
+}
+
+void bsp::Context::bsp_get (int pid, Registration const & src, long int offset, void *dst, size_t nbytes) {
+	BSP->bsp_get(pid, src.get_serial(), offset, dst, nbytes);
+}
+
+char * bsp::Context::bsp_put_slot (int pid, Registration const & dst, long int offset, size_t nbytes) {
+	return BSP->put_slot(pid, dst.get_serial(), offset, nbytes);
+}
+
 /*@}*/
 
 /** @name BSMP */
@@ -126,6 +178,14 @@ void bsp::Context::bsp_set_tagsize (size_t * tag_nbytes) {
 	BSP->bsp_set_tagsize(tag_nbytes);
 }
 
+void bsp::Context::bsp_set_combiner (bsp_combiner_key_fn key, bsp_combiner_fn combine) {
+	BSP->bsp_set_combiner(key, combine);
+}
+
+bsp::MessageRange bsp::Context::bsp_messages () {
+	return BSP->bsp_messages();
+}
+
 /*@}*/
 
 /** @name High Performance */
@@ -43,6 +43,9 @@ extern "C" {
 #include <stdexcept>
 #include <sstream>
 
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
 #include "bsp_contextimpl.h"
 
 #include "bsp.h"
@@ -59,29 +62,43 @@ extern "C" {
 
 #define CM_FLAG_GETS			1
 #define CM_FLAG_MESSAGES		2
+#define CM_FLAG_RUNNING			4
+#define CM_FLAG_CHANNELS		8
+#define CM_FLAG_FAILED			16
+#define CM_FLAG_BITS			5
 
 /**
  * Constructor. Make local BSP object, update processor locations
  */
 bsp::ContextImpl::ContextImpl(bsp::TaskMapper * tm, int lpid) 
-	: mapper (tm), any_hp(false), local_pid(lpid) {
+	: mapper (tm), any_hp(false), local_pid(lpid), next_serial(0),
+	  memo_ident(NULL), memo_row(NULL) {
 	global_pid = tm->local_to_global_pid(lpid);
-	deliveryTable_reset(&g_bsp.delivery_table);
-	deliveryTable_reset(&g_bsp.delivery_received_table);
-	memoryRegister_initialize( &memory_register, mapper->nprocs(), 1, global_pid );
+	// nested contexts are created while the enclosing level
+	// may have outstanding global deliveries
+	if (!tm->is_node_local()) {
+		deliveryTable_reset(&g_bsp.delivery_table);
+		deliveryTable_reset(&g_bsp.delivery_received_table);
+	}
+	node = get_node_impl(tm);
+	combinerTable_initialize(&combiner, tm->nprocs());
 }
 
 /** 
  * Destructor. Destroy local BSP object 
  */
 bsp::ContextImpl::~ContextImpl() {
-	memoryRegister_destruct(&memory_register);
+	combinerTable_destruct(&combiner);
 }
 
 /**
  * Execute BSP sync.
  */
-void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {	
+bool bsp::ContextImpl::bsp_sync( TaskMapper * mapper, bool running, bool * failed ) {	
+	if (mapper->is_node_local()) {
+		return bsp_sync_node_local(mapper, running);
+	}
+
 	int reg_req_size = -1;
 	bool any_hp = false;
 	bool any_gets = false;
@@ -89,12 +106,13 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 	/************************************************************************/
 	/* Step 1. exchange communication matrix.                               */
 	/************************************************************************/
+	/* here we also carry out all local deliveries */
+	execute_local_deliveries(mapper);
+	bool any_channels = prepare_channels(mapper);
+
 	for (int lp = 0; lp < mapper->procs_this_node(); ++lp) {
 		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
 
-		/* here we also carry out all local deliveries */
-		cimpl->localDeliveries.execute();
-
 		if (reg_req_size < 0) {
 			reg_req_size = (int)cimpl->reg_requests.size();
 		} else {
@@ -109,7 +127,7 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 		reg_req_size = 0;
 	}
 
-	reg_req_size = ((reg_req_size&MAX_REGISTER_REQS) << 4);
+	reg_req_size = ((reg_req_size&MAX_REGISTER_REQS) << CM_FLAG_BITS);
 
 	bool any_messages = deliveryTable_empty(&g_bsp.delivery_table) == 0;
 #ifdef _DEBUGSUPERSTEPS
@@ -133,6 +151,15 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 		if ( any_messages ) {
 			g_bsp.send_index[3 * p + CM_FLAGS] |= CM_FLAG_MESSAGES;
 		}
+		if ( running ) {
+			g_bsp.send_index[3 * p + CM_FLAGS] |= CM_FLAG_RUNNING;
+		}
+		if ( any_channels ) {
+			g_bsp.send_index[3 * p + CM_FLAGS] |= CM_FLAG_CHANNELS;
+		}
+		if ( failed != NULL && *failed ) {
+			g_bsp.send_index[3 * p + CM_FLAGS] |= CM_FLAG_FAILED;
+		}
 		
 		g_bsp.send_index[3 * p + CM_FLAGS] |= reg_req_size 
 #ifdef _DEBUGSUPERSTEPS
@@ -200,7 +227,7 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 	/* Step 2. Process memory register registrations.                       */
 	/************************************************************************/
 
-	reg_req_size >>= 4;
+	reg_req_size >>= CM_FLAG_BITS;
 
 	any_messages = false;
 	bool local_messages = false;
@@ -213,8 +240,20 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 		if (g_bsp.recv_index[3 * p + CM_FLAGS] & CM_FLAG_GETS) {
 			any_gets = true;
 		}
+
+		if (g_bsp.recv_index[3 * p + CM_FLAGS] & CM_FLAG_RUNNING) {
+			running = true;
+		}
+
+		if (g_bsp.recv_index[3 * p + CM_FLAGS] & CM_FLAG_CHANNELS) {
+			any_channels = true;
+		}
+
+		if (failed != NULL && (g_bsp.recv_index[3 * p + CM_FLAGS] & CM_FLAG_FAILED)) {
+			*failed = true;
+		}
 		using namespace std;
-		reg_req_size = max ((unsigned)reg_req_size, g_bsp.recv_index[3 * p + CM_FLAGS] >> 4);
+		reg_req_size = max ((unsigned)reg_req_size, g_bsp.recv_index[3 * p + CM_FLAGS] >> CM_FLAG_BITS);
 	}
 
 	/**
@@ -317,7 +356,7 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 
 		/** execute put operations */
 		deliveryTable_execute(&g_bsp.delivery_received_table, 
-			&g_bsp.memory_register, &g_bsp.message_queue, g_bsp.rank);
+			&g_bsp.memory_register, &g_bsp.message_queue, g_bsp.rank, NULL, NULL);
 
 		/** split message queue */
 		int bytes;
@@ -325,10 +364,12 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 		bytes = bspx_hpmove(&g_bsp, &tag, &message);
 		while (bytes >= 0) {
 			// all messages sent through ContextImpl's (hp)send functions
-			// will include an integer at the beginning of the message that
-			// specifies the local processor to send to
-			ASSERT (bytes >= sizeof(int));
-			int lp = *((int*)message);
+			// start with a header that specifies the local processor to 
+			// send to and the source pid
+			ASSERT (bytes >= (int)sizeof(RemoteMessageHeader));
+			RemoteMessageHeader h;
+			memcpy (&h, message, sizeof(RemoteMessageHeader));
+			int lp = h.local_pid;
 			ASSERT (lp>=0);
 			ASSERT (lp < mapper->procs_this_node());
 #ifdef _DEBUGSUPERSTEPS
@@ -338,15 +379,22 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 				std::cout.flush();
 #endif
 			ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
-			cimpl->localDeliveries.hpsend(tag, ((int*)message)+1, bytes-sizeof(int));
+			cimpl->localDeliveries.hpsend(h.source, tag, 
+				((char*)message) + sizeof(RemoteMessageHeader), bytes - sizeof(RemoteMessageHeader));
 
 			bytes = bspx_hpmove(&g_bsp, &tag, &message);
 		}		
 	}
 
+	/** channel records for other nodes are exchanged separately */
+	if ( any_channels ) {
+		exchange_channels(mapper);
+	}
+
 	for (int lp = 0; lp < mapper->procs_this_node(); ++lp) {
 		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
 		cimpl->localDeliveries.bsmp_messagequeue_sync();			
+		combinerTable_reset(&cimpl->combiner);
 	}
 
 	/* clear the buffers */			
@@ -360,12 +408,92 @@ void bsp::ContextImpl::bsp_sync( TaskMapper * mapper ) {
 	
 	memoryRegister_pack(&g_bsp.memory_register);
 	*/
+	return running;
+}
+
+/** parallel_for body for one phase of local deliveries */
+struct bsp::ContextImpl::LocalDeliveryPhase {
+	LocalDeliveryPhase (bsp::TaskMapper * _mapper, bool _gets) : 
+		mapper (_mapper), gets (_gets) {}
+
+	void operator() (tbb::blocked_range<int> const & r) const {
+		for (int lp = r.begin(); lp != r.end(); ++lp) {
+			bsp::ContextImpl * cimpl = (bsp::ContextImpl *)(mapper->get_context(lp)->get_impl());
+			if (gets) {
+				cimpl->localDeliveries.execute_gets();
+			} else {
+				cimpl->localDeliveries.execute_puts();
+			}
+		}
+	}
+
+	bsp::TaskMapper * mapper;
+	bool gets;
+};
+
+/**
+ * Execute local deliveries. Gets must read their sources before any 
+ * puts overwrite them, so all gets are executed before all puts. Within 
+ * each phase, contexts are processed in parallel. The result of 
+ * overlapping puts from different processors to the same location in 
+ * the same superstep is undefined. Atomic operations are executed 
+ * between gets and puts, and accumulates are applied last; both one 
+ * context after another, since they may overlap.
+ */
+void bsp::ContextImpl::execute_local_deliveries( TaskMapper * mapper ) {
+	int n = mapper->procs_this_node();
+	if (n > 1) {
+		tbb::parallel_for (tbb::blocked_range<int> (0, n), LocalDeliveryPhase (mapper, true));
+		for (int lp = 0; lp < n; ++lp) {
+			((ContextImpl *)(mapper->get_context(lp)->get_impl()))->localDeliveries.execute_atomics();
+		}
+		tbb::parallel_for (tbb::blocked_range<int> (0, n), LocalDeliveryPhase (mapper, false));
+		for (int lp = 0; lp < n; ++lp) {
+			((ContextImpl *)(mapper->get_context(lp)->get_impl()))->localDeliveries.execute_accumulates();
+		}
+	} else if (n == 1) {
+		((ContextImpl *)(mapper->get_context(0)->get_impl()))->localDeliveries.execute();
+	}
+}
+
+/**
+ * Sync for node-local task mappers: all deliveries are local, so we only 
+ * need to execute them and process registrations.
+ */
+bool bsp::ContextImpl::bsp_sync_node_local( TaskMapper * mapper, bool running ) {
+	int reg_req_size = -1;
+
+	execute_local_deliveries(mapper);
+	prepare_channels(mapper);
+
+	for (int lp = 0; lp < mapper->procs_this_node(); ++lp) {
+		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
+
+		if (reg_req_size < 0) {
+			reg_req_size = (int)cimpl->reg_requests.size();
+		} else {
+			if (reg_req_size != (int)cimpl->reg_requests.size()) {
+				throw std::runtime_error("bsp_sync(): mismatched number of registration requests.");
+			}
+		}
+	}
+
+	if (reg_req_size > 0) {
+		ContextImpl::process_memoryreg_ops(mapper, reg_req_size);
+	}
+
+	for (int lp = 0; lp < mapper->procs_this_node(); ++lp) {
+		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
+		cimpl->localDeliveries.bsmp_messagequeue_sync();			
+		combinerTable_reset(&cimpl->combiner);
+	}
+	return running;
 }
 
 /** Push register implementation which distinguishes between local and 
  *  remote locations.
  */
-void bsp::ContextImpl::bsp_push_reg(const void * ident, size_t nbytes) {
+size_t bsp::ContextImpl::bsp_push_reg(const void * ident, size_t nbytes) {
 	ASSERT (memory_register_map.find (ident) == memory_register_map.end());
 
 	// we limit the number of requests per superstep so we can fit them into a
@@ -375,9 +503,15 @@ void bsp::ContextImpl::bsp_push_reg(const void * ident, size_t nbytes) {
 	MemoryRegister_Reg r;
 	r.data   = ident;
 	r.size   = nbytes;
-	r.serial = memory_register.used_slot_count[global_pid] + reg_requests.size();
+	if (free_serials.empty()) {
+		r.serial = next_serial++;
+	} else {
+		r.serial = *free_serials.begin();
+		free_serials.erase(free_serials.begin());
+	}
 	r.push   = true;
 	reg_requests.push( r );
+	return r.serial;
 }
 
 /** Pop register */
@@ -386,7 +520,7 @@ void bsp::ContextImpl::bsp_pop_reg(const void * ident) {
 	// single value
 	ASSERT(reg_requests.size() < MAX_REGISTER_REQS);
 
-	std::map<const void *, MemoryRegister>::iterator it = memory_register_map.find (ident);
+	std::map<const void *, size_t>::iterator it = memory_register_map.find (ident);
 	
 	if (it == memory_register_map.end()) {
 		throw std::runtime_error("bsp_pop_reg: unknown register in pop_reg.");
@@ -394,8 +528,8 @@ void bsp::ContextImpl::bsp_pop_reg(const void * ident) {
 
 	MemoryRegister_Reg r;
 	r.data   = ident;
-	r.size   = it->second.nbytes;
-	r.serial = it->second.serial;
+	r.size   = node->memory_register.rows[it->second].nbytes;
+	r.serial = it->second;
 	r.push   = false;
 	reg_requests.push( r );
 }
@@ -35,6 +35,9 @@ Implementation header for ContextImpl implementation
 
 #include <map>
 #include <queue>
+#include <set>
+#include <vector>
+#include <stdexcept>
 
 #include <boost/shared_array.hpp>
 
@@ -58,10 +61,40 @@ extern BSPObject g_bsp;
 };
 namespace bsp {
 
+	/** A memory registration as seen on this node.
+	 *
+	 *  Holds the addresses of the registered area on all virtual 
+	 *  processors, indexed by global pid. When all processors on each 
+	 *  node have registered the same address (i.e. when tasks share 
+	 *  an area in a common address space), only one address per node 
+	 *  is stored.
+	 */
 	struct MemoryRegister {
 		boost::shared_array<const void*>	pointers;
 		size_t				nbytes;
-		size_t				serial;
+		bool				per_node;
+	};
+
+	/** Memory register which is shared by all contexts on a node.
+	 *
+	 *  There is one row per registration, indexed by registration serial,
+	 *  so memory use is O(P*R) per node rather than O(k*P*R) for k local
+	 *  contexts.
+	 */
+	struct NodeMemoryRegister {
+		std::vector<MemoryRegister> rows;
+	};
+
+	/** Implementation data which is shared by all contexts of a task mapper 
+	 *  on this node */
+	struct NodeImpl {
+		NodeMemoryRegister memory_register;
+
+		/** channel records for other nodes, packed per node */
+		std::vector<char> channel_sendbuf;
+		std::vector<int> channel_send_bytes;
+		std::vector<int> channel_send_offsets;
+		std::vector<char> channel_recvbuf;
 	};
 
 	struct MemoryRegister_Reg {
@@ -74,26 +107,90 @@ namespace bsp {
 	class ContextImpl {
 	public:
 		enum {
-			MAX_REGISTER_REQS = 0xfffffff,	///< maximum number of memory register (de-)registrations per superstep
+			MAX_REGISTER_REQS = 0x7ffffff,	///< maximum number of memory register (de-)registrations per superstep
 		};
 
 		ContextImpl(TaskMapper * tm, int local_pid);
 		~ContextImpl();
 
-		/** This is where all contexts within a task mapper are synchronized */
-		static void bsp_sync (TaskMapper *);
+		/** This is where all contexts within a task mapper are synchronized
+		 *
+		 * @param running tell the other nodes that we still have running processors
+		 * @param failed if not NULL, tell the other nodes that this node has
+		 *        failed, and return whether any node has
+		 * @return true if any node passed running = true
+		 */
+		static bool bsp_sync (TaskMapper *, bool running = false, bool * failed = NULL);
 
 		/** reset global and local delivery buffers */
 		void bsp_reset_buffers() {
 			TSLOCK();
 			localDeliveries.reset_buffers();
 			bspx_resetbuffers(&g_bsp);
+			combinerTable_reset(&combiner);
+		}
+
+		/** forget all registrations and queued communication, so the 
+		 *  context can be reused for another run. Buffers are kept. */
+		void reset_state() {
+			localDeliveries.clear_buffers();
+			while (!reg_requests.empty()) {
+				reg_requests.pop();
+			}
+			memory_register_map.clear();
+			next_serial = 0;
+			free_serials.clear();
+			memo_ident = NULL;
+			memo_row = NULL;
+			any_hp = false;
+			combinerTable_reset(&combiner);
+			combiner.key = NULL;
+			combiner.combine = NULL;
 		}
 
-		/** push and pop operations use the local push/pop queue */
-		void bsp_push_reg (const void *, size_t);
+		/** push and pop operations use the local push/pop queue 
+		 * 
+		 *  @return the serial of the new registration, which is the same
+		 *          on all processors
+		 */
+		size_t bsp_push_reg (const void *, size_t);
 		void bsp_pop_reg (const void *);
 		
+		/** Translate a registered local address to the corresponding address
+		 *  on virtual processor pid */
+		inline char * register_find (int pid, const void * ident) {
+			if (ident != memo_ident) {
+				std::map<const void*, size_t>::const_iterator it = memory_register_map.find (ident);
+				if (it == memory_register_map.end()) {
+					throw std::runtime_error("Memory area was not registered.");
+				}
+				memo_ident = ident;
+				memo_row = &node->memory_register.rows[it->second];
+			}
+			return (char*) memo_row->pointers[memo_row->per_node ? mapper->global_to_node(pid) : pid];
+		}
+
+		/** Report communication volume to the task mapper */
+		inline void record_comm (int pid, size_t nbytes) {
+			if (mapper->measuring_comm()) {
+				mapper->add_comm_bytes(local_pid, pid, nbytes);
+			}
+		}
+
+		/** Translate a registration serial to the corresponding address 
+		 *  on virtual processor pid. This does not need a lookup by
+		 *  address. */
+		inline char * register_at (int pid, size_t serial) {
+			if (serial >= node->memory_register.rows.size()) {
+				throw std::runtime_error("Invalid registration serial.");
+			}
+			MemoryRegister & row (node->memory_register.rows[serial]);
+			if (!row.pointers) {
+				throw std::runtime_error("Memory area was not registered.");
+			}
+			return (char*) row.pointers[row.per_node ? mapper->global_to_node(pid) : pid];
+		}
+
 		/** Put and get are local node aware, i.e. they only use the global
 		 *  queue when they actually have to do remote deliveries.
 		 *  
@@ -102,24 +199,40 @@ namespace bsp {
 		 *  deliveries. Which shouldn't matter that much because 
 		 */
 		inline void bsp_put(int pid, const void* src, void* dst, long offset, size_t nbytes) {
-			int n = mapper->global_to_node(pid);
-			if (g_bsp.rank == n) {
-				localDeliveries.put(
+			put_to (pid, src, register_find (pid, dst) + offset, nbytes);
+		}
+
+		/** Put to a registered area given by its serial */
+		inline void bsp_put(int pid, const void* src, size_t serial, long offset, size_t nbytes) {
+			put_to (pid, src, register_at (pid, serial) + offset, nbytes);
+		}
+
+		/** Put to a registered area given by its serial, the caller 
+		 *  copies the data to the returned location. Returns NULL for 
+		 *  remote destinations. */
+		inline char * put_slot(int pid, size_t serial, long offset, size_t nbytes) {
+			if (mapper->this_node() != mapper->global_to_node(pid)) {
+				return NULL;
+			}
+			record_comm(pid, nbytes);
+			return localDeliveries.reserve_put (register_at (pid, serial) + offset, nbytes);
+		}
+
+		/** Put from a source which stays unchanged until the next sync.
+		 * 
+		 *  Node-local deliveries only record source and destination, and
+		 *  copy once at sync time. Remote deliveries are buffered like 
+		 *  bsp_put.
+		 */
+		inline void bsp_put_deferred(int pid, const void* src, void* dst, long offset, size_t nbytes) {
+			if (mapper->this_node() == mapper->global_to_node(pid)) {
+				record_comm(pid, nbytes);
+				localDeliveries.hpput(
 					(char *)src, 
-					memoryRegister_find ( &memory_register, global_pid, pid, (const char *)dst)
-//					(char*)memory_register_map[dst].pointers[pid])
-					 + offset, 
+					register_find (pid, dst) + offset, 
 					nbytes);
 			} else {
-				char * pointer;
-				DelivElement element;
-				element.size = (unsigned int) nbytes;
-				element.info.put.dst = memoryRegister_find ( &memory_register, global_pid, pid, (const char *)dst) + offset;
-				{ 
-					TSLOCK();
-					pointer = (char*)deliveryTable_push(&g_bsp.delivery_table, n, &element, it_put);
-					memcpy(pointer, src, nbytes);
-				}
+				put_to (pid, src, register_find (pid, dst) + offset, nbytes);
 			}
 		}
 
@@ -127,22 +240,116 @@ namespace bsp {
 		 * Local gets become preferable over puts in this implementation. 
 		 */
 		inline void bsp_get (int pid, const void * src, long int offset, void * dst, size_t nbytes) {
+			get_from (pid, register_find (pid, src), offset, dst, nbytes);
+		}
+
+		/** Get from a registered area given by its serial */
+		inline void bsp_get (int pid, size_t serial, long int offset, void * dst, size_t nbytes) {
+			get_from (pid, register_at (pid, serial), offset, dst, nbytes);
+		}
+
+		/** Strided put: count blocks of nbytes, src_stride apart at the 
+		 *  source and dst_stride apart at the destination. Remote blocks 
+		 *  are sent as a single delivery. */
+		inline void bsp_put_strided(int pid, const void* src, long src_stride, 
+			void* dst, long offset, long dst_stride, size_t nbytes, int count) {
+			if (count <= 0 || nbytes == 0) {
+				return;
+			}
+			int n = mapper->global_to_node(pid);
+			char * destination = register_find (pid, dst) + offset;
+			record_comm(pid, nbytes * count);
+			if (mapper->this_node() == n) {
+				localDeliveries.put_strided((const char*)src, src_stride, 
+					destination, dst_stride, nbytes, (unsigned int)count);
+			} else {
+				TSLOCK();
+				deliveryTable_push_strided(&g_bsp.delivery_table, n, destination, 
+					(const char*)src, src_stride, dst_stride, nbytes, (unsigned int)count);
+			}
+		}
+
+		/** Accumulate nbytes from src into the destination at sync time
+		 *  using a reduction operation */
+		inline void bsp_put_accumulate(int pid, const void* src, void* dst, long offset, 
+			size_t nbytes, bsp_op_t op, bsp_type_t type) {
+			if (!accumulate_valid(op, type)) {
+				throw std::runtime_error("Invalid accumulate operation.");
+			}
+			if (nbytes == 0) {
+				return;
+			}
+			int n = mapper->global_to_node(pid);
+			char * destination = register_find (pid, dst) + offset;
+			record_comm(pid, nbytes);
+			if (mapper->this_node() == n) {
+				localDeliveries.accumulate((const char*)src, destination, nbytes, op, type);
+			} else {
+				TSLOCK();
+				deliveryTable_push_accumulate(&g_bsp.delivery_table, n, destination, 
+					src, nbytes, op, type);
+			}
+		}
+
+		/** Atomic fetch-and-op or compare-and-swap (op == BSP_OP_CAS) on 
+		 *  one element. The previous value is stored in result at sync time. */
+		inline void atomic(int pid, const void* src, long offset, const void* operand, 
+			const void* compare, void* result, unsigned int op, bsp_type_t type) {
+			size_t nbytes = accumulate_type_size(type);
+			if (nbytes == 0 || (op != BSP_OP_CAS && !accumulate_valid(op, type))) {
+				throw std::runtime_error("Invalid atomic operation.");
+			}
 			int n = mapper->global_to_node(pid);
-			if (g_bsp.rank == n) {
-				localDeliveries.hpput (memoryRegister_find ( &memory_register, global_pid, pid, (const char*)src) + offset, 
-					(char*) dst, nbytes);
+			char * source = register_find (pid, src);
+			record_comm(pid, nbytes);
+			if (mapper->this_node() == n) {
+				localDeliveries.atomic(source + offset, result, operand, compare, nbytes, op, type);
+			} else {
+				TSLOCK();
+				requestTable_push_atomic(&g_bsp.request_table, n, source, offset, 
+					result, operand, compare, nbytes, op, type);
+			}
+		}
+
+		/** Fetch-and-op on one element */
+		inline void bsp_fetch_op(int pid, const void* src, long offset, const void* operand, 
+			void* result, bsp_op_t op, bsp_type_t type) {
+			atomic(pid, src, offset, operand, NULL, result, op, type);
+		}
+
+		/** Compare-and-swap on one element */
+		inline void bsp_cas(int pid, const void* src, long offset, const void* compare, 
+			const void* value, void* result, bsp_type_t type) {
+			atomic(pid, src, offset, value, compare, result, BSP_OP_CAS, type);
+		}
+
+		/** Strided get: count blocks of nbytes, src_stride apart at the 
+		 *  source and dst_stride apart at the destination. Remote blocks 
+		 *  are requested and returned as a single item. */
+		inline void bsp_get_strided(int pid, const void* src, long offset, long src_stride,
+			void* dst, long dst_stride, size_t nbytes, int count) {
+			if (count <= 0 || nbytes == 0) {
+				return;
+			}
+			int n = mapper->global_to_node(pid);
+			char * source = register_find (pid, src);
+			record_comm(pid, nbytes * count);
+			if (mapper->this_node() == n) {
+				for (int k = 0; k < count; ++k) {
+					localDeliveries.get (source + offset + k * src_stride, 
+						((char*) dst) + k * dst_stride, nbytes);
+				}
 			} else {
 				ReqElement elem;
 				elem.size = (unsigned int )nbytes;
-				elem.src = memoryRegister_find ( &memory_register, global_pid, pid, (const char*)src);
-					// ((char*)memory_register_map[src].pointers[pid]);
+				elem.src = source;
 				elem.dst = (char* )dst;
 				elem.offset = offset;
-				{
-					TSLOCK();
-					/* place get command in buffer */
-					requestTable_push(&g_bsp.request_table, n, &elem);
-				}
+				elem.count = (unsigned int)count;
+				elem.info.strided.src_stride = src_stride;
+				elem.info.strided.dst_stride = dst_stride;
+				TSLOCK();
+				requestTable_push(&g_bsp.request_table, n, &elem);
 			}
 		}
 
@@ -150,10 +357,11 @@ namespace bsp {
 		 *  instantly */
 		inline void bsp_hpput (int pid, const void * src, void * dst, long int offset, size_t nbytes) {
 			int n = mapper->global_to_node(pid);
+			record_comm(pid, nbytes);
 
-			if (n == g_bsp.rank) {
+			if (n == mapper->this_node()) {
 				// we have the data here on the same node, and can do the transfer now.
-				char * destination = memoryRegister_find ( &memory_register, global_pid, pid, (const char*)dst) + offset;
+				char * destination = register_find (pid, dst) + offset;
 				memcpy(destination, src, nbytes);
 			} else {
 				// TODO we could technically also move this bit into 
@@ -166,8 +374,7 @@ namespace bsp {
 				char * RESTRICT pointer;
 				DelivElement element;
 				element.size = (unsigned int) nbytes;
-				element.info.put.dst = memoryRegister_find ( &memory_register, global_pid, pid, (const char*)dst) + offset;
-					//((char*)memory_register_map[dst].pointers[pid]) + offset;
+				element.info.put.dst = register_find (pid, dst) + offset;
 				{
 					TSLOCK();
 					pointer = (char*)deliveryTable_push(&g_bsp.delivery_table, n, &element, it_put);
@@ -180,17 +387,20 @@ namespace bsp {
 		 *  instantly */
 		inline void bsp_hpget (int pid, const void * src, long int offset, void * dst, size_t nbytes) {
 			int n = mapper->global_to_node(pid);
+			record_comm(pid, nbytes);
 
-			if (n == g_bsp.rank) {
-				char * source = memoryRegister_find ( &memory_register, global_pid, pid, (const char*)src) + offset;
+			if (n == mapper->this_node()) {
+				char * source = register_find (pid, src) + offset;
 				memcpy(dst, source, nbytes);
 			} else {
 				ReqElement elem;
 				elem.size = (unsigned int )nbytes;
-				elem.src = memoryRegister_find ( &memory_register, global_pid, pid, (const char*)src);
-					//((char*)memory_register_map[src].pointers[pid]);
+				elem.src = register_find (pid, src);
 				elem.dst = (char* )dst;
 				elem.offset = offset;
+				elem.count = 1;
+				elem.info.strided.src_stride = 0;
+				elem.info.strided.dst_stride = 0;
 
 				/* place get command in buffer */
 				TSLOCK();
@@ -198,61 +408,94 @@ namespace bsp {
 			}
 		}
 
-		/** we add an int to indicate which processor it's going to */
+		/** remote messages carry a header with the local pid they are 
+		 *  going to and their source pid. 
+		 *  
+		 *  With a combiner, messages to the same pid with the same key
+		 *  are combined into the buffered message. For local destinations,
+		 *  the combiner stores the payload offset in the receiver's
+		 *  message buffer, for remote ones the slot of the message in the
+		 *  node's delivery table column.
+		 */
 		inline void bsp_send (int pid, 
 			const void *tag, const void *payload, size_t payload_nbytes) {
 			int n = mapper->global_to_node(pid);
 			int lp = mapper->global_to_local(pid);
+			long key = -1;
+			size_t location;
+
+			if (combiner.combine != NULL) {
+				key = combiner.key(tag, payload, payload_nbytes);
+			}
+
+			if (key >= 0) {
+				TSLOCK();
+				if (combinerTable_find(&combiner, pid, key, payload_nbytes, &location)) {
+					combiner.combine(combined_payload(n, lp, location), payload, payload_nbytes);
+					combiner.combined++;
+					return;
+				}
+			}
 
-			if (n == g_bsp.rank) {
+			record_comm(pid, payload_nbytes);
+			if (n == mapper->this_node()) {
 				TSLOCK();
-				((ContextImpl*)mapper->get_context(lp)->get_impl())->localDeliveries.send(
-					tag, g_bsp.message_queue.send_tag_size, 
+				location = ((ContextImpl*)mapper->get_context(lp)->get_impl())->localDeliveries.send(
+					global_pid, tag, g_bsp.message_queue.send_tag_size, 
 					payload, payload_nbytes
 				);
 			} else {
-				/** remote delivery */
-				DelivElement element;
-				char * RESTRICT pointer;
-				element.size = (unsigned int )payload_nbytes + g_bsp.message_queue.send_tag_size + sizeof(int);
-				element.info.send.payload_size = (unsigned int )payload_nbytes + sizeof(int);
-
-				TSLOCK();
-				pointer = (char *)deliveryTable_push(&g_bsp.delivery_table, n, &element, it_send);
+				location = send_remote (n, lp, tag, payload, payload_nbytes);
+			}
 
-				// we prepend the target local pid to the data
-				*((int*) (pointer + g_bsp.message_queue.send_tag_size ) ) = lp;
-				memcpy( pointer, tag, g_bsp.message_queue.send_tag_size);
-				memcpy( pointer + sizeof(int) + g_bsp.message_queue.send_tag_size, payload, payload_nbytes);
+			if (key >= 0) {
+				combinerTable_insert(&combiner, pid, key, location, payload_nbytes);
 			}
 		}
 
+		/** Set the combiner for messages sent by this context. 
+		 *  Messages sent before in the same superstep are not combined
+		 *  with later ones. */
+		inline void bsp_set_combiner (bsp_combiner_key_fn key, bsp_combiner_fn combine) {
+			combinerTable_reset(&combiner);
+			combiner.key = key;
+			combiner.combine = key != NULL ? combine : NULL;
+		}
+
 		/** unbuffered send. do not touch tag or payload after this call.  */
 		inline void bsp_hpsend (int pid, 
 			const void *tag, const void *payload, size_t payload_nbytes) {
 			int n = mapper->global_to_node(pid);
+			record_comm(pid, payload_nbytes);
 			int lp = mapper->global_to_local(pid);
 
-			if (n == g_bsp.rank) {
+			if (n == mapper->this_node()) {
 				TSLOCK();
 				((ContextImpl*)mapper->get_context(lp)->get_impl())->localDeliveries.hpsend (
-					tag, payload, payload_nbytes
+					global_pid, tag, payload, payload_nbytes
 				);
 			} else {
-				/** remote delivery */
-				DelivElement element;
-				char * RESTRICT pointer;
-				element.size = (unsigned int )payload_nbytes + g_bsp.message_queue.send_tag_size + sizeof(int);
-				element.info.send.payload_size = (unsigned int )payload_nbytes + sizeof(int);
-
-				TSLOCK();
-				pointer = (char *)deliveryTable_push(&g_bsp.delivery_table, pid, &element, it_send);
+				send_remote (n, lp, tag, payload, payload_nbytes);
+			}
+		}
 
-				// we prepend the target local pid to the data
-				*((int*) (pointer + g_bsp.message_queue.send_tag_size ) ) = lp;
-				memcpy( pointer, tag, g_bsp.message_queue.send_tag_size);
-				memcpy( pointer + sizeof(int) + g_bsp.message_queue.send_tag_size, payload, payload_nbytes);
+		/** Dequeue all messages, and list them without copying. The 
+		 *  list is valid until the next call or the next sync. */
+		inline MessageRange bsp_messages () {
+			message_list.clear();
+			while (localDeliveries.bsmp_qsize() > 0) {
+				Message m;
+				m.source = localDeliveries.bsmp_top_source();
+				m.tag = localDeliveries.bsmp_top_tag();
+				m.payload = localDeliveries.bsmp_top_message();
+				m.nbytes = localDeliveries.bsmp_top_size();
+				message_list.push_back(m);
+				localDeliveries.bsmp_advance();
+			}
+			if (message_list.empty()) {
+				return MessageRange (NULL, NULL);
 			}
+			return MessageRange (&message_list[0], &message_list[0] + message_list.size());
 		}
 
 		/** BSMP message queue size */
@@ -307,11 +550,96 @@ namespace bsp {
 		}
 
 	private:
+		/** the task mapper relocates contexts when remapping */
+		friend class TaskMapper;
 
 		/************************************************************************/
 		/* Synchronization helpers                                              */
 		/************************************************************************/
 
+		/** header of messages to contexts on other nodes */
+		struct RemoteMessageHeader {
+			int local_pid;	///< receiving context on the destination node
+			int source;		///< global pid of the sender
+		};
+
+		/** send a message to a context on another node
+		 * 
+		 * @return the slot of the message in column n of the delivery table
+		 */
+		inline size_t send_remote (int n, int lp, 
+			const void *tag, const void *payload, size_t payload_nbytes) {
+			DelivElement element;
+			char * RESTRICT pointer;
+			element.size = (unsigned int )payload_nbytes + g_bsp.message_queue.send_tag_size + sizeof(RemoteMessageHeader);
+			element.info.send.payload_size = (unsigned int )payload_nbytes + sizeof(RemoteMessageHeader);
+
+			TSLOCK();
+			pointer = (char *)deliveryTable_push(&g_bsp.delivery_table, n, &element, it_send);
+
+			RemoteMessageHeader h;
+			h.local_pid = lp;
+			h.source = global_pid;
+			memcpy( pointer, tag, g_bsp.message_queue.send_tag_size);
+			memcpy( pointer + g_bsp.message_queue.send_tag_size, &h, sizeof(RemoteMessageHeader));
+			memcpy( pointer + sizeof(RemoteMessageHeader) + g_bsp.message_queue.send_tag_size, payload, payload_nbytes);
+			return (pointer - g_bsp.delivery_table.data) / sizeof(ALIGNED_TYPE) 
+				- n * g_bsp.delivery_table.rows;
+		}
+
+		/** payload of a message which was buffered by bsp_send with a 
+		 *  combiner (must be called holding the lock) */
+		inline char * combined_payload (int n, int lp, size_t location) {
+			if (n == mapper->this_node()) {
+				return ((ContextImpl*)mapper->get_context(lp)->get_impl())->localDeliveries.message_payload(location);
+			}
+			return g_bsp.delivery_table.data 
+				+ (n * g_bsp.delivery_table.rows + location) * sizeof(ALIGNED_TYPE)
+				+ g_bsp.message_queue.send_tag_size + sizeof(RemoteMessageHeader);
+		}
+
+		/** buffered put to a translated destination address */
+		inline void put_to(int pid, const void* src, char* dst, size_t nbytes) {
+			int n = mapper->global_to_node(pid);
+			record_comm(pid, nbytes);
+			if (mapper->this_node() == n) {
+				localDeliveries.put((char *)src, dst, nbytes);
+			} else {
+				char * pointer;
+				DelivElement element;
+				element.size = (unsigned int) nbytes;
+				element.info.put.dst = dst;
+				{ 
+					TSLOCK();
+					pointer = (char*)deliveryTable_push(&g_bsp.delivery_table, n, &element, it_put);
+					memcpy(pointer, src, nbytes);
+				}
+			}
+		}
+
+		/** get from a translated source address */
+		inline void get_from(int pid, char* src, long int offset, void* dst, size_t nbytes) {
+			int n = mapper->global_to_node(pid);
+			record_comm(pid, nbytes);
+			if (mapper->this_node() == n) {
+				localDeliveries.get (src + offset, (char*) dst, nbytes);
+			} else {
+				ReqElement elem;
+				elem.size = (unsigned int )nbytes;
+				elem.src = src;
+				elem.dst = (char* )dst;
+				elem.offset = offset;
+				elem.count = 1;
+				elem.info.strided.src_stride = 0;
+				elem.info.strided.dst_stride = 0;
+				{
+					TSLOCK();
+					/* place get command in buffer */
+					requestTable_push(&g_bsp.request_table, n, &elem);
+				}
+			}
+		}
+
 		/** process memory register registrations 
 		 *
 		 * @param reg_req_size : number of push and pop requests.
@@ -319,6 +647,34 @@ namespace bsp {
 
 		static void process_memoryreg_ops(TaskMapper *, int reg_req_size);
 
+		/** deliver node-local channel records and pack remote ones 
+		 *  (see bsp_contextimpl_channels.cpp) */
+		static bool prepare_channels(TaskMapper *);
+
+		/** exchange channel records with other nodes */
+		static void exchange_channels(TaskMapper *);
+
+		/** append count records to the inbox of a channel */
+		static void channel_receive(ChannelBase *, const char *, size_t);
+
+		/** execute the node-local deliveries of all contexts in parallel: 
+		 *  first all gets, then all puts */
+		static void execute_local_deliveries(TaskMapper *);
+		struct LocalDeliveryPhase;
+
+		/** synchronize the contexts of a node-local task mapper */
+		static bool bsp_sync_node_local(TaskMapper *, bool running);
+
+		/** get the node-level data for a task mapper, create it if necessary.
+		 *  Nodes which hold no contexts also need this during synchronization.
+		 */
+		static inline NodeImpl * get_node_impl(TaskMapper * tm) {
+			if (!tm->get_node_impl()) {
+				tm->get_node_impl() = boost::shared_ptr<void> (new NodeImpl);
+			}
+			return (NodeImpl*) tm->get_node_impl().get();
+		}
+
 		int global_pid; ///< global pid
 		int local_pid; ///< local pid 
 
@@ -328,15 +684,28 @@ namespace bsp {
 		bool any_hp;
 
 		/** We reimplement BSPonMPI's registration mechanism here
-		 *  using C++ maps. 
-		 *  
-		 *  TODO, this could probably be done faster somehow.
+		 *  using C++ maps. The addresses on all processors are stored
+		 *  once per node in a NodeMemoryRegister, contexts only map
+		 *  their own registered addresses to registration serials.
 		 */
 		
-		/** all valid memory registers, indexed by ptr */
-		std::map<const void*, MemoryRegister> memory_register_map;
-		/** the same for quick access */
-		ExpandableTable memory_register; 
+		/** registration serial for all valid memory registers, indexed by ptr */
+		std::map<const void*, size_t> memory_register_map;
+
+		/** serials below this one have been used */
+		size_t next_serial;
+
+		/** serials below next_serial which were popped, and are reused 
+		 *  lowest first. All contexts push and pop in the same order, 
+		 *  so they agree on the serials. */
+		std::set<size_t> free_serials;
+
+		/** memoized result of the last lookup */
+		const void * memo_ident;
+		MemoryRegister * memo_row;
+
+		/** data shared by all contexts on this node */
+		NodeImpl * node;
 
 		/** new registrations are buffered here */
 		std::queue< MemoryRegister_Reg > reg_requests;	
@@ -344,6 +713,12 @@ namespace bsp {
 		/** each context can do its node-local deliveries independently. */
 		LocalDeliveryQueue	localDeliveries;
 
+		/** sender-side message combiner, one column per global pid */
+		CombinerTable combiner;
+
+		/** messages dequeued by bsp_messages */
+		std::vector<Message> message_list;
+
 	};
 
 };
@@ -0,0 +1,200 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bsp_contextimpl_channels.cpp
+
+Implementation of typed message channels for Contexts
+
+@author Peter Krusche
+*/
+
+#include "bsp_config.h" 
+
+#ifdef _HAVE_MPI
+#include <mpi.h>
+extern "C" {
+#include "bspx_comm_mpi.h"
+};
+#endif
+
+extern "C" {
+#include "bspx_comm_seq.h"
+};
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "bsp_contextimpl.h"
+
+#include "bsp_cpp/Channel.h"
+
+/** Header for a column of records sent to another node */
+struct ChannelColumnHeader {
+	int local_pid;		///< destination context on the receiving node
+	int channel;		///< channel index in the destination context
+	int count;			///< number of records which follow
+};
+
+/** append count records to a channel inbox */
+void bsp::ContextImpl::channel_receive (ChannelBase * c, const char * data, size_t count) {
+	size_t pos = c->inbox.size();
+	c->inbox.resize (pos + count * c->rsize);
+	memcpy (&c->inbox[pos], data, count * c->rsize);
+	c->inbox_count += count;
+}
+
+/** 
+ * Deliver channel records to contexts on this node, and pack columns for 
+ * other nodes into the node's channel send buffer.
+ * 
+ * The inboxes of all local contexts are emptied first, so records received
+ * in the previous superstep are only valid until the next sync.
+ * 
+ * @return true if any records need to be sent to other nodes
+ */
+bool bsp::ContextImpl::prepare_channels(TaskMapper * mapper) {
+	int local_procs = mapper->procs_this_node();
+	NodeImpl * node = get_node_impl(mapper);
+	int P = mapper->nodes();
+	int me = mapper->this_node();
+
+	node->channel_send_bytes.assign (P, 0);
+	node->channel_send_offsets.assign (P, 0);
+
+	for (int lp = 0; lp < local_procs; ++lp) {
+		std::vector<ChannelBase *> & channels (mapper->get_context(lp)->get_channels());
+		for (size_t c = 0; c < channels.size(); ++c) {
+			channels[c]->inbox.clear();
+			channels[c]->inbox_count = 0;
+		}
+	}
+
+	bool any_remote = false;
+	for (int lp = 0; lp < local_procs; ++lp) {
+		std::vector<ChannelBase *> & channels (mapper->get_context(lp)->get_channels());
+		for (size_t c = 0; c < channels.size(); ++c) {
+			ChannelBase * ch = channels[c];
+			for (size_t j = 0; j < ch->destinations.size(); ++j) {
+				int pid = ch->destinations[j];
+				int n = mapper->global_to_node(pid);
+				std::vector<char> & column (ch->outbox[pid]);
+				if (n == me) {
+					std::vector<ChannelBase *> & dst_channels (
+						mapper->get_context(mapper->global_to_local(pid))->get_channels());
+					ASSERT (c < dst_channels.size() && dst_channels[c]->rsize == ch->rsize);
+					channel_receive (dst_channels[c], &column[0], column.size() / ch->rsize);
+					column.clear();
+				} else {
+					node->channel_send_bytes[n] += (int)(sizeof(ChannelColumnHeader) + column.size());
+					any_remote = true;
+				}
+			}
+		}
+	}
+
+	if (!any_remote) {
+		for (int lp = 0; lp < local_procs; ++lp) {
+			std::vector<ChannelBase *> & channels (mapper->get_context(lp)->get_channels());
+			for (size_t c = 0; c < channels.size(); ++c) {
+				channels[c]->destinations.clear();
+			}
+		}
+		return false;
+	}
+
+	for (int n = 1; n < P; ++n) {
+		node->channel_send_offsets[n] = node->channel_send_offsets[n-1] + node->channel_send_bytes[n-1];
+	}
+	node->channel_sendbuf.resize (node->channel_send_offsets[P-1] + node->channel_send_bytes[P-1]);
+
+	std::vector<int> pos (node->channel_send_offsets);
+	for (int lp = 0; lp < local_procs; ++lp) {
+		std::vector<ChannelBase *> & channels (mapper->get_context(lp)->get_channels());
+		for (size_t c = 0; c < channels.size(); ++c) {
+			ChannelBase * ch = channels[c];
+			for (size_t j = 0; j < ch->destinations.size(); ++j) {
+				int pid = ch->destinations[j];
+				std::vector<char> & column (ch->outbox[pid]);
+				if (column.empty()) {
+					continue;
+				}
+				int n = mapper->global_to_node(pid);
+				ChannelColumnHeader h;
+				h.local_pid = mapper->global_to_local(pid);
+				h.channel = (int) c;
+				h.count = (int)(column.size() / ch->rsize);
+				memcpy (&node->channel_sendbuf[pos[n]], &h, sizeof(ChannelColumnHeader));
+				memcpy (&node->channel_sendbuf[pos[n] + sizeof(ChannelColumnHeader)], &column[0], column.size());
+				pos[n] += (int)(sizeof(ChannelColumnHeader) + column.size());
+				column.clear();
+			}
+			ch->destinations.clear();
+		}
+	}
+	return true;
+}
+
+/**
+ * Exchange the channel columns packed by prepare_channels, and append them 
+ * to the inboxes of the receiving contexts (node-level collective). 
+ */
+void bsp::ContextImpl::exchange_channels(TaskMapper * mapper) {
+	NodeImpl * node = get_node_impl(mapper);
+	int P = mapper->nodes();
+
+	ASSERT ((int)node->channel_send_bytes.size() == P);
+	if (node->channel_sendbuf.empty()) {
+		// nodes with nothing to send still take part in the exchange
+		node->channel_sendbuf.resize (1);
+	}
+
+	std::vector<int> recv_bytes (P), recv_offsets (P, 0);
+	_BSP_COMM0 (&node->channel_send_bytes[0], sizeof(int), &recv_bytes[0], sizeof(int));
+
+	for (int n = 1; n < P; ++n) {
+		recv_offsets[n] = recv_offsets[n-1] + recv_bytes[n-1];
+	}
+	node->channel_recvbuf.resize (std::max (1, recv_offsets[P-1] + recv_bytes[P-1]));
+
+	_BSP_COMM1 (&node->channel_sendbuf[0], &node->channel_send_bytes[0], &node->channel_send_offsets[0],
+		&node->channel_recvbuf[0], &recv_bytes[0], &recv_offsets[0]);
+
+	size_t end = (size_t)(recv_offsets[P-1] + recv_bytes[P-1]);
+	size_t p = 0;
+	while (p < end) {
+		ChannelColumnHeader h;
+		memcpy (&h, &node->channel_recvbuf[p], sizeof(ChannelColumnHeader));
+		p += sizeof(ChannelColumnHeader);
+
+		std::vector<ChannelBase *> & channels (mapper->get_context(h.local_pid)->get_channels());
+		if (h.channel < 0 || h.channel >= (int)channels.size()) {
+			throw std::runtime_error("bsp_sync(): received records for an unknown channel.");
+		}
+		ChannelBase * ch = channels[h.channel];
+		channel_receive (ch, &node->channel_recvbuf[p], (size_t)h.count);
+		p += h.count * ch->rsize;
+	}
+
+	node->channel_send_bytes.assign (P, 0);
+	node->channel_sendbuf.clear();
+}
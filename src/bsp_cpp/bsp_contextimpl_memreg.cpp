@@ -48,108 +48,145 @@ extern "C" {
 
 #include "bsp_tools/Avector.h"
 
-/** Sync memory register operations */
+/** Sync memory register operations 
+ * 
+ * Every node contributes the requests of its local contexts (padded to 
+ * procs_per_node() contexts) to an allgather, so the total volume is 
+ * O(p * ppn * R) rather than the O(p^2 * ppn * R) of replicating the 
+ * requests for every destination in an alltoall.
+ */
 void bsp::ContextImpl::process_memoryreg_ops(TaskMapper * mapper, int reg_req_size) {
 	int ppn = mapper->procs_per_node();
+	int node_reqs = reg_req_size * ppn;
 	utilities::AVector<MemoryRegister_Reg> vs, vr;
-	vs.resize(g_bsp.nprocs * reg_req_size * ppn);
-	vr.resize(g_bsp.nprocs * reg_req_size * ppn);
+	vs.resize(node_reqs);
+	const int nodes = mapper->nodes();
+	vr.resize(nodes * node_reqs);
+	memset(vs.data, 0, node_reqs * sizeof (MemoryRegister_Reg));
 
 	for (int lp = 0; lp < mapper->procs_this_node(); ++lp) {
 		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(lp)->get_impl());
 		int o = lp * reg_req_size;
-		int r = 0;
 		while (!cimpl->reg_requests.empty()) {
-			for (int p = 0; p < g_bsp.nprocs; ++p) {
-				vs[o + r + p * reg_req_size * ppn ] = cimpl->reg_requests.front();
-			}
+			vs[o++] = cimpl->reg_requests.front();
 			cimpl->reg_requests.pop();
-			++r;
 		}
 	}
-	_BSP_COMM0 (
-		vs.data, reg_req_size * ppn * sizeof (MemoryRegister_Reg), 
-		vr.data, reg_req_size * ppn * sizeof (MemoryRegister_Reg) );
-
-	for (int req = 0; req < reg_req_size; ++req) {
-		size_t serial = -1;
-		size_t size = -1;
-		int push_or_pop = -1;
-
-		for (int llp = 0; llp < mapper->procs_this_node(); ++llp) {
-			ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(llp)->get_impl());
-			int my_local_pid = cimpl->local_pid;
-
-			MemoryRegister reg;
-
-			reg.pointers = boost::shared_array<const void*>(new const void * [mapper->nprocs()]);
-
-			MemoryRegister_Reg & my_r (vr[ g_bsp.rank*reg_req_size*ppn + my_local_pid*reg_req_size + req ]);
 
-			for (int gp = 0; gp < mapper->nprocs(); ++gp) {
-				int p = mapper->global_to_node(gp), lp = mapper->global_to_local(gp);
+#ifdef _HAVE_MPI
+	if (!mapper->is_node_local()) {
+		MPI_Allgather(vs.data, node_reqs * sizeof (MemoryRegister_Reg), MPI_BYTE,
+			vr.data, node_reqs * sizeof (MemoryRegister_Reg), MPI_BYTE, bsp_communicator);
+	} else
+#endif
+	memcpy(vr.data, vs.data, node_reqs * sizeof (MemoryRegister_Reg));
 
-				MemoryRegister_Reg & r (vr[ p*reg_req_size*ppn + lp*reg_req_size + req ]);
+	NodeMemoryRegister & nreg (get_node_impl(mapper)->memory_register);
 
-				// Check ordering 
-				if (serial == -1) {
-					serial = r.serial;
-				} else {
-					if (serial != r.serial) {
-						throw std::runtime_error("bsp_sync(): memory register setup sequence mismatch. Pushreg/popreg operations must be collectively called in the correct order.");
-					}
+	for (int req = 0; req < reg_req_size; ++req) {
+		MemoryRegister reg;
+		reg.pointers = boost::shared_array<const void*>(new const void * [mapper->nprocs()]);
+		reg.per_node = true;
+
+		// All registrations are validated and stored once per node.
+		// We compare everything against the request of global pid 0, and 
+		// collect mismatches in a bit mask rather than branching.
+		const MemoryRegister_Reg & r0 (vr[ mapper->global_to_node(0)*node_reqs 
+			+ mapper->global_to_local(0)*reg_req_size + req ]);
+		const size_t serial = r0.serial;
+		const size_t size = r0.size;
+		const bool push = r0.push;
+		int mismatch = 0;
+		bool per_node = true;
+
+		for (int p = 0; p < nodes; ++p) {
+			const MemoryRegister_Reg * RESTRICT rs = vr.data + p*node_reqs + req;
+			for (int lp = 0; lp < ppn; ++lp) {
+				int gp = mapper->local_to_global_pid(p, lp);
+				if (gp < 0) {
+					continue;
 				}
+				const MemoryRegister_Reg & r (rs[lp*reg_req_size]);
+				mismatch |= (r.serial != serial) | ((r.size != size) << 1) | ((r.push != push) << 2);
+				per_node &= r.data == rs[0].data;
+				reg.pointers[gp] = r.data;
+			}
+		}
 
-				// Check size
-				if (size == -1) {
-					size = r.size;
-				} else {
-					if (size != r.size) {
-						throw std::runtime_error("bsp_sync(): memory register setup size mismatch. Pushreg/popreg operations must register blocks of the same size.");
-					}
-				}
+		if (mismatch & 1) {
+			throw std::runtime_error("bsp_sync(): memory register setup sequence mismatch. Pushreg/popreg operations must be collectively called in the correct order.");
+		}
+		if (mismatch & 2) {
+			throw std::runtime_error("bsp_sync(): memory register setup size mismatch. Pushreg/popreg operations must register blocks of the same size.");
+		}
+		if (mismatch & 4) {
+			throw std::runtime_error("bsp_sync(): pushreg/popreg mismatch.");
+		}
+		reg.per_node = per_node;
+		int push_or_pop = push ? 1 : 0;
 
-				// check push or pop
-				if (push_or_pop == -1) {
-					push_or_pop = r.push ? 1 : 0;
-				} else {
-					if (r.push && push_or_pop != 1) {
-						throw std::runtime_error("bsp_sync(): pushreg/popreg mismatch.");
-					}
-					if (!r.push && push_or_pop != 0) {
-						throw std::runtime_error("bsp_sync(): pushreg/popreg mismatch.");
-					}
+		reg.nbytes = size;
+
+		if (push_or_pop == 1) {
+			if (reg.per_node) {
+				boost::shared_array<const void*> per_node (new const void * [nodes]);
+				for (int p = 0; p < nodes; ++p) {
+					per_node[p] = vr[ p*reg_req_size*ppn + req ].data;
 				}
+				reg.pointers = per_node;
+			}
 
-				// save pointer
-				reg.pointers[gp] = r.data;
+			if (nreg.rows.size() <= serial) {
+				nreg.rows.resize(serial + 1);
+			}
+			nreg.rows[serial] = reg;
+		} else {
+			if (serial >= nreg.rows.size() || !nreg.rows[serial].pointers) {
+				throw std::runtime_error("bsp_sync(): mismatched popreg.");
 			}
+			nreg.rows[serial] = MemoryRegister();
+		}
 
-			reg.nbytes = size;
-			reg.serial = serial;
+		for (int llp = 0; llp < mapper->procs_this_node(); ++llp) {
+			ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(llp)->get_impl());
+			MemoryRegister_Reg & my_r (vr[ mapper->this_node()*reg_req_size*ppn + cimpl->local_pid*reg_req_size + req ]);
 
 			if (push_or_pop == 1) {
 				if (cimpl->memory_register_map.find(my_r.data) != cimpl->memory_register_map.end()) {
 					throw std::runtime_error("bsp_sync(): detected duplicate pushreg for the same address.");
 				}
-				cimpl->memory_register_map[my_r.data] = reg; 
-				for (int gp = 0; gp < mapper->nprocs(); ++gp) {
-					memoryRegister_push(&cimpl->memory_register, gp, (const char*)reg.pointers[gp]);
-				}
+				cimpl->memory_register_map[my_r.data] = serial; 
 			} else {
-				memoryRegister_pop(&cimpl->memory_register, cimpl->global_pid, (const char*) my_r.data);
-				std::map<const void *, MemoryRegister>::iterator it = 
+				std::map<const void *, size_t>::iterator it = 
 					cimpl->memory_register_map.find(my_r.data);
 				
-				if (it == cimpl->memory_register_map.end()) {
+				if (it == cimpl->memory_register_map.end() || it->second != serial) {
 					throw std::runtime_error("bsp_sync(): mismatched popreg.");
 				}
 				cimpl->memory_register_map.erase(it);
+
+				// popped serials are reused, and the highest ones are 
+				// dropped so the rows do not grow
+				cimpl->free_serials.insert(serial);
+				while (cimpl->next_serial > 0 && 
+					cimpl->free_serials.erase(cimpl->next_serial - 1) > 0) {
+					--cimpl->next_serial;
+				}
 			}
 		}
 	}
+
+	if (mapper->procs_this_node() > 0) {
+		const size_t used = ((ContextImpl *)(mapper->get_context(0)->get_impl()))->next_serial;
+		if (nreg.rows.size() > used) {
+			nreg.rows.resize(used);
+		}
+	}
+
+	// rows may have moved, reset memoized lookups
 	for (int llp = 0; llp < mapper->procs_this_node(); ++llp) {
 		ContextImpl * cimpl = (ContextImpl *)(mapper->get_context(llp)->get_impl());
-		memoryRegister_pack(&cimpl->memory_register);
+		cimpl->memo_ident = NULL;
+		cimpl->memo_row = NULL;
 	}
 }
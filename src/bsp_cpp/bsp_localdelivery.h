@@ -38,6 +38,11 @@ Implements local delivery. All functions in here are not thread safe.
 
 #include "HeaderQueue.h"
 
+extern "C" {
+#include "bsp_exptable.h"
+#include "bsp_accumulate.h"
+};
+
 namespace bsp {
 	
 
@@ -58,9 +63,30 @@ namespace bsp {
 		size_t nbytes;
 	};
 
+	/** buffered put which is combined with the destination
+	 *  using a reduction operation */
+	struct LocalAccumulateDelivery {
+		size_t offset;
+		char * dst;
+		size_t nbytes;
+		unsigned int op;
+		unsigned int type;
+	};
+
+	/** atomic fetch-and-op or compare-and-swap */
+	struct LocalAtomicDelivery {
+		char * target;
+		char * result;
+		size_t nbytes;
+		unsigned int op;
+		unsigned int type;
+		AtomicRequest values;
+	};
+
 	/** BSMP message headers */
 	struct BSMessage {
 		bool buffered;
+		int source;
 		union {
 			size_t offset;
 			const void * data;
@@ -88,6 +114,38 @@ namespace bsp {
 
 		/** execute all queued deliveries */
 		inline void execute () {
+			execute_gets();
+			execute_atomics();
+			execute_puts();
+			execute_accumulates();
+		}
+
+		/** execute all queued gets. When executing the deliveries of 
+		 *  several contexts, this must be done for all of them before 
+		 *  any puts are executed. */
+		inline void execute_gets () {
+			while (!gets.empty()) {
+				LocalMemoryDelivery & d (gets.head());
+				memcpy (d.dst, d.src, d.nbytes);
+				gets.next();
+			}
+		}
+
+		/** execute all queued atomic operations in the order they were
+		 *  issued. Atomic operations from different contexts may target 
+		 *  the same location, so contexts must execute them one after 
+		 *  the other, after all gets and before any puts. */
+		inline void execute_atomics () {
+			while (!atomics.empty()) {
+				LocalAtomicDelivery & d (atomics.head());
+				accumulate_fetch (d.target, d.result, (const char*) &d.values.operand, 
+					(const char*) &d.values.compare, d.nbytes, d.op, d.type);
+				atomics.next();
+			}
+		}
+
+		/** execute all queued puts */
+		inline void execute_puts () {
 			// unbuffered deliveries.
 			while (!hpputs.empty()) {
 				LocalMemoryDelivery & d (hpputs.head());
@@ -106,6 +164,19 @@ namespace bsp {
 			put_buffer.clear();
 		}
 
+		/** execute all queued accumulates. These may target the same 
+		 *  locations as accumulates from other contexts, so they must 
+		 *  not run concurrently with those. */
+		inline void execute_accumulates () {
+			while (!accumulates.empty()) {
+				LocalAccumulateDelivery & d (accumulates.head());
+				accumulate_apply (d.dst, (const char*) accumulate_buffer.get(d.offset), 
+					d.nbytes, d.op, d.type);
+				accumulates.next();
+			}
+			accumulate_buffer.clear();
+		}
+
 		/** enqueue a put operation */
 		inline void put ( char * src, char * dst, size_t nbytes ) {
 			BufferedLocalMemoryDelivery & d(puts.enqueue());
@@ -114,7 +185,68 @@ namespace bsp {
 			d.offset = put_buffer.buffer(src, nbytes);
 		}
 
-		/** enqueue an unbuffered put operation */
+		/** enqueue a put operation, and return the buffer location the 
+		 *  caller must copy nbytes of data to (before any other operation 
+		 *  is enqueued). */
+		inline char * reserve_put ( char * dst, size_t nbytes ) {
+			BufferedLocalMemoryDelivery & d(puts.enqueue());
+			d.dst = dst;
+			d.nbytes = nbytes;
+			d.offset = put_buffer.reserve(nbytes);
+			return (char*) put_buffer.get_writable(d.offset);
+		}
+
+		/** enqueue a strided put operation. Blocks which are contiguous 
+		 *  at the destination are buffered as a single delivery. */
+		inline void put_strided ( const char * src, long src_stride, 
+			char * dst, long dst_stride, size_t nbytes, unsigned int count ) {
+			if (dst_stride == (long) nbytes) {
+				char * buffer = reserve_put (dst, nbytes * count);
+				for (unsigned int k = 0; k < count; ++k, src += src_stride) {
+					memcpy (buffer + k * nbytes, src, nbytes);
+				}
+			} else {
+				for (unsigned int k = 0; k < count; ++k, src += src_stride, dst += dst_stride) {
+					put ((char*) src, dst, nbytes);
+				}
+			}
+		}
+
+		/** enqueue an accumulate operation */
+		inline void accumulate ( const char * src, char * dst, size_t nbytes, 
+			unsigned int op, unsigned int type ) {
+			LocalAccumulateDelivery & d(accumulates.enqueue());
+			d.dst = dst;
+			d.nbytes = nbytes;
+			d.op = op;
+			d.type = type;
+			d.offset = accumulate_buffer.buffer(src, nbytes);
+		}
+
+		/** enqueue an atomic operation (see accumulate_fetch) */
+		inline void atomic ( char * target, void * result, const void * operand, 
+			const void * compare, size_t nbytes, unsigned int op, unsigned int type ) {
+			LocalAtomicDelivery & d(atomics.enqueue());
+			d.target = target;
+			d.result = (char*) result;
+			d.nbytes = nbytes;
+			d.op = op;
+			d.type = type;
+			memcpy (&d.values.operand, operand, nbytes);
+			if (compare != NULL) {
+				memcpy (&d.values.compare, compare, nbytes);
+			}
+		}
+
+		/** enqueue a get operation, src is read at sync time */
+		inline void get ( const char * src, char * dst, size_t nbytes ) {
+			LocalMemoryDelivery & d(gets.enqueue());
+			d.dst = dst;
+			d.src = src;
+			d.nbytes = nbytes;
+		}
+
+		/** enqueue an unbuffered put operation, src is read at sync time */
 		inline void hpput ( char * src, char * dst, size_t nbytes ) {
 			LocalMemoryDelivery & d(hpputs.enqueue());
 			d.dst = dst;
@@ -122,20 +254,32 @@ namespace bsp {
 			d.nbytes = nbytes;
 		}
 
-		/** enqueue a BSMP message */
-		inline void send( const void * tag, size_t tagsize, const void * data, size_t nbytes ) {
+		/** enqueue a BSMP message
+		 * 
+		 * @return the offset of the buffered payload, see message_payload()
+		 */
+		inline size_t send( int source, const void * tag, size_t tagsize, const void * data, size_t nbytes ) {
 			BSMessage & m (message_send_queue->enqueue());
 			m.buffered = true;
+			m.source = source;
 			m.nbytes = nbytes;
 			m.src.offset = message_send_buffer->buffer(data, nbytes);
 			m.tag.offset = message_send_buffer->buffer(tag, tagsize);
 			bytes_sent+= nbytes;
+			return m.src.offset;
+		}
+
+		/** get the payload of a message enqueued in this superstep 
+		 *  (the address changes when further messages are enqueued) */
+		inline char * message_payload( size_t offset ) {
+			return (char*) message_send_buffer->get_writable(offset);
 		}
 
 		/** enqueue a BSMP message (unbuffered) */
-		inline void hpsend( const void * tag, const void * data, size_t nbytes ) {
+		inline void hpsend( int source, const void * tag, const void * data, size_t nbytes ) {
 			BSMessage & m (message_send_queue->enqueue());
 			m.buffered = false;
+			m.source = source;
 			m.nbytes = nbytes;
 			m.src.data = data;
 			m.tag.data = tag;
@@ -182,6 +326,14 @@ namespace bsp {
 			return m.nbytes;
 		}
 
+		/** get the source pid of the top message
+		 * Queue must not be empty, otherwise, result is undefined.
+		 */
+		inline int bsmp_top_source () {
+			ASSERT(!message_move_queue->empty());
+			return message_move_queue->head().source;
+		}
+
 		/** advance to next BSMP message 
 		 * 
 		 * @return true if such a message exists. false if queue is empty
@@ -210,6 +362,9 @@ namespace bsp {
 
 			puts.reset();
 			hpputs.reset();
+			gets.reset();
+			atomics.reset();
+			accumulates.reset();
 
 			message_send_buffer->clear();
 			message_send_queue->reset();
@@ -220,6 +375,10 @@ namespace bsp {
 			put_buffer.clear();
 			puts.reset();
 			hpputs.reset();
+			gets.reset();
+			atomics.reset();
+			accumulate_buffer.clear();
+			accumulates.reset();
 			messages[0].reset();
 			messages[1].reset();
 			message_buffer[0].clear();
@@ -228,6 +387,24 @@ namespace bsp {
 			bytes_to_move = 0;
 		}
 
+		/** discard all queued deliveries and messages, but keep 
+		 *  the memory of all buffers */
+		inline void clear_buffers () {
+			put_buffer.rewind();
+			puts.clear();
+			hpputs.clear();
+			gets.clear();
+			atomics.clear();
+			accumulate_buffer.rewind();
+			accumulates.clear();
+			messages[0].clear();
+			messages[1].clear();
+			message_buffer[0].rewind();
+			message_buffer[1].rewind();
+			bytes_sent = 0;
+			bytes_to_move = 0;
+		}
+
 	private:
 
 		// buffered put requests
@@ -237,6 +414,16 @@ namespace bsp {
 		// unbuffered put requests
 		utilities::HeaderQueue<LocalMemoryDelivery> hpputs;
 
+		// get requests
+		utilities::HeaderQueue<LocalMemoryDelivery> gets;
+
+		// atomic requests
+		utilities::HeaderQueue<LocalAtomicDelivery> atomics;
+
+		// buffered accumulate requests
+		utilities::HeaderQueue<LocalAccumulateDelivery> accumulates;
+		utilities::MessageBuffer accumulate_buffer;
+
 		// message double-buffer
 		utilities::MessageBuffer message_buffer[2];
 		utilities::HeaderQueue<BSMessage> messages[2];
@@ -0,0 +1,204 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bsp_numa.cpp
+
+NUMA topology discovery and thread binding.
+
+@author Peter Krusche
+*/
+
+#include "bsp_config.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include <algorithm>
+
+#include "bsp_cpp/Numa.h"
+
+#ifdef __linux__
+
+/** Parse a sysfs cpu list like "0-3,8,10-11" */
+static void parse_cpulist (const char * s, std::vector<int> & cpus) {
+	while (*s) {
+		char * e;
+		long a = strtol (s, &e, 10);
+		if (e == s) {
+			break;
+		}
+		long b = a;
+		s = e;
+		if (*s == '-') {
+			b = strtol (s + 1, &e, 10);
+			s = e;
+		}
+		for (long c = a; c <= b; ++c) {
+			cpus.push_back ((int)c);
+		}
+		while (*s == ',' || *s == '\n' || *s == ' ') {
+			++s;
+		}
+	}
+}
+
+/** The CPUs this process was started on (e.g. restricted by mpirun) */
+static cpu_set_t process_cpus;
+
+/** The NUMA node the calling thread is currently bound to */
+static __thread int bound_node = -1;
+
+#endif
+
+/** Read the topology, keeping only nodes which have usable CPUs */
+bsp::NumaTopology::NumaTopology () : ncpus (0) {
+#ifdef __linux__
+	CPU_ZERO (&process_cpus);
+	if (sched_getaffinity (0, sizeof (cpu_set_t), &process_cpus) != 0) {
+		for (int c = 0; c < CPU_SETSIZE; ++c) {
+			CPU_SET (c, &process_cpus);
+		}
+	}
+
+	std::vector<int> node_ids;
+	DIR * d = opendir ("/sys/devices/system/node");
+	if (d != NULL) {
+		struct dirent * de;
+		while ((de = readdir (d)) != NULL) {
+			int id;
+			if (sscanf (de->d_name, "node%d", &id) == 1) {
+				node_ids.push_back (id);
+			}
+		}
+		closedir (d);
+	}
+	std::sort (node_ids.begin(), node_ids.end());
+
+	for (size_t j = 0; j < node_ids.size(); ++j) {
+		char fn [128];
+		char buf [4096];
+		sprintf (fn, "/sys/devices/system/node/node%d/cpulist", node_ids[j]);
+		FILE * f = fopen (fn, "r");
+		if (f == NULL) {
+			continue;
+		}
+		std::vector<int> all, usable;
+		if (fgets (buf, sizeof (buf), f) != NULL) {
+			parse_cpulist (buf, all);
+		}
+		fclose (f);
+
+		for (size_t c = 0; c < all.size(); ++c) {
+			if (all[c] < CPU_SETSIZE && CPU_ISSET (all[c], &process_cpus)) {
+				usable.push_back (all[c]);
+			}
+		}
+		if (!usable.empty()) {
+			node_cpus.push_back (usable);
+			ncpus += (int)usable.size();
+		}
+	}
+
+	if (node_cpus.empty()) {
+		std::vector<int> usable;
+		for (int c = 0; c < CPU_SETSIZE; ++c) {
+			if (CPU_ISSET (c, &process_cpus)) {
+				usable.push_back (c);
+			}
+		}
+		node_cpus.push_back (usable);
+		ncpus = (int)usable.size();
+	}
+#endif
+	if (node_cpus.empty() || ncpus == 0) {
+		node_cpus.clear();
+		node_cpus.push_back (std::vector<int> (1, 0));
+		ncpus = 1;
+	}
+}
+
+bsp::NumaTopology const & bsp::NumaTopology::get () {
+	static NumaTopology t;
+	return t;
+}
+
+/** Local processor i goes to the node of CPU i * total_cpus / n, 
+ *  with CPUs ordered by node. */
+void bsp::NumaTopology::distribute (int n, std::vector<int> & nodes) const {
+	nodes.resize (n);
+	int node = 0;
+	int node_end = (int)node_cpus[0].size();
+	for (int i = 0; i < n; ++i) {
+		int c = (int)( ((long long)i * ncpus) / n );
+		while (c >= node_end) {
+			++node;
+			node_end += (int)node_cpus[node].size();
+		}
+		nodes[i] = node;
+	}
+}
+
+void bsp::numa_bind_thread (int node) {
+#ifdef __linux__
+	if (bound_node == node) {
+		return;
+	}
+	NumaTopology const & t (NumaTopology::get());
+	if (t.nodes() > 1) {
+		cpu_set_t s;
+		CPU_ZERO (&s);
+		std::vector<int> const & cpus (t.cpus(node));
+		for (size_t c = 0; c < cpus.size(); ++c) {
+			CPU_SET (cpus[c], &s);
+		}
+		pthread_setaffinity_np (pthread_self(), sizeof (cpu_set_t), &s);
+	}
+	bound_node = node;
+#endif
+}
+
+void bsp::numa_unbind_thread () {
+#ifdef __linux__
+	if (bound_node < 0) {
+		return;
+	}
+	if (NumaTopology::get().nodes() > 1) {
+		pthread_setaffinity_np (pthread_self(), sizeof (cpu_set_t), &process_cpus);
+	}
+	bound_node = -1;
+#endif
+}
+
+int bsp::numa_bound_node () {
+#ifdef __linux__
+	return bound_node;
+#else
+	return -1;
+#endif
+}
@@ -126,14 +126,63 @@ void bsp::SharedVariableSet::clear_all_children () {
 	}
 }
 
+/** Size of all variables when serialized. Each variable is stored
+ *  as its size followed by its data, padded to 8 bytes. */
+size_t bsp::SharedVariableSet::serialized_size_all () {
+	size_t sz = 0;
+	for (std::map<std::string, Shared*>::iterator it = svl.begin(); 
+		it != svl.end(); ++it) {
+		sz += sizeof(uint64_t) + (((it->second->serialized_size() + 7) >> 3) << 3);
+	}
+	return sz;
+}
+
+/** Serialize all variables */
+void bsp::SharedVariableSet::serialize_all (void * target, size_t nbytes) {
+	char * p = (char*) target;
+	for (std::map<std::string, Shared*>::iterator it = svl.begin(); 
+		it != svl.end(); ++it) {
+		uint64_t sz = it->second->serialized_size();
+		ASSERT (p + sizeof(uint64_t) + sz <= ((char*)target) + nbytes);
+		memcpy(p, &sz, sizeof(uint64_t));
+		p += sizeof(uint64_t);
+		it->second->serialize(p, (size_t)sz);
+		p += ((sz + 7) >> 3) << 3;
+	}
+}
+
+/** Deserialize all variables. The set must contain the same 
+ *  variables as the one which was serialized. */
+void bsp::SharedVariableSet::deserialize_all (void * source, size_t nbytes) {
+	char * p = (char*) source;
+	for (std::map<std::string, Shared*>::iterator it = svl.begin(); 
+		it != svl.end(); ++it) {
+		uint64_t sz;
+		if (p + sizeof(uint64_t) > ((char*)source) + nbytes) {
+			throw std::runtime_error("Inconsistent shared variable sets in deserialize_all.");
+		}
+		memcpy(&sz, p, sizeof(uint64_t));
+		p += sizeof(uint64_t);
+		it->second->deserialize(p, (size_t)sz);
+		p += ((sz + 7) >> 3) << 3;
+	}
+}
+
+/** Nested (node-local) task mappers initialize and reduce without 
+ *  communication. Their values are passed on level by level through
+ *  the shared variables of the enclosing context. */
+static inline bool node_local (bsp::TaskMapper * _mapper) {
+	return _mapper != NULL && _mapper->is_node_local();
+}
+
 /** initialize a single slot */
-void bsp::SharedVariableSet::initialize(const char * slot, int master_node, bsp::TaskMapper * ) {
+void bsp::SharedVariableSet::initialize(const char * slot, int master_node, bsp::TaskMapper * _mapper) {
 	std::map<std::string, Shared*>::iterator it = svl.find(slot);
 	ASSERT(it != svl.end());
 	
 	/** if we initialize from a node, we need to broadcast 
 	 *  all data first */
-	if (bsp_nprocs() > 1 && master_node >= 0) {
+	if (bsp_nprocs() > 1 && master_node >= 0 && !node_local(_mapper)) {
 		bsp::bsp_broadcast(master_node, it->second);
 	}
 	
@@ -142,7 +191,7 @@ void bsp::SharedVariableSet::initialize(const char * slot, int master_node, bsp:
 
 /** reduce a single slot */
 void bsp::SharedVariableSet::reduce(const char * slot, bool global, bsp::TaskMapper * _mapper) {
-	if ( ::bsp_nprocs() > 1 && global ) {
+	if ( ::bsp_nprocs() > 1 && global && !node_local(_mapper) ) {
 		std::set<std::string> s;
 		s.insert(slot);
 		reduce_impl(s, _mapper);
@@ -155,10 +204,10 @@ void bsp::SharedVariableSet::reduce(const char * slot, bool global, bsp::TaskMap
 }
 
 /** run all initializers */
-void bsp::SharedVariableSet::initialize_all( int master_node, bsp::TaskMapper *  ) {
+void bsp::SharedVariableSet::initialize_all( int master_node, bsp::TaskMapper * _mapper ) {
 	/** if we initialize from a node, we need to broadcast 
 	 *  all data first */
-	if (bsp_nprocs() > 1 && master_node >= 0) {
+	if (bsp_nprocs() > 1 && master_node >= 0 && !node_local(_mapper)) {
 		SerializedDataset dataset ((int)initialize_list.size());
 
 		/** Step 1: serialize all elements on master node */
@@ -220,7 +269,7 @@ void bsp::SharedVariableSet::reduce_impl(
 	}
 
 #ifdef _HAVE_MPI
-	if (bsp_nprocs() > 1) {
+	if (bsp_nprocs() > 1 && !node_local(_mapper)) {
 		int myelems [2] = {
 			(int)sds.elements(),
 			(int) sds.size()
@@ -0,0 +1,645 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bsp_taskmapper.cpp
+
+Remapping of virtual processors, and the load-balancing and 
+communication-aware task mappers.
+
+@author Peter Krusche
+*/
+
+#include "bsp_config.h"
+
+#ifdef _HAVE_MPI
+#include <mpi.h>
+extern "C" {
+#include "bspx_comm_mpi.h"
+};
+#endif
+
+extern "C" {
+#include "bspx_comm_seq.h"
+};
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <stdexcept>
+
+#include "bsp_contextimpl.h"
+
+#include "bsp_cpp/TaskMapper.h"
+#include "bsp_cpp/Context.h"
+#include "bsp_cpp/Channel.h"
+#include "bsp_cpp/LoadBalancingTaskMapper.h"
+#include "bsp_cpp/CommunicationAwareTaskMapper.h"
+
+#include "bsp_tools/Avector.h"
+
+/** Header of a migrating context */
+struct MigrationHeader {
+	uint64_t global_pid;
+	uint64_t nbytes;		///< size of the shared variable data following the header
+	uint64_t next_serial;
+};
+
+/** The volume between a pair of processors, from < to */
+struct CommEntry {
+	int from;
+	int to;
+	double bytes;
+};
+
+static bool comm_entry_less (CommEntry const & a, CommEntry const & b) {
+	return a.from < b.from || (a.from == b.from && a.to < b.to);
+}
+
+/**
+ * Move virtual processors to different nodes.
+ *
+ * Local pids on every node are assigned in order of increasing global pid.
+ * Migrating contexts are serialized as a MigrationHeader followed by their
+ * shared variables, and exchanged in a single all-to-all.
+ */
+void bsp::TaskMapper::remap (std::vector<int> const & nodes) {
+	using namespace std;
+	const int P = node_count;
+	const int me = node_rank;
+
+	if ((int)nodes.size() != processors) {
+		throw std::runtime_error("TaskMapper::remap(): wrong number of processors.");
+	}
+
+	vector<int> local_pids (processors), counts (P, 0);
+	for (int p = 0; p < processors; ++p) {
+		if (nodes[p] < 0 || nodes[p] >= P) {
+			throw std::runtime_error("TaskMapper::remap(): invalid node.");
+		}
+		local_pids[p] = counts[nodes[p]]++;
+	}
+
+	// node-local mappers have nothing to move
+	if (node_local) {
+		return;
+	}
+
+	// serialize outgoing contexts
+	vector<int> send_bytes (P, 0), send_offsets (P, 0);
+	vector<int> recv_bytes (P, 0), recv_offsets (P, 0);
+	vector<bool> outgoing (procs_on_this_node, false);
+
+	// contexts which cannot move are reported to all nodes in the count 
+	// exchange, so all nodes throw together
+	enum { MIGRATION_OK, MIGRATION_REGISTERED, MIGRATION_MESSAGES };
+	int failure = MIGRATION_OK;
+
+	for (int lp = 0; lp < procs_on_this_node; ++lp) {
+		int gp = local_to_global_pid(lp);
+		if (nodes[gp] == me) {
+			continue;
+		}
+		Context * c = context_store[lp];
+		ContextImpl * ci = (ContextImpl*) c->get_impl();
+		if (!ci->memory_register_map.empty() || !ci->reg_requests.empty()) {
+			failure = max(failure, (int)MIGRATION_REGISTERED);
+			continue;
+		}
+		if (ci->localDeliveries.bsmp_qsize() > 0) {
+			failure = max(failure, (int)MIGRATION_MESSAGES);
+			continue;
+		}
+		outgoing[lp] = true;
+		send_bytes[nodes[gp]] += (int)(sizeof(MigrationHeader) + c->context_sharing.serialized_size_all());
+	}
+
+	for (int n = 1; n < P; ++n) {
+		send_offsets[n] = send_offsets[n-1] + send_bytes[n-1];
+	}
+
+	utilities::AVector<char> sendbuf, recvbuf;
+	sendbuf.resize(send_offsets[P-1] + send_bytes[P-1]);
+
+	{
+		vector<int> pos (send_offsets);
+		for (int lp = 0; lp < procs_on_this_node; ++lp) {
+			if (!outgoing[lp]) {
+				continue;
+			}
+			Context * c = context_store[lp];
+			ContextImpl * ci = (ContextImpl*) c->get_impl();
+			int gp = local_to_global_pid(lp);
+			int n = nodes[gp];
+
+			MigrationHeader h;
+			h.global_pid = gp;
+			h.nbytes = c->context_sharing.serialized_size_all();
+			h.next_serial = ci->next_serial;
+			memcpy(sendbuf.data + pos[n], &h, sizeof(MigrationHeader));
+			c->context_sharing.serialize_all(sendbuf.data + pos[n] + sizeof(MigrationHeader), (size_t)h.nbytes);
+			pos[n] += (int)(sizeof(MigrationHeader) + h.nbytes);
+		}
+	}
+
+	vector<int> send_info (2 * P), recv_info (2 * P);
+	for (int n = 0; n < P; ++n) {
+		send_info[2*n] = send_bytes[n];
+		send_info[2*n + 1] = failure;
+	}
+	_BSP_COMM0 (&send_info[0], 2 * sizeof(int), &recv_info[0], 2 * sizeof(int));
+	for (int n = 0; n < P; ++n) {
+		recv_bytes[n] = recv_info[2*n];
+		failure = max(failure, recv_info[2*n + 1]);
+	}
+	if (failure == MIGRATION_REGISTERED) {
+		throw std::runtime_error("TaskMapper::remap(): cannot move contexts which have registered memory.");
+	}
+	if (failure == MIGRATION_MESSAGES) {
+		throw std::runtime_error("TaskMapper::remap(): cannot move contexts which have unread messages.");
+	}
+
+	for (int n = 1; n < P; ++n) {
+		recv_offsets[n] = recv_offsets[n-1] + recv_bytes[n-1];
+	}
+	recvbuf.resize(recv_offsets[P-1] + recv_bytes[P-1]);
+
+	_BSP_COMM1 (sendbuf.data, &send_bytes[0], &send_offsets[0],
+		recvbuf.data, &recv_bytes[0], &recv_offsets[0]);
+
+	// rebuild tables, and move staying contexts to their new local pid
+	Context * parent = contextfactory->get_parent();
+	parent->context_sharing.clear_all_children();
+
+	vector<Context*> staying;
+	for (int lp = 0; lp < procs_on_this_node; ++lp) {
+		if (outgoing[lp]) {
+			contextfactory->destroy(context_store[lp]);
+		} else {
+			staying.push_back(context_store[lp]);
+		}
+	}
+
+	build_tables (nodes, local_pids);
+
+	context_store.clear();
+	context_store.resize(procs_on_this_node, NULL);
+
+	for (size_t j = 0; j < staying.size(); ++j) {
+		Context * c = staying[j];
+		ContextImpl * ci = (ContextImpl*) c->get_impl();
+		int lp = where_is_local_here[c->pid];
+		ASSERT (lp >= 0);
+		c->local_pid = lp;
+		ci->local_pid = lp;
+		context_store[lp] = c;
+	}
+
+	// create incoming contexts
+	for (char * p = recvbuf.data, * p_end = recvbuf.data + recvbuf.exact_size(); p < p_end; ) {
+		MigrationHeader h;
+		memcpy(&h, p, sizeof(MigrationHeader));
+		p += sizeof(MigrationHeader);
+
+		Context * c = create_context( (int)h.global_pid );
+		((ContextImpl*) c->get_impl())->next_serial = (size_t)h.next_serial;
+		c->context_sharing.deserialize_all(p, (size_t)h.nbytes);
+		p += h.nbytes;
+
+		context_store[c->local_pid] = c;
+	}
+
+	// creating contexts has linked them to the parent already. Reconnect
+	// all of them so children appear in local pid order.
+	parent->context_sharing.clear_all_children();
+	for (int lp = 0; lp < procs_on_this_node; ++lp) {
+		ASSERT (context_store[lp] != NULL);
+		parent->context_sharing.add_as_children( context_store[lp]->context_sharing );
+	}
+
+	step_times.clear();
+	step_times.resize(procs_on_this_node, 0);
+	set_measure_comm (measure_comm);
+}
+
+/**
+ * Reset contexts for reuse.
+ */
+void bsp::TaskMapper::reset_contexts () {
+	if (node_impl) {
+		((NodeImpl*) node_impl.get())->memory_register.rows.clear();
+	}
+	for (int lp = 0; lp < procs_on_this_node; ++lp) {
+		Context * c = context_store[lp];
+		((ContextImpl*) c->get_impl())->reset_state();
+		std::vector<ChannelBase *> & channels (c->get_channels());
+		for (size_t j = 0; j < channels.size(); ++j) {
+			channels[j]->clear();
+		}
+		{
+			// first touch of reinitialized memory on the context's node
+			NumaBinding binding (numa_affinity, numa_affinity ? numa_nodes[lp] : -1);
+			c->init();
+		}
+		c->reset();
+	}
+	std::fill (step_times.begin(), step_times.end(), 0.0);
+	for (size_t lp = 0; lp < comm_bytes.size(); ++lp) {
+		comm_bytes[lp].clear();
+	}
+}
+
+/**
+ * Nest this mapper inside a task-level context.
+ */
+void bsp::TaskMapper::set_enclosing (Context * c) {
+	if (!node_local) {
+		throw std::runtime_error("TaskMapper::set_enclosing(): nested task mappers must be node-local.");
+	}
+	if (c == NULL || !c->bsp_is_task_level()) {
+		throw std::runtime_error("TaskMapper::set_enclosing(): nested runners must be created at task level.");
+	}
+	enclosing = c;
+	level = c->get_mapper()->get_level() + 1;
+}
+
+/**
+ * Sum up the measured compute times of all processors.
+ */
+void bsp::LoadBalancingTaskMapper::collect_load () {
+	std::vector<double> local_load (nprocs(), 0.0);
+	for (int lp = 0; lp < procs_this_node(); ++lp) {
+		local_load[local_to_global_pid(lp)] = step_times[lp];
+	}
+
+	load.resize (nprocs());
+#ifdef _HAVE_MPI
+	if (!is_node_local()) {
+		MPI_Allreduce (&local_load[0], &load[0], nprocs(), MPI_DOUBLE, MPI_SUM, bsp_communicator);
+	} else {
+		load = local_load;
+	}
+#else
+	load = local_load;
+#endif
+	std::fill (step_times.begin(), step_times.end(), 0.0);
+}
+
+/**
+ * Greedy assignment: processors are placed in order of decreasing load
+ * on the node with the smallest load so far.
+ */
+void bsp::LoadBalancingTaskMapper::assign (std::vector<double> const & load, std::vector<int> & nodes) {
+	using namespace std;
+	const int P = this->nodes();
+	// limit the number of contexts per node to twice the balanced number
+	const int max_per_node = ICD (nprocs(), P) * 2;
+
+	vector< pair<double, int> > order (nprocs());
+	for (int p = 0; p < nprocs(); ++p) {
+		// ties are broken by pid to get the same result on every node
+		order[p] = make_pair(-load[p], p);
+	}
+	sort (order.begin(), order.end());
+
+	vector<double> node_load (P, 0.0);
+	vector<int> node_count (P, 0);
+	for (int j = 0; j < nprocs(); ++j) {
+		int p = order[j].second;
+		int best = nodes[p];
+		for (int n = 0; n < P; ++n) {
+			if (node_count[n] >= max_per_node) {
+				continue;
+			}
+			if (node_count[best] >= max_per_node || node_load[n] < node_load[best]) {
+				best = n;
+			}
+		}
+		nodes[p] = best;
+		node_load[best] += load[p];
+		++node_count[best];
+	}
+}
+
+/**
+ * Rebalance if this improves the maximum node load sufficiently.
+ */
+void bsp::LoadBalancingTaskMapper::rebalance () {
+	using namespace std;
+	const int P = nodes();
+
+	collect_load ();
+
+	vector<int> nodes (nprocs());
+	vector<double> old_load (P, 0.0), new_load (P, 0.0);
+	for (int p = 0; p < nprocs(); ++p) {
+		nodes[p] = global_to_node(p);
+		old_load[nodes[p]] += load[p];
+	}
+
+	assign (load, nodes);
+
+	for (int p = 0; p < nprocs(); ++p) {
+		new_load[nodes[p]] += load[p];
+	}
+
+	double old_max = *max_element(old_load.begin(), old_load.end());
+	double new_max = *max_element(new_load.begin(), new_load.end());
+
+	if (new_max < (1.0 - min_gain) * old_max) {
+		remap (nodes);
+	}
+}
+
+/**
+ * Sum up the communication volumes of all processors, and make the 
+ * graph symmetric. Only the pairs which communicated are exchanged.
+ */
+void bsp::CommunicationAwareTaskMapper::collect_graph () {
+	using namespace std;
+	const int V = nprocs();
+	vector<CommEntry> local, all;
+	for (int lp = 0; lp < procs_this_node(); ++lp) {
+		int gp = local_to_global_pid(lp);
+		for (map<int, double>::const_iterator it = comm_bytes[lp].begin(); 
+			it != comm_bytes[lp].end(); ++it) {
+			if (it->first != gp && it->second > 0) {
+				CommEntry e = { min (gp, it->first), max (gp, it->first), it->second };
+				local.push_back (e);
+			}
+		}
+		comm_bytes[lp].clear();
+	}
+
+#ifdef _HAVE_MPI
+	if (!is_node_local()) {
+		const int P = nodes();
+		int nbytes = (int)(local.size() * sizeof(CommEntry));
+		vector<int> counts (P), offsets (P, 0);
+		MPI_Allgather (&nbytes, 1, MPI_INT, &counts[0], 1, MPI_INT, bsp_communicator);
+		for (int n = 1; n < P; ++n) {
+			offsets[n] = offsets[n-1] + counts[n-1];
+		}
+		all.resize ((offsets[P-1] + counts[P-1]) / sizeof(CommEntry));
+		MPI_Allgatherv (local.empty() ? NULL : &local[0], nbytes, MPI_BYTE, 
+			all.empty() ? NULL : &all[0], &counts[0], &offsets[0], MPI_BYTE, bsp_communicator);
+	} else {
+		all = local;
+	}
+#else
+	all = local;
+#endif
+
+	// merge both directions of every pair. Edges are added in order, so
+	// the adjacency lists are sorted by pid.
+	sort (all.begin(), all.end(), comm_entry_less);
+	graph.assign (V, vector< pair<int, double> > ());
+	for (size_t e = 0; e < all.size(); ) {
+		const int i = all[e].from, j = all[e].to;
+		double bytes = 0;
+		for (; e < all.size() && all[e].from == i && all[e].to == j; ++e) {
+			bytes += all[e].bytes;
+		}
+		graph[i].push_back (make_pair (j, bytes));
+		graph[j].push_back (make_pair (i, bytes));
+	}
+}
+
+/**
+ * Bytes communicated between nodes
+ */
+double bsp::CommunicationAwareTaskMapper::internode_volume (std::vector<int> const & nodes) const {
+	double vol = 0;
+	for (size_t i = 0; i < graph.size(); ++i) {
+		for (size_t l = 0; l < graph[i].size(); ++l) {
+			const int j = graph[i][l].first;
+			if ((int)i < j && nodes[i] != nodes[j]) {
+				vol += graph[i][l].second;
+			}
+		}
+	}
+	return vol;
+}
+
+/**
+ * Volume between processors i and j
+ */
+double bsp::CommunicationAwareTaskMapper::edge_volume (int i, int j) const {
+	std::vector< std::pair<int, double> >::const_iterator it = 
+		std::lower_bound (graph[i].begin(), graph[i].end(), std::make_pair (j, 0.0));
+	return it != graph[i].end() && it->first == j ? it->second : 0.0;
+}
+
+/**
+ * Volume between processor i and every part it is connected to
+ */
+void bsp::CommunicationAwareTaskMapper::part_volumes (int i, std::vector<int> const & part, 
+	std::map<int, double> & volumes) const {
+	volumes.clear();
+	for (size_t l = 0; l < graph[i].size(); ++l) {
+		volumes[part[graph[i][l].first]] += graph[i][l].second;
+	}
+}
+
+/**
+ * Greedy graph growing followed by swap refinement on the boundaries 
+ * between parts.
+ */
+void bsp::CommunicationAwareTaskMapper::assign (std::vector<int> & nodes) {
+	using namespace std;
+	const int V = nprocs();
+	const int N = this->nodes();
+	const int mppn = ICD (V, N);
+
+	// parts are started from the unassigned processor with the largest 
+	// total volume
+	vector<double> total (V, 0.0);
+	vector< pair<double, int> > seeds (V);
+	for (int i = 0; i < V; ++i) {
+		for (size_t l = 0; l < graph[i].size(); ++l) {
+			total[i] += graph[i][l].second;
+		}
+		seeds[i] = make_pair (-total[i], i);
+	}
+	sort (seeds.begin(), seeds.end());
+
+	// then we add the processor which is most strongly connected to the 
+	// part. The queue holds ((volume to the part, total), -pid), entries 
+	// whose volume has changed since are skipped.
+	typedef pair< pair<double, double>, int > Candidate;
+	vector<int> part (V, -1);
+	vector<double> conn (V, 0.0);
+	vector<int> touched;
+	size_t next_seed = 0;
+
+	for (int k = 0; k < N; ++k) {
+		int cap = min (mppn, max (0, V - k * mppn));
+		priority_queue<Candidate> queue;
+		for (int c = 0; c < cap; ++c) {
+			int best = -1;
+			while (!queue.empty()) {
+				Candidate top = queue.top();
+				queue.pop();
+				if (part[-top.second] < 0 && conn[-top.second] == top.first.first) {
+					best = -top.second;
+					break;
+				}
+			}
+			if (best < 0) {
+				while (part[seeds[next_seed].second] >= 0) {
+					++next_seed;
+				}
+				best = seeds[next_seed].second;
+			}
+			part[best] = k;
+			for (size_t l = 0; l < graph[best].size(); ++l) {
+				const int j = graph[best][l].first;
+				if (part[j] >= 0) {
+					continue;
+				}
+				conn[j] += graph[best][l].second;
+				touched.push_back (j);
+				queue.push (Candidate (make_pair (conn[j], total[j]), -j));
+			}
+		}
+		for (size_t l = 0; l < touched.size(); ++l) {
+			conn[touched[l]] = 0;
+		}
+		touched.clear();
+	}
+
+	double cut = internode_volume (part);
+
+	// refine by swapping processors between parts which are connected,
+	// until a pass gains less than min_gain of the inter-node volume
+	map<int, double> vi, vj;
+	for (int pass = 0; pass < max_refine_passes; ++pass) {
+		// candidates[(a, b)] : processors in part a which are connected
+		// to part b, with the gain of moving them there
+		map< pair<int, int>, vector< pair<double, int> > > candidates;
+		for (int i = 0; i < V; ++i) {
+			part_volumes (i, part, vi);
+			const int a = part[i];
+			const double own = vi[a];
+			for (map<int, double>::const_iterator it = vi.begin(); it != vi.end(); ++it) {
+				if (it->first != a) {
+					candidates[make_pair (a, it->first)].push_back (
+						make_pair (own - it->second, i));
+				}
+			}
+		}
+
+		double pass_gain = 0;
+		vector<bool> moved (V, false);
+		for (map< pair<int, int>, vector< pair<double, int> > >::iterator it = candidates.begin();
+			it != candidates.end(); ++it) {
+			const int a = it->first.first, b = it->first.second;
+			map< pair<int, int>, vector< pair<double, int> > >::iterator other = 
+				candidates.find (make_pair (b, a));
+			if (a > b || other == candidates.end()) {
+				continue;
+			}
+
+			// pair the processors with the largest gains on both sides
+			vector< pair<double, int> > & from_a = it->second, & from_b = other->second;
+			sort (from_a.begin(), from_a.end());
+			sort (from_b.begin(), from_b.end());
+			for (size_t x = 0, y = 0; x < from_a.size() && y < from_b.size(); ) {
+				const int i = from_a[x].second, j = from_b[y].second;
+				if (moved[i] || part[i] != a) {
+					++x;
+					continue;
+				}
+				if (moved[j] || part[j] != b) {
+					++y;
+					continue;
+				}
+				part_volumes (i, part, vi);
+				part_volumes (j, part, vj);
+				double gain = vi[b] - vi[a] + vj[a] - vj[b] - 2 * edge_volume (i, j);
+				if (gain <= 0) {
+					break;
+				}
+				part[i] = b;
+				part[j] = a;
+				moved[i] = moved[j] = true;
+				pass_gain += gain;
+				++x;
+				++y;
+			}
+		}
+		if (pass_gain <= min_gain * cut) {
+			break;
+		}
+		cut -= pass_gain;
+	}
+
+	// label parts with nodes, keeping as many processors in place as possible
+	vector< pair<int, pair<int, int> > > overlap;
+	{
+		vector<int> ov (N * N, 0);
+		for (int i = 0; i < V; ++i) {
+			++ov[part[i] * N + nodes[i]];
+		}
+		for (int k = 0; k < N; ++k) {
+			for (int n = 0; n < N; ++n) {
+				overlap.push_back (make_pair (-ov[k * N + n], make_pair (k, n)));
+			}
+		}
+	}
+	sort (overlap.begin(), overlap.end());
+
+	vector<int> label (N, -1);
+	vector<bool> used (N, false);
+	for (size_t j = 0; j < overlap.size(); ++j) {
+		int k = overlap[j].second.first;
+		int n = overlap[j].second.second;
+		if (label[k] < 0 && !used[n]) {
+			label[k] = n;
+			used[n] = true;
+		}
+	}
+
+	for (int i = 0; i < V; ++i) {
+		nodes[i] = label[part[i]];
+	}
+}
+
+/**
+ * Re-partition if this reduces inter-node communication sufficiently.
+ */
+void bsp::CommunicationAwareTaskMapper::rebalance () {
+	collect_graph ();
+
+	std::vector<int> nodes (nprocs());
+	for (int p = 0; p < nprocs(); ++p) {
+		nodes[p] = global_to_node(p);
+	}
+
+	double old_volume = internode_volume (nodes);
+	assign (nodes);
+	double new_volume = internode_volume (nodes);
+
+	if (new_volume < (1.0 - min_gain) * old_volume) {
+		remap (nodes);
+	}
+}
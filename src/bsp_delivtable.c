@@ -28,6 +28,112 @@ Implements the methods on a DeliveryTable object
 #include "bsp_exptable.h"
 #include "bsp_memreg.h"
 #include "bsp_mesgqueue.h"
+#include "bsp_accumulate.h"
+#include "bsp_delivtable.h"
+
+/** Scatters the blocks of a vectored put
+@param dst Destination address
+@param vector descriptor, followed by the data
+*/
+static void
+	putVector_execute (char * RESTRICT dst, const PutVector * RESTRICT vector)
+{
+	unsigned int k;
+	const char * RESTRICT data;
+
+	if (vector->blocksize > 0)
+	{
+		data = (const char *) (vector + 1);
+		if (vector->stride == (long) vector->blocksize)
+			memcpy(dst, data, vector->nblocks * vector->blocksize);
+		else
+			for (k = 0; k < vector->nblocks; k++, data += vector->blocksize, dst += vector->stride)
+				memcpy(dst, data, vector->blocksize);
+	}
+	else
+	{
+		const PutBlock * RESTRICT blocks = (const PutBlock *) (vector + 1);
+		data = (const char *) (blocks + vector->nblocks);
+		for (k = 0; k < vector->nblocks; k++)
+		{
+			memcpy(dst + blocks[k].offset, data, blocks[k].nbytes);
+			data += blocks[k].nbytes;
+		}
+	}
+}
+
+/** Scatters the values of a batch of puts
+@param dst Destination address
+@param batch descriptor, followed by the offsets and the values
+*/
+static void
+	putBatch_execute (char * RESTRICT dst, const PutBatch * RESTRICT batch)
+{
+	unsigned int k;
+	const long * RESTRICT offsets = (const long *) (batch + 1);
+	const char * RESTRICT data = (const char *) (offsets + batch->count);
+
+	/* word-sized values use a memcpy of constant size, which the compiler
+	   can replace by a single load and store */
+	switch (batch->nbytes)
+	{
+	case sizeof(double):
+		for (k = 0; k < batch->count; k++, data += sizeof(double))
+			memcpy(dst + offsets[k], data, sizeof(double));
+		break;
+	case sizeof(int):
+		for (k = 0; k < batch->count; k++, data += sizeof(int))
+			memcpy(dst + offsets[k], data, sizeof(int));
+		break;
+	default:
+		for (k = 0; k < batch->count; k++, data += batch->nbytes)
+			memcpy(dst + offsets[k], data, batch->nbytes);
+	}
+}
+
+/** Performs the puts, vectored puts and batched puts in one column of a
+* DeliveryTable
+@param column the first slot of the column
+@param start index of the first element of every type
+@param count number of elements of every type
+*/
+void
+	deliveryColumn_execute_puts (const ALIGNED_TYPE * RESTRICT column,
+	const unsigned int * RESTRICT start, const unsigned int * RESTRICT count)
+{
+	unsigned int i;
+	const DelivElement *RESTRICT element;
+	const ALIGNED_TYPE * RESTRICT pointer;
+	const unsigned int tag_size = 
+		no_slots(sizeof(DelivElement), sizeof(ALIGNED_TYPE));
+
+	/* do put's */
+	pointer = column + start[it_put];
+	for (i = 0; i < count[it_put]; i++)
+	{
+		element = (DelivElement *) pointer;
+		memcpy(element->info.put.dst, pointer + tag_size, element->size);
+		pointer+=element->next;
+	}  
+
+	/* do vectored put's */
+	pointer = column + start[it_putv];
+	for (i = 0; i < count[it_putv]; i++)
+	{
+		element = (DelivElement *) pointer;
+		putVector_execute(element->info.put.dst, (const PutVector *) (pointer + tag_size));
+		pointer+=element->next;
+	}  
+
+	/* do batched put's */
+	pointer = column + start[it_putb];
+	for (i = 0; i < count[it_putb]; i++)
+	{
+		element = (DelivElement *) pointer;
+		putBatch_execute(element->info.put.dst, (const PutBatch *) (pointer + tag_size));
+		pointer+=element->next;
+	}  
+}
 
 /** Executes a DeliveryTable object, i.e.: performs all the actions to be
 * taken when a DeliveryTable is received 
@@ -35,12 +141,15 @@ Implements the methods on a DeliveryTable object
 @param memreg Reference to a MemoryRegister
 @param mesgq Reference to a MessageQueue
 @param rank Rank of this processor
+@param before_column called before the puts of every column, or NULL
+@param arg passed to \a before_column
 */
 
 void
 	deliveryTable_execute (ExpandableTable * RESTRICT table, 
 	ExpandableTable * RESTRICT memreg, 
-	MessageQueue * RESTRICT mesgq, const int rank)
+	MessageQueue * RESTRICT mesgq, const int rank,
+	DeliveryColumnHook before_column, void * arg)
 {
 	unsigned int p, i;
 	const DelivElement *RESTRICT element;
@@ -51,16 +160,10 @@ void
 
 	for (p = 0; p < table->nprocs; p++)
 	{
-		/* do put's */
-		pointer = (ALIGNED_TYPE *) table->data + p * table->rows + 
-			table->info.deliv.start[p][it_put] ;
-
-		for (i = 0; i < table->info.deliv.count[p][it_put]; i++)
-		{
-			element = (DelivElement *) pointer;
-			memcpy(element->info.put.dst, pointer + tag_size, element->size);
-			pointer+=element->next;
-		}  
+		if (before_column != NULL)
+			before_column(arg, p);
+		deliveryColumn_execute_puts((const ALIGNED_TYPE *) table->data + p * table->rows,
+			table->info.deliv.start[p], table->info.deliv.count[p]);
 
 		/* do pushreg's */	
 		pointer = (ALIGNED_TYPE *) table->data + p * table->rows + 
@@ -92,6 +195,23 @@ void
 	}   
 	/* get's aren't supposed to be in this queue */
 
+	/* do accumulating put's after all other put's, in order of source */
+	for (p = 0; p < table->nprocs; p++)
+	{
+		pointer = (ALIGNED_TYPE *) table->data + p * table->rows + 
+			table->info.deliv.start[p][it_putacc] ;
+
+		for (i = 0; i < table->info.deliv.count[p][it_putacc]; i++)
+		{
+			const PutAccumulate * RESTRICT acc;
+			element = (DelivElement *) pointer;
+			acc = (const PutAccumulate *) (pointer + tag_size);
+			accumulate_apply(element->info.put.dst, (const char *) (acc + 1), 
+				element->size - sizeof(PutAccumulate), acc->op, acc->type);
+			pointer+=element->next;
+		}  
+	}
+
 	/* do popreg's (they only appear in processor column 'rank') */
 	pointer = (ALIGNED_TYPE *) table->data + rank * table->rows +
 		table->info.deliv.start[rank][it_popreg];
@@ -46,8 +46,8 @@ type. The tag does not store what type of action it represents, because
 DeliveryTable knows where to find the first action of a certain type
 (\ref DelivInfo ) .
 Subsequent actions are referenced by the \c next value in the tag. In
-other words: Each column stores 6 linked lists of actions (pushreg,
-popreg, put, get, send, settag). Information about these linked lists (the
+other words: Each column stores a linked list for every type of action (pushreg,
+popreg, put, get, send, settag, putv, putb, putacc). Information about these linked lists (the
 arrays referenced in \ref DelivInfo) are stored at the top of the columns.
 This way, the information is automatically communicated to the receiving
 processors.
@@ -61,13 +61,27 @@ and therefore they have been made unnecessary by these linked lists.
 @author Wijnand Suijlen
 */  
 
+#include "bsp.h"
 #include "bsp_config.h"
 #include "bsp_exptable.h"
 #include "bsp_mesgqueue.h"
 
+/** number of slots at the top of each column which hold the start, count
+ *  and end of each type of action */
+#define DELIVTABLE_INDEX_SIZE \
+	no_slots(3 * it_count * sizeof(unsigned int), sizeof(ALIGNED_TYPE))
+
+/** called by deliveryTable_execute() before the puts of every column,
+ *  with the source processor of the column */
+typedef void (*DeliveryColumnHook) (void * arg, unsigned int pid);
+
 void
 	deliveryTable_execute (ExpandableTable *RESTRICT , ExpandableTable *RESTRICT ,
-	MessageQueue *RESTRICT, const int );
+	MessageQueue *RESTRICT, const int, DeliveryColumnHook, void * );
+
+void
+	deliveryColumn_execute_puts (const ALIGNED_TYPE *RESTRICT ,
+	const unsigned int *RESTRICT , const unsigned int *RESTRICT );
 
 /** initializes a DeliveryTable object 
 @param table Reference to a DeliveryTable
@@ -80,8 +94,7 @@ static inline void
 {
 	union SpecInfo info;
 	int p;
-	const int index_size = 
-		no_slots(3 * 6 * sizeof(unsigned int), sizeof(ALIGNED_TYPE));
+	const int index_size = DELIVTABLE_INDEX_SIZE;
 
 	/* allocate memory */
 	info.deliv.count = (unsigned int * * ) bsp_malloc( nprocs, sizeof(unsigned int *));
@@ -95,9 +108,9 @@ static inline void
 		table->info.deliv.start[p] = (unsigned int *)
 			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) ;
 		table->info.deliv.count[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 6 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + it_count ;
 		table->info.deliv.end[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 12 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 2 * it_count ;
 
 		memset((ALIGNED_TYPE *) table->data + p * table->rows , 0, sizeof(ALIGNED_TYPE) * index_size );
 		/* don't overwrite this information */
@@ -113,8 +126,7 @@ static inline void
 {
 	/* reset the index */
 	unsigned int p;
-	const int index_size = 
-		no_slots(3 * 6 * sizeof(unsigned int), sizeof(ALIGNED_TYPE));
+	const int index_size = DELIVTABLE_INDEX_SIZE;
 
 	expandableTable_reset(table);
 	for (p = 0; p < table->nprocs; p++)
@@ -129,8 +141,7 @@ static inline void
  @param table Reference to a DeliveryTable
  */
 static inline int deliveryTable_empty(ExpandableTable * RESTRICT table) {
-	const unsigned int index_size = 
-		no_slots(3 * 6 * sizeof(unsigned int), sizeof(ALIGNED_TYPE));
+	const unsigned int index_size = DELIVTABLE_INDEX_SIZE;
 	unsigned int p;
 	for (p = 0; p < table->nprocs; p++)
 	{
@@ -141,6 +152,35 @@ static inline int deliveryTable_empty(ExpandableTable * RESTRICT table) {
 	return 1;
 }
 
+/** return true (1) if a column of a DeliveryTable holds only puts, 
+ vectored puts and batched puts, which can be executed in any superstep
+ before the rest of the column
+ @param table Reference to a DeliveryTable
+ @param proc the column
+ */
+static inline int deliveryTable_only_puts(ExpandableTable * RESTRICT table, const int proc) {
+	const unsigned int * RESTRICT count = table->info.deliv.count[proc];
+	unsigned int type;
+	for (type = 0; type < it_count; type++)
+	{
+		if (count[type] > 0 && type != it_put && type != it_putv && type != it_putb)
+			return 0;
+	}
+	return 1;
+}
+
+/** clears one column of a DeliveryTable object 
+@param table Reference to a DeliveryTable
+@param proc the column
+*/
+static inline void
+	deliveryTable_reset_column(ExpandableTable * RESTRICT table, const int proc)
+{
+	const int index_size = DELIVTABLE_INDEX_SIZE;
+	memset((ALIGNED_TYPE *) table->data + proc * table->rows , 0, sizeof(ALIGNED_TYPE) * index_size );
+	table->used_slot_count[proc] = index_size;
+}
+
 /** Frees memory allocated by a DeliveryTable 
 @param table Reference to a DeliveryTable */
 static inline void
@@ -170,10 +210,36 @@ static inline void
 		table->info.deliv.start[p] = (unsigned int *)
 			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) ;
 		table->info.deliv.count[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 6 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + it_count ;
+		table->info.deliv.end[p] = (unsigned int *) 
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 2 * it_count ;
+	}  
+}
+
+/** Replace the data of a DeliveryTable by a new, empty block of the same
+size, and return the old block. The caller takes ownership of the returned
+block, which must be freed with bsp_free.
+@param table Reference to a DeliveryTable object
+*/
+
+static inline char *
+	deliveryTable_detach (ExpandableTable * RESTRICT table)
+{
+	unsigned int p;
+	char * data = table->data;
+
+	table->data = (char*) bsp_malloc(table->rows * table->nprocs, table->slot_size);
+	for (p = 0; p < table->nprocs; p++) 
+	{
+		table->info.deliv.start[p] = (unsigned int *)
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) ;
+		table->info.deliv.count[p] = (unsigned int *) 
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + it_count ;
 		table->info.deliv.end[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 12 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 2 * it_count ;
 	}  
+	deliveryTable_reset(table);
+	return data;
 }
 
 /** Make a deliverytable smaller. 
@@ -184,8 +250,7 @@ static inline void
 static inline void
 	deliveryTable_resetrowcount (ExpandableTable * RESTRICT table, const int rows)
 {
-	const int index_size = 
-		no_slots(3 * 6 * sizeof(unsigned int), sizeof(ALIGNED_TYPE));
+	const int index_size = DELIVTABLE_INDEX_SIZE;
 	unsigned int p;
 
 	/**  save table info */
@@ -199,9 +264,9 @@ static inline void
 		table->info.deliv.start[p] = (unsigned int *)
 			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) ;
 		table->info.deliv.count[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 6 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + it_count ;
 		table->info.deliv.end[p] = (unsigned int *) 
-			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 12 ;
+			((char *) table->data + p * table->rows * sizeof(ALIGNED_TYPE)) + 2 * it_count ;
 
 		memset((ALIGNED_TYPE *) table->data + p * table->rows , 0, sizeof(ALIGNED_TYPE) * index_size );
 		/* don't overwrite this information */
@@ -256,6 +321,167 @@ static inline void *
 	return pointer ;  
 }
 
+/** Makes sure that every column p of a DeliveryTable has room for 
+another \a slots[p] slots, so pushing this many slots will not move the 
+table. 
+@param table Reference to a DeliveryTable
+@param slots number of slots for every column
+*/
+static inline void
+	deliveryTable_reserve (ExpandableTable *RESTRICT table, const unsigned int * slots)
+{
+	unsigned int p;
+	int space_needed = 0;
+
+	for (p = 0; p < table->nprocs; p++)
+		space_needed = MAX(space_needed, 
+			(int) (slots[p] + table->used_slot_count[p]) - (int) table->rows);
+	if (space_needed > 0)
+		deliveryTable_expand(table, MAX((int) table->rows, space_needed));
+}
+
+/** Number of slots which a batch of puts occupies in a DeliveryTable
+@param count number of values
+@param nbytes size of each value
+*/
+static inline unsigned int
+	deliveryTable_putbatch_slots (const unsigned int count, const size_t nbytes)
+{
+	return no_slots(sizeof(DelivElement), sizeof(ALIGNED_TYPE)) +
+		no_slots(sizeof(PutBatch) + count * (sizeof(long) + nbytes), sizeof(ALIGNED_TYPE));
+}
+
+/** Adds a batch of puts to the table. The caller copies \a count offsets 
+(long) to the returned location, followed by the values.
+@param table Reference to a DeliveryTable
+@param proc Destination processor
+@param dst Destination address on processor \a proc
+@param count number of values
+@param nbytes size of each value
+@return location of the offsets
+*/
+static inline long *
+	deliveryTable_push_putbatch (ExpandableTable *RESTRICT table, const int proc,
+	char * dst, const unsigned int count, const size_t nbytes)
+{
+	DelivElement element;
+	PutBatch * RESTRICT batch;
+
+	element.size = (unsigned int) (sizeof(PutBatch) + count * (sizeof(long) + nbytes));
+	element.info.put.dst = dst;
+	batch = (PutBatch *) deliveryTable_push(table, proc, &element, it_putb);
+	batch->count = count;
+	batch->nbytes = (unsigned int) nbytes;
+	return (long *) (batch + 1);
+}
+
+/** Adds an accumulating put to the table. The data is combined with the 
+destination using an operation when the table is executed.
+@param table Reference to a DeliveryTable
+@param proc Destination processor
+@param dst Destination address on processor \a proc
+@param src Source address
+@param nbytes size of the data
+@param op the operation (bsp_op_t)
+@param type the element type (bsp_type_t)
+*/
+static inline void
+	deliveryTable_push_accumulate (ExpandableTable *RESTRICT table, const int proc,
+	char * dst, const void * src, const size_t nbytes, 
+	const unsigned int op, const unsigned int type)
+{
+	DelivElement element;
+	PutAccumulate * RESTRICT acc;
+
+	element.size = (unsigned int) (sizeof(PutAccumulate) + nbytes);
+	element.info.put.dst = dst;
+	acc = (PutAccumulate *) deliveryTable_push(table, proc, &element, it_putacc);
+	acc->op = op;
+	acc->type = type;
+	memcpy(acc + 1, src, nbytes);
+}
+
+/** Adds a strided put to the table: \a count blocks of \a blocksize bytes
+are read from \a src with distance \a src_stride, and written to \a dst
+with distance \a dst_stride on processor \a proc.
+@param table Reference to a DeliveryTable
+@param proc Destination processor
+@param dst Destination address on processor \a proc
+@param src Source address
+@param src_stride distance between source blocks in bytes
+@param dst_stride distance between destination blocks in bytes
+@param blocksize size of the blocks in bytes (> 0)
+@param count number of blocks
+*/
+static inline void
+	deliveryTable_push_strided (ExpandableTable *RESTRICT table, const int proc,
+	char * dst, const char * src, const long src_stride, const long dst_stride, 
+	const size_t blocksize, const unsigned int count)
+{
+	DelivElement element;
+	PutVector * RESTRICT vector;
+	char * RESTRICT pointer;
+	unsigned int k;
+
+	element.size = (unsigned int) (sizeof(PutVector) + count * blocksize);
+	element.info.put.dst = dst;
+	vector = (PutVector *) deliveryTable_push(table, proc, &element, it_putv);
+	vector->nblocks = count;
+	vector->blocksize = (unsigned int) blocksize;
+	vector->stride = dst_stride;
+
+	/* gather the blocks */
+	pointer = (char *) (vector + 1);
+	if (src_stride == (long) blocksize)
+		memcpy(pointer, src, count * blocksize);
+	else
+		for (k = 0; k < count; k++, pointer += blocksize, src += src_stride)
+			memcpy(pointer, src, blocksize);
+}
+
+/** Adds an indexed put to the table: block k is read from 
+\a src + blocks[k].src_offset and written to \a dst + blocks[k].dst_offset 
+on processor \a proc.
+@param table Reference to a DeliveryTable
+@param proc Destination processor
+@param dst Destination address on processor \a proc
+@param src Source address
+@param blocks the blocks
+@param count number of blocks
+*/
+static inline void
+	deliveryTable_push_indexed (ExpandableTable *RESTRICT table, const int proc,
+	char * dst, const char * src, const bsp_block_t * blocks, const unsigned int count)
+{
+	DelivElement element;
+	PutVector * RESTRICT vector;
+	PutBlock * RESTRICT descriptors;
+	char * RESTRICT pointer;
+	size_t total = 0;
+	unsigned int k;
+
+	for (k = 0; k < count; k++)
+		total += blocks[k].nbytes;
+
+	element.size = (unsigned int) (sizeof(PutVector) + count * sizeof(PutBlock) + total);
+	element.info.put.dst = dst;
+	vector = (PutVector *) deliveryTable_push(table, proc, &element, it_putv);
+	vector->nblocks = count;
+	vector->blocksize = 0;
+	vector->stride = 0;
+
+	/* block list, then the packed blocks */
+	descriptors = (PutBlock *) (vector + 1);
+	pointer = (char *) (descriptors + count);
+	for (k = 0; k < count; k++)
+	{
+		descriptors[k].offset = blocks[k].dst_offset;
+		descriptors[k].nbytes = blocks[k].nbytes;
+		memcpy(pointer, src + blocks[k].src_offset, blocks[k].nbytes);
+		pointer += blocks[k].nbytes;
+	}
+}
+
 
 
 #endif
@@ -0,0 +1,169 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_eager.h
+Defines EagerChannel, which sends columns of the delivery table during
+a superstep (see bsp_set_eager_threshold()).
+
+A column which grows beyond the threshold, and holds only puts, is
+copied into a chunk and sent with a non-blocking send. The column is
+then empty again. Receivers stage the chunks they find while polling,
+and receive the others at the next sync, where the number of chunks
+from every processor is known. The chunks from a processor are executed
+just before its column of the delivery table, so puts are still 
+executed in the order they were issued.
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_EAGER_H
+#define BSP_EAGER_H
+
+#include <string.h>
+
+#include "bsp.h"
+#include "bsp_config.h"
+#include "bsp_alloc.h"
+#include "bspx_comm.h"
+
+/** a chunk which has been sent or received */
+typedef struct
+{
+	char * data;
+	void * request;		/**< the send request, NULL for received chunks */
+} EagerChunk;
+
+/** the eager channel of a BSPObject */
+typedef struct
+{
+	size_t threshold;			/**< size of a column which is sent, 0 if disabled */
+	unsigned int puts;			/**< puts since the last poll */
+	const BSPX_EagerComm * comm;	/**< set by bspx_set_eager_threshold() */
+
+	unsigned int * sent;		/**< chunks sent to every processor in this superstep */
+	unsigned int * received;	/**< chunks received from every processor */
+
+	EagerChunk * sending;		/**< chunks whose send may not have completed */
+	unsigned int nsending;
+	unsigned int sending_capacity;
+
+	unsigned int nprocs;
+	EagerChunk ** staged;		/**< received chunks of every processor, in order of arrival */
+	unsigned int * nstaged;
+	unsigned int * staged_capacity;
+} EagerChannel;
+
+/** initializes an EagerChannel
+@param eager Reference to an EagerChannel
+@param nprocs the number of processors
+*/
+static inline void
+	eagerChannel_initialize (EagerChannel * RESTRICT eager, const unsigned int nprocs)
+{
+	eager->threshold = 0;
+	eager->puts = 0;
+	eager->comm = NULL;
+	eager->sent = (unsigned int *) bsp_calloc (4 * nprocs, sizeof(unsigned int));
+	eager->received = eager->sent + nprocs;
+	eager->nstaged = eager->sent + 2 * nprocs;
+	eager->staged_capacity = eager->sent + 3 * nprocs;
+	eager->sending = NULL;
+	eager->nsending = 0;
+	eager->sending_capacity = 0;
+	eager->staged = (EagerChunk **) bsp_calloc (nprocs, sizeof(EagerChunk *));
+	eager->nprocs = nprocs;
+}
+
+/** frees memory taken by an EagerChannel. All chunks must have been
+    completed.
+@param eager Reference to an EagerChannel
+*/
+static inline void
+	eagerChannel_destruct (EagerChannel * RESTRICT eager)
+{
+	unsigned int p;
+	for (p = 0; p < eager->nprocs; p++)
+		bsp_free (eager->staged[p]);
+	bsp_free (eager->staged);
+	bsp_free (eager->sent);
+	bsp_free (eager->sending);
+}
+
+/** append a chunk to a list of chunks
+@param list Reference to the list
+@param n Reference to the length of the list
+@param capacity Reference to the capacity of the list
+@param data the chunk
+@param request the send request, or NULL
+*/
+static inline void
+	eagerChannel_append (EagerChunk ** list, unsigned int * n, unsigned int * capacity,
+		char * data, void * request)
+{
+	if (*n == *capacity)
+	{
+		EagerChunk * old = *list;
+		*capacity = *capacity ? 2 * *capacity : 16;
+		*list = (EagerChunk *) bsp_malloc (*capacity, sizeof(EagerChunk));
+		if (old != NULL)
+			memcpy (*list, old, *n * sizeof(EagerChunk));
+		bsp_free (old);
+	}
+	(*list)[*n].data = data;
+	(*list)[*n].request = request;
+	(*n)++;
+}
+
+/** free the chunks whose sends have completed
+@param eager Reference to an EagerChannel
+@param wait nonzero to wait for all sends
+*/
+static inline void
+	eagerChannel_complete_sends (EagerChannel * RESTRICT eager, const int wait)
+{
+	unsigned int i, n = 0;
+	for (i = 0; i < eager->nsending; i++)
+	{
+		if (eager->comm->complete (eager->sending[i].request, wait))
+			bsp_free (eager->sending[i].data);
+		else
+			eager->sending[n++] = eager->sending[i];
+	}
+	eager->nsending = n;
+}
+
+/** receive a chunk which has been found by probing, and stage it
+@param eager Reference to an EagerChannel
+@param pid the source
+@param size the size of the chunk
+*/
+static inline void
+	eagerChannel_receive (EagerChannel * RESTRICT eager, const int pid, const int size)
+{
+	char * data = (char *) bsp_malloc (size, sizeof(char));
+	eager->comm->recv (pid, data, size);
+	eager->received[pid]++;
+	eagerChannel_append (eager->staged + pid, eager->nstaged + pid, 
+		eager->staged_capacity + pid, data, NULL);
+}
+
+#endif
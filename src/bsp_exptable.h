@@ -95,15 +95,48 @@ typedef struct
 /** Additional data needed by a RequestTable */
 typedef struct
 {
-	/** expected amount of data to be returned: The sum of \c size in every 
-	* column. */
+	/** expected amount of data to be returned: The number of delivery 
+	* table slots the replies occupy in every column. */
 	unsigned int * RESTRICT data_sizes;
 } ReqInfo;
 
 /** @name RequestTable data structures */
 /*@{*/
+/** additional info for a strided bsp_get() */
+typedef struct
+{
+	long src_stride;	/**< distance between blocks at the source */
+	long dst_stride;	/**< distance between blocks at the destination */
+} StridedRequest;
+
+/** additional info for a bsp_fetch_op() or bsp_cas() */
+typedef struct
+{
+	ALIGNED_TYPE operand;	/**< the operand, or the value to swap in */
+	ALIGNED_TYPE compare;	/**< the value to compare with (bsp_cas()) */
+} AtomicRequest;
+
+/** additional info for a gather request on a global array. The offsets 
+    (long) of the elements follow in the next slots of the table. */
+typedef struct
+{
+	unsigned int count;		/**< number of elements */
+} GatherRequest;
+
+/** Data structure for additional info in a ReqElement */
+union _RInfo
+{
+	StridedRequest strided;
+	AtomicRequest atomic;
+	GatherRequest gather;
+};
+
+/** operation of gather requests (see ReqElement) */
+#define REQ_OP_GATHER 0xFFFE
+
 /** Data element stored in a RequestTable object. A RequestTable stores only
-* 'bsp_get()' operations */
+* 'bsp_get()' operations, and atomic operations which return data like
+* a get */
 typedef struct
 {
 	/** size of requested data */
@@ -114,6 +147,15 @@ typedef struct
 	char *src;
 	/** local pointer to destination*/
 	char *dst;  
+	/** number of blocks of \c size bytes (1 for contiguous requests, 
+	 *  0 for atomic and gather requests) */
+	unsigned int count;
+	/** operation of an atomic request, or REQ_OP_GATHER */
+	unsigned short op;
+	/** element type of an atomic request */
+	unsigned short type;
+	/** specific info of strided and atomic requests */
+	union _RInfo info;
 } ReqElement;
 /*@}*/
 
@@ -121,7 +163,8 @@ typedef struct
 /*@{*/
 /** type of action */
 typedef enum _ItemType
-{ it_popreg, it_pushreg, it_put, it_get, it_send, it_settag } ItemType;
+{ it_popreg, it_pushreg, it_put, it_get, it_send, it_settag, it_putv, it_putb,
+  it_putacc, it_count /**< number of item types */ } ItemType;
 
 /** additional info for a bsp_put() */
 typedef struct
@@ -130,6 +173,43 @@ typedef struct
 	char * dst;
 } PutObject;
 
+/** Descriptor at the start of the payload of a vectored put (it_putv, 
+* which uses PutObject as its info). Strided puts have \c blocksize > 0 and 
+* are followed by the packed blocks. Indexed puts have \c blocksize == 0 
+* and are followed by \c nblocks PutBlock's and then the packed blocks. */
+typedef struct
+{
+	unsigned int nblocks;	/**< number of blocks */
+	unsigned int blocksize;	/**< size of every block, 0 for indexed puts */
+	long stride;			/**< distance between blocks at the destination */
+} PutVector;
+
+/** A block of an indexed put */
+typedef struct
+{
+	long offset;	/**< offset from the destination pointer */
+	size_t nbytes;	/**< size of the block */
+} PutBlock;
+
+/** Descriptor at the start of the payload of a batch of puts (it_putb,
+* which uses PutObject as its info). It is followed by \c count offsets 
+* (long) from the destination pointer, and then the \c count values of 
+* \c nbytes each. */
+typedef struct
+{
+	unsigned int count;		/**< number of values */
+	unsigned int nbytes;	/**< size of every value */
+} PutBatch;
+
+/** Descriptor at the start of the payload of an accumulating put 
+* (it_putacc, which uses PutObject as its info). It is followed by the 
+* data. */
+typedef struct
+{
+	unsigned int op;	/**< the operation (bsp_op_t) */
+	unsigned int type;	/**< the element type (bsp_type_t) */
+} PutAccumulate;
+
 /** additional info for a bsp_send() */
 typedef struct
 {
@@ -0,0 +1,503 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_global.h
+Defines GlobalTable, which holds the global arrays allocated with 
+bsp_global_alloc(), and the distribution of global arrays.
+
+An array is split into blocks of block_size bytes. With a block-cyclic
+distribution, block b is stored on processor b % p as local block b / p.
+The default block distribution is the block-cyclic one with a single 
+cycle, i.e. with blocks of ceil(size / p) bytes. Custom distributions 
+store the owner and the local block of every block.
+
+Handles are indices into a table which grows as needed. Handles of 
+freed arrays are reused, so as long as all processors allocate and free
+the same arrays in the same order, handles agree.
+
+Arrays can be cached with bsp_global_cache(). The cache mirrors the
+whole array and is split into lines. A line which was fetched stays 
+valid until a processor writes to it: writers record the lines they 
+wrote during a superstep in a bitmap, and at the next sync OR it into 
+the registered dirty bitmap of every processor, with one accumulating 
+put per processor. The bitmaps start with a summary which has a bit for
+every word of line bits, so the readers only visit the words of lines
+which were written.
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_GLOBAL_H
+#define BSP_GLOBAL_H
+
+#include <string.h>
+
+#include "bsp.h"
+#include "bsp_config.h"
+#include "bsp_alloc.h"
+
+/** value of GlobalDivisor::shift for divisors which are not powers of two */
+#define GLOBAL_NO_SHIFT (~0u)
+
+/** Precomputed division by a constant. Powers of two are divided by 
+    shifting, other divisors by multiplying with the reciprocal and 
+    correcting the estimate. */
+typedef struct
+{
+	size_t divisor;
+	unsigned int shift;		/**< log2(divisor), or GLOBAL_NO_SHIFT */
+	double reciprocal;		/**< 1.0 / divisor */
+} GlobalDivisor;
+
+/** number of lines, or of words, which are summarised in one word of a
+    bitmap of a GlobalCache */
+#define GLOBAL_BITS_PER_WORD (8 * sizeof(unsigned int))
+
+/** states of cache lines */
+#define GLOBAL_LINE_EMPTY 0
+#define GLOBAL_LINE_PENDING 1	/**< fetched at the next sync */
+#define GLOBAL_LINE_VALID 2
+
+/** a cached get, which is copied from the mirror after the next sync */
+typedef struct
+{
+	char * dest;
+	const char * src;
+	size_t nbytes;
+} GlobalCacheRead;
+
+/** cache for a global array */
+typedef struct
+{
+	size_t line_size;
+	GlobalDivisor lines;	/**< division by line_size */
+	size_t nlines;
+	size_t nsummary;		/**< number of summary words at the start of the bitmaps */
+	size_t nwords;			/**< number of summary words and words of line bits */
+	char * mirror;			/**< local copy of the array */
+	unsigned char * state;	/**< state of every line */
+	unsigned int * dirty;	/**< registered bitmap, set by the writers of a line */
+	unsigned int * written;	/**< bitmap of the lines written by this processor in this superstep */
+	size_t written_first;	/**< first word of written which is not zero */
+	size_t written_last;	/**< last word of written which is not zero */
+	int any_written;
+
+	size_t * pending;		/**< lines which are fetched at the next sync */
+	size_t npending;
+	size_t pending_capacity;
+
+	GlobalCacheRead * reads;	/**< cached gets to complete after the next sync */
+	unsigned int nreads;
+	unsigned int reads_capacity;
+
+	bsp_global_cache_stats_t stats;
+} GlobalCache;
+
+/** information to describe a BSP global array */
+typedef struct _bsp_global_array_t {
+	size_t array_size;
+	void * local_slice;		/**< NULL if the handle is free */
+	size_t local_size;
+	size_t block_size;		/**< size of the blocks which are distributed */
+	GlobalDivisor blocks;	/**< division by block_size */
+	GlobalDivisor procs;	/**< division by the number of processors */
+	int * owners;			/**< custom distributions: owner of every block, or NULL */
+	size_t * local_blocks;	/**< custom distributions: local index of every block */
+	GlobalCache * cache;	/**< NULL unless the array is cached */
+} bsp_global_array_t;
+
+/** A gather which is completed after the next sync: the owners reply 
+    with the distinct elements, which are then copied to their positions */
+typedef struct
+{
+	char * staging;			/**< the distinct elements, as received */
+	char * dest;			/**< the destination */
+	size_t * targets;		/**< index in dest of every copy */
+	size_t * positions;		/**< index in staging of every copy */
+	size_t count;			/**< number of copies */
+	size_t nbytes;			/**< element size */
+} GlobalGather;
+
+/** table of global arrays */
+typedef struct
+{
+	bsp_global_array_t * arrays;
+	unsigned int count;		/**< number of handles in use or freed */
+	unsigned int capacity;	/**< number of allocated entries */
+	unsigned int first_free;	/**< no free handles below this one */
+
+	GlobalGather * pending;		/**< gathers to complete after the next sync */
+	unsigned int npending;
+	unsigned int pending_capacity;
+
+	unsigned int ncached;		/**< number of cached arrays */
+} GlobalTable;
+
+/** A piece of a global array request which is stored on one processor: 
+    count blocks of nbytes, which are stride bytes apart in the request 
+    and contiguous in the local slice of the owner. */
+typedef struct
+{
+	int proc;				/**< the owner */
+	size_t local_offset;	/**< offset in the local slice of the owner */
+	size_t offset;			/**< offset from the start of the request */
+	size_t nbytes;			/**< size of each block */
+	size_t count;			/**< number of blocks */
+	size_t stride;			/**< distance between blocks in the request */
+} GlobalPiece;
+
+/** initializes a GlobalDivisor
+@param d Reference to a GlobalDivisor
+@param divisor the divisor (> 0)
+*/
+static inline void
+	globalDivisor_initialize (GlobalDivisor * RESTRICT d, const size_t divisor)
+{
+	unsigned int s = 0;
+	d->divisor = divisor;
+	d->reciprocal = 1.0 / (double) divisor;
+	while (((size_t) 1 << s) < divisor)
+		s++;
+	d->shift = ((size_t) 1 << s) == divisor ? s : GLOBAL_NO_SHIFT;
+}
+
+/** divide by a GlobalDivisor
+@param d Reference to a GlobalDivisor
+@param x the dividend
+@return x / d->divisor
+*/
+static inline size_t
+	globalDivisor_divide (const GlobalDivisor * RESTRICT d, const size_t x)
+{
+	size_t q;
+	if (d->shift != GLOBAL_NO_SHIFT)
+		return x >> d->shift;
+	/* the estimate is exact or off by one unless x is very large */
+	q = (size_t) ((double) x * d->reciprocal);
+	while (q * d->divisor > x)
+		q--;
+	while (x - q * d->divisor >= d->divisor)
+		q++;
+	return q;
+}
+
+/** initializes a GlobalCache
+@param cache Reference to a GlobalCache
+@param array_size the size of the array
+@param line_size the size of the cache lines (> 0)
+*/
+static inline void
+	globalCache_initialize (GlobalCache * RESTRICT cache, const size_t array_size, 
+		const size_t line_size)
+{
+	size_t line_words;
+	cache->line_size = line_size;
+	globalDivisor_initialize (&cache->lines, line_size);
+	cache->nlines = (array_size + line_size - 1) / line_size;
+	line_words = cache->nlines / GLOBAL_BITS_PER_WORD + 1;
+	cache->nsummary = (line_words + GLOBAL_BITS_PER_WORD - 1) / GLOBAL_BITS_PER_WORD;
+	cache->nwords = cache->nsummary + line_words;
+	cache->mirror = (char *) bsp_malloc (array_size ? array_size : 1, sizeof(char));
+	cache->state = (unsigned char *) bsp_calloc (cache->nlines + 1, sizeof(unsigned char));
+	cache->dirty = (unsigned int *) bsp_calloc (cache->nwords, sizeof(unsigned int));
+	cache->written = (unsigned int *) bsp_calloc (cache->nwords, sizeof(unsigned int));
+	cache->any_written = 0;
+	cache->pending = NULL;
+	cache->npending = 0;
+	cache->pending_capacity = 0;
+	cache->reads = NULL;
+	cache->nreads = 0;
+	cache->reads_capacity = 0;
+	memset (&cache->stats, 0, sizeof(bsp_global_cache_stats_t));
+}
+
+/** frees memory taken by a GlobalCache
+@param cache Reference to a GlobalCache
+*/
+static inline void
+	globalCache_destruct (GlobalCache * RESTRICT cache)
+{
+	bsp_free (cache->mirror);
+	bsp_free (cache->state);
+	bsp_free (cache->dirty);
+	bsp_free (cache->written);
+	bsp_free (cache->pending);
+	bsp_free (cache->reads);
+}
+
+/** record that this processor writes to a range of a cached array
+@param cache Reference to a GlobalCache
+@param offset the offset of the range
+@param size the size of the range
+*/
+static inline void
+	globalCache_write (GlobalCache * RESTRICT cache, const size_t offset, const size_t size)
+{
+	size_t l, first, last;
+	if (size == 0)
+		return;
+	first = globalDivisor_divide (&cache->lines, offset);
+	last = globalDivisor_divide (&cache->lines, offset + size - 1);
+	for (l = first; l <= last; l++)
+	{
+		const size_t w = l / GLOBAL_BITS_PER_WORD;
+		cache->written[cache->nsummary + w] |= 1u << (l % GLOBAL_BITS_PER_WORD);
+		cache->written[w / GLOBAL_BITS_PER_WORD] |= 1u << (w % GLOBAL_BITS_PER_WORD);
+	}
+
+	/* summary words come first, so the range starts at one of them */
+	first = first / GLOBAL_BITS_PER_WORD / GLOBAL_BITS_PER_WORD;
+	last = cache->nsummary + last / GLOBAL_BITS_PER_WORD;
+	if (!cache->any_written || first < cache->written_first)
+		cache->written_first = first;
+	if (!cache->any_written || last > cache->written_last)
+		cache->written_last = last;
+	cache->any_written = 1;
+}
+
+/** record that a line is fetched at the next sync
+@param cache Reference to a GlobalCache
+@param line the line
+*/
+static inline void
+	globalCache_push_pending (GlobalCache * RESTRICT cache, const size_t line)
+{
+	if (cache->npending == cache->pending_capacity)
+	{
+		size_t * old = cache->pending;
+		cache->pending_capacity = cache->pending_capacity ? 2 * cache->pending_capacity : 16;
+		cache->pending = (size_t *) bsp_malloc (cache->pending_capacity, sizeof(size_t));
+		if (old != NULL)
+			memcpy (cache->pending, old, cache->npending * sizeof(size_t));
+		bsp_free (old);
+	}
+	cache->state[line] = GLOBAL_LINE_PENDING;
+	cache->pending[cache->npending++] = line;
+}
+
+/** add a cached get to complete after the next sync
+@param cache Reference to a GlobalCache
+@param dest the destination
+@param offset the offset in the array
+@param nbytes the size
+*/
+static inline void
+	globalCache_push_read (GlobalCache * RESTRICT cache, void * dest, 
+		const size_t offset, const size_t nbytes)
+{
+	GlobalCacheRead * RESTRICT read;
+	if (cache->nreads == cache->reads_capacity)
+	{
+		GlobalCacheRead * old = cache->reads;
+		cache->reads_capacity = cache->reads_capacity ? 2 * cache->reads_capacity : 16;
+		cache->reads = (GlobalCacheRead *) bsp_malloc (cache->reads_capacity, 
+			sizeof(GlobalCacheRead));
+		if (old != NULL)
+			memcpy (cache->reads, old, cache->nreads * sizeof(GlobalCacheRead));
+		bsp_free (old);
+	}
+	read = cache->reads + cache->nreads++;
+	read->dest = (char *) dest;
+	read->src = cache->mirror + offset;
+	read->nbytes = nbytes;
+}
+
+/** complete the cached gets once the lines have been delivered, and 
+    invalidate the lines which were written in the last superstep. Only 
+    the summary and the lines which were fetched or written are visited.
+@param cache Reference to a GlobalCache
+*/
+static inline void
+	globalCache_complete (GlobalCache * RESTRICT cache)
+{
+	unsigned int r;
+	size_t s, w, l, i;
+	for (r = 0; r < cache->nreads; r++)
+		memcpy (cache->reads[r].dest, cache->reads[r].src, cache->reads[r].nbytes);
+	cache->nreads = 0;
+
+	for (s = 0; s < cache->nsummary; s++)
+	{
+		unsigned int summary = cache->dirty[s];
+		cache->dirty[s] = 0;
+		for (w = s * GLOBAL_BITS_PER_WORD; summary != 0; w++, summary >>= 1)
+		{
+			unsigned int bits;
+			if (!(summary & 1))
+				continue;
+			bits = cache->dirty[cache->nsummary + w];
+			cache->dirty[cache->nsummary + w] = 0;
+			for (l = w * GLOBAL_BITS_PER_WORD; bits != 0; l++, bits >>= 1)
+			{
+				if (!(bits & 1))
+					continue;
+				if (cache->state[l] != GLOBAL_LINE_EMPTY)
+					cache->stats.invalidations++;
+				cache->state[l] = GLOBAL_LINE_EMPTY;
+			}
+		}
+	}
+
+	/* fetched lines which were also written are fetched again */
+	for (i = 0; i < cache->npending; i++)
+		if (cache->state[cache->pending[i]] == GLOBAL_LINE_PENDING)
+			cache->state[cache->pending[i]] = GLOBAL_LINE_VALID;
+	cache->npending = 0;
+}
+
+/** initializes a GlobalTable 
+@param table Reference to a GlobalTable
+*/
+static inline void
+	globalTable_initialize (GlobalTable * RESTRICT table)
+{
+	table->arrays = NULL;
+	table->count = 0;
+	table->capacity = 0;
+	table->first_free = 0;
+	table->pending = NULL;
+	table->npending = 0;
+	table->pending_capacity = 0;
+	table->ncached = 0;
+}
+
+/** frees memory taken by a GlobalTable (but not by the arrays in it)
+@param table Reference to a GlobalTable
+*/
+static inline void
+	globalTable_destruct (GlobalTable * RESTRICT table)
+{
+	unsigned int h;
+	for (h = 0; h < table->count; h++)
+	{
+		bsp_free (table->arrays[h].owners);
+		bsp_free (table->arrays[h].local_blocks);
+		if (table->arrays[h].cache != NULL)
+			globalCache_destruct (table->arrays[h].cache);
+		bsp_free (table->arrays[h].cache);
+	}
+	bsp_free (table->arrays);
+	for (h = 0; h < table->npending; h++)
+	{
+		bsp_free (table->pending[h].staging);
+		bsp_free (table->pending[h].targets);
+		bsp_free (table->pending[h].positions);
+	}
+	bsp_free (table->pending);
+}
+
+/** find a free handle, growing the table if necessary
+@param table Reference to a GlobalTable
+@return the handle, its local_slice must be set by the caller
+*/
+static inline bsp_global_handle_t
+	globalTable_insert (GlobalTable * RESTRICT table)
+{
+	unsigned int h;
+
+	for (h = table->first_free; h < table->count; h++)
+		if (table->arrays[h].local_slice == NULL)
+			break;
+
+	if (h == table->count)
+	{
+		if (table->count == table->capacity)
+		{
+			bsp_global_array_t * old = table->arrays;
+			table->capacity = table->capacity ? 2 * table->capacity : 16;
+			table->arrays = (bsp_global_array_t *) bsp_malloc (table->capacity, 
+				sizeof(bsp_global_array_t));
+			if (old != NULL)
+				memcpy (table->arrays, old, table->count * sizeof(bsp_global_array_t));
+			bsp_free (old);
+		}
+		table->count++;
+	}
+	table->first_free = h + 1;
+	memset (table->arrays + h, 0, sizeof(bsp_global_array_t));
+	return (bsp_global_handle_t) h;
+}
+
+/** mark a handle as free
+@param table Reference to a GlobalTable
+@param handle the handle
+*/
+static inline void
+	globalTable_remove (GlobalTable * RESTRICT table, const bsp_global_handle_t handle)
+{
+	bsp_global_array_t * RESTRICT a = table->arrays + handle;
+	bsp_free (a->owners);
+	bsp_free (a->local_blocks);
+	a->owners = NULL;
+	a->local_blocks = NULL;
+	a->local_slice = NULL;
+	if ((unsigned int) handle < table->first_free)
+		table->first_free = (unsigned int) handle;
+}
+
+/** add a gather to complete after the next sync 
+@param table Reference to a GlobalTable
+@return the gather, which the caller must fill in
+*/
+static inline GlobalGather *
+	globalTable_push_gather (GlobalTable * RESTRICT table)
+{
+	if (table->npending == table->pending_capacity)
+	{
+		GlobalGather * old = table->pending;
+		table->pending_capacity = table->pending_capacity ? 2 * table->pending_capacity : 4;
+		table->pending = (GlobalGather *) bsp_malloc (table->pending_capacity, 
+			sizeof(GlobalGather));
+		if (old != NULL)
+			memcpy (table->pending, old, table->npending * sizeof(GlobalGather));
+		bsp_free (old);
+	}
+	return table->pending + table->npending++;
+}
+
+/** complete all gathers and cached gets, once the replies have been 
+    delivered
+@param table Reference to a GlobalTable
+*/
+static inline void
+	globalTable_complete (GlobalTable * RESTRICT table)
+{
+	unsigned int g;
+	size_t i;
+	for (g = 0; g < table->npending; g++)
+	{
+		const GlobalGather * RESTRICT gather = table->pending + g;
+		for (i = 0; i < gather->count; i++)
+			memcpy (gather->dest + gather->targets[i] * gather->nbytes, 
+				gather->staging + gather->positions[i] * gather->nbytes, gather->nbytes);
+		bsp_free (gather->staging);
+		bsp_free (gather->targets);
+		bsp_free (gather->positions);
+	}
+	table->npending = 0;
+
+	for (g = 0; table->ncached > 0 && g < table->count; g++)
+		if (table->arrays[g].cache != NULL)
+			globalCache_complete (table->arrays[g].cache);
+}
+
+#endif
@@ -31,7 +31,12 @@
 
 #include "bsp_exptable.h"
 #include "bsp_mesgqueue.h"
+#include "bsp_reqtable.h"
+#include "bsp_delivtable.h"
+#include "bsp_memreg.h"
 #include "bsp_private.h"
+#include "bsp_alloc.h"
+#include "bsp_accumulate.h"
 #include "bsp_tools/aligned_malloc.h"
 
 #ifndef ASSERT
@@ -42,49 +47,285 @@
 #endif
 #endif
 
-/** Allocate shared memory block
+/** Called for every piece of a request by global_split() */
+typedef void (*GlobalPieceFn) (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg);
+
+/** Split a request into pieces which are stored on one processor each.
+    For block-cyclic distributions, all full blocks on the same processor
+    form a single piece, so there are at most p + 2 pieces. For custom 
+    distributions, neighbouring blocks are merged if they are stored
+    next to each other.
+    @param bsp the BSP object
+    @param array the array
+    @param offset the offset of the request
+    @param size the size of the request
+    @param fn called for every piece
+    @param arg passed to fn
+ */
+static void global_split (BSPObject * bsp, bsp_global_array_t * array, 
+	size_t offset, size_t size, GlobalPieceFn fn, void * arg) {
+	const size_t bs = array->block_size;
+	size_t b = globalDivisor_divide (&array->blocks, offset);
+	size_t r = offset - b * bs;
+	size_t done = 0;
+	GlobalPiece piece;
+
+	ASSERT(offset + size <= array->array_size);
+
+	if ( array->owners != NULL ) {
+		int have = 0;
+		while ( done < size ) {
+			size_t n = size - done < bs - r ? size - done : bs - r;
+			size_t local = array->local_blocks[b] * bs + r;
+			if ( have && piece.proc == array->owners[b] && 
+				piece.local_offset + piece.nbytes == local ) {
+				piece.nbytes += n;
+			} else {
+				if ( have ) {
+					fn (bsp, array, &piece, arg);
+				}
+				piece.proc = array->owners[b];
+				piece.local_offset = local;
+				piece.offset = done;
+				piece.nbytes = n;
+				piece.count = 1;
+				piece.stride = 0;
+				have = 1;
+			}
+			done += n;
+			r = 0;
+			++b;
+		}
+		if ( have ) {
+			fn (bsp, array, &piece, arg);
+		}
+		return;
+	}
+
+	piece.count = 1;
+	piece.stride = 0;
+
+	/* leading partial block */
+	if ( size > 0 && ( r != 0 || size < bs ) ) {
+		size_t q = globalDivisor_divide (&array->procs, b);
+		piece.proc = (int) (b - q * bsp->nprocs);
+		piece.local_offset = q * bs + r;
+		piece.offset = 0;
+		piece.nbytes = size < bs - r ? size : bs - r;
+		fn (bsp, array, &piece, arg);
+		done = piece.nbytes;
+		++b;
+	}
+
+	/* full blocks, one strided piece per processor */
+	{
+		size_t full = globalDivisor_divide (&array->blocks, size - done);
+		size_t j, P = (size_t) bsp->nprocs;
+		for ( j = 0; j < full && j < P; ++j ) {
+			size_t q = globalDivisor_divide (&array->procs, b + j);
+			piece.proc = (int) (b + j - q * P);
+			piece.local_offset = q * bs;
+			piece.offset = done + j * bs;
+			piece.nbytes = bs;
+			piece.count = (full - j + P - 1) / P;
+			piece.stride = P * bs;
+			fn (bsp, array, &piece, arg);
+		}
+		done += full * bs;
+		b += full;
+	}
+
+	/* trailing partial block */
+	if ( done < size ) {
+		size_t q = globalDivisor_divide (&array->procs, b);
+		piece.proc = (int) (b - q * bsp->nprocs);
+		piece.local_offset = q * bs;
+		piece.offset = done;
+		piece.nbytes = size - done;
+		piece.count = 1;
+		piece.stride = 0;
+		fn (bsp, array, &piece, arg);
+	}
+}
+
+/** Allocate shared memory block with a distribution
     @param array_size size of block to allocate
+    @param dist the distribution
+    @param block_size the size of the blocks for block-cyclic and custom 
+           distributions (ignored for block distributions)
+    @param owner the owner of every block for custom distributions
     @return a handle to the block
   */  
-bsp_global_handle_t BSP_CALLING bspx_global_alloc (BSPObject * bsp, size_t array_size ) {
-    int procs = bsp->nprocs;
-    bsp_global_handle_t handle;
-    size_t alloc_size = ( array_size + procs - 1 ) / procs;
-
-    if ( bsp->global_overflow ) {
-        int count = 0;
-        while ( bsp->global_arrays[bsp->global_array_last].local_slice != NULL ) {
-            ++bsp->global_array_last;
-            if ( count++ > BSP_MAX_GLOBAL_ARRAYS ) {
-                bsp_abort ( "bspx_global_alloc: ran out of handles." );
+bsp_global_handle_t BSP_CALLING bspx_global_alloc_dist (BSPObject * bsp, size_t array_size, 
+	bsp_dist_t dist, size_t block_size, bsp_global_owner_fn owner ) {
+    size_t procs = bsp->nprocs;
+    bsp_global_handle_t handle = globalTable_insert (&bsp->globals);
+    bsp_global_array_t * array = bsp->globals.arrays + handle;
+    size_t nblocks, local_blocks;
+
+    if ( dist == bsp_dist_block ) {
+        block_size = ( array_size + procs - 1 ) / procs;
+    } else if ( block_size == 0 || ( dist == bsp_dist_custom && owner == NULL ) ) {
+        bsp_abort ( "bspx_global_alloc_dist: invalid distribution." );
+    }
+    if ( block_size == 0 ) {
+        block_size = 1;
+    }
+
+    nblocks = ( array_size + block_size - 1 ) / block_size;
+    local_blocks = ( nblocks + procs - 1 ) / procs;
+
+    if ( dist == bsp_dist_custom ) {
+        size_t b, * counts = (size_t *) bsp_calloc ( procs, sizeof(size_t) );
+        array->owners = (int *) bsp_malloc ( nblocks, sizeof(int) );
+        array->local_blocks = (size_t *) bsp_malloc ( nblocks, sizeof(size_t) );
+        local_blocks = 0;
+        for ( b = 0; b < nblocks; ++b ) {
+            int p = owner ( b, (int) procs );
+            if ( p < 0 || (size_t) p >= procs ) {
+                bsp_abort ( "bspx_global_alloc_dist: owner %d of block %lu is out of range.", 
+                    p, (unsigned long) b );
+            }
+            array->owners[b] = p;
+            array->local_blocks[b] = counts[p]++;
+            if ( counts[p] > local_blocks ) {
+                local_blocks = counts[p];
             }
         }
+        bsp_free ( counts );
     }
 
-    bsp->global_arrays[bsp->global_array_last].array_size = array_size;
-    bsp->global_arrays[bsp->global_array_last].local_slice = aligned_malloc ( alloc_size, 32 );
-    bsp->global_arrays[bsp->global_array_last].local_size = alloc_size;
+    array->array_size = array_size;
+    array->block_size = block_size;
+    globalDivisor_initialize ( &array->blocks, block_size );
+    globalDivisor_initialize ( &array->procs, procs );
+    array->local_size = local_blocks * block_size;
+    array->local_slice = aligned_malloc ( array->local_size, 32 );
 
-    bspx_push_reg (bsp, bsp->global_arrays[bsp->global_array_last].local_slice,
-                   bsp->global_arrays[bsp->global_array_last].local_size );
-
-    handle = bsp->global_array_last;
-    bsp->global_array_last++;
-    bsp->global_array_last %= BSP_MAX_GLOBAL_ARRAYS;
-    if ( bsp->global_array_last == 0 ) {
-        bsp->global_overflow = 1;
-    }
+    bspx_push_reg ( bsp, array->local_slice, array->local_size );
     return handle;
 }
 
+/** Allocate shared memory block, which is split into one contiguous 
+    slice per processor
+    @param array_size size of block to allocate
+    @return a handle to the block
+  */  
+bsp_global_handle_t BSP_CALLING bspx_global_alloc (BSPObject * bsp, size_t array_size ) {
+    return bspx_global_alloc_dist ( bsp, array_size, bsp_dist_block, 0, NULL );
+}
+
 /** Free shared memory block
     @param ptr a handle to the block
   */  
 
 void BSP_CALLING bspx_global_free (BSPObject * bsp, bsp_global_handle_t ptr ) {
-    bspx_pop_reg (bsp, bsp->global_arrays[ptr].local_slice );
-    aligned_free ( bsp->global_arrays[ptr].local_slice );
-    bsp->global_arrays[ptr].local_slice = NULL;
+    bspx_global_cache (bsp, ptr, 0);
+    bspx_pop_reg (bsp, bsp->globals.arrays[ptr].local_slice );
+    aligned_free ( bsp->globals.arrays[ptr].local_slice );
+    globalTable_remove ( &bsp->globals, ptr );
+}
+
+/** Find the processor and the local offset of a byte of a global array
+    @param bsp the BSP object
+    @param array the array
+    @param offset the offset of the byte
+    @param local returns the offset in the local slice of the owner
+    @return the rank of the owner
+ */
+static int global_locate (BSPObject * bsp, const bsp_global_array_t * array, 
+	size_t offset, size_t * local ) {
+	size_t b = globalDivisor_divide ( &array->blocks, offset );
+	size_t r = offset - b * array->block_size;
+	size_t q;
+	if ( array->owners != NULL ) {
+		*local = array->local_blocks[b] * array->block_size + r;
+		return array->owners[b];
+	}
+	q = globalDivisor_divide ( &array->procs, b );
+	*local = q * array->block_size + r;
+	return (int) ( b - q * bsp->nprocs );
+}
+
+/** Find the processor which stores a byte of a global array
+    @param handle the block handle
+    @param offset the offset of the byte
+    @return the rank of the processor
+ */
+int BSP_CALLING bspx_global_owner (BSPObject * bsp, bsp_global_handle_t handle, size_t offset ) {
+    size_t local;
+    return global_locate ( bsp, bsp->globals.arrays + handle, offset, &local );
+}
+
+/** arguments of the piece functions */
+typedef struct {
+	char * data;
+	bsp_op_t op;
+	bsp_type_t type;
+} GlobalRequest;
+
+static void global_get_piece (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg) {
+	char * dest = ((GlobalRequest *) arg)->data + piece->offset;
+	if ( piece->count == 1 ) {
+		bspx_get (bsp, piece->proc, array->local_slice, (long int) piece->local_offset, 
+			dest, piece->nbytes );
+	} else {
+		bspx_get_strided (bsp, piece->proc, array->local_slice, (long int) piece->local_offset, 
+			(long int) piece->nbytes, dest, (long int) piece->stride, piece->nbytes, (int) piece->count );
+	}
+}
+
+static void global_put_piece (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg) {
+	const char * src = ((GlobalRequest *) arg)->data + piece->offset;
+	if ( piece->count == 1 ) {
+		bspx_put (bsp, piece->proc, src, array->local_slice, (long int) piece->local_offset, 
+			piece->nbytes );
+	} else {
+		bspx_put_strided (bsp, piece->proc, src, (long int) piece->stride, array->local_slice, 
+			(long int) piece->local_offset, (long int) piece->nbytes, piece->nbytes, (int) piece->count );
+	}
+}
+
+static void global_hpget_piece (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg) {
+	char * dest = ((GlobalRequest *) arg)->data + piece->offset;
+	size_t k;
+	for ( k = 0; k < piece->count; ++k ) {
+		bspx_hpget (bsp, piece->proc, array->local_slice, 
+			(long int) ( piece->local_offset + k * piece->nbytes ), 
+			dest + k * piece->stride, piece->nbytes );
+	}
+}
+
+static void global_hpput_piece (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg) {
+	const char * src = ((GlobalRequest *) arg)->data + piece->offset;
+	size_t k;
+	for ( k = 0; k < piece->count; ++k ) {
+		bspx_hpput (bsp, piece->proc, src + k * piece->stride, array->local_slice, 
+			(long int) ( piece->local_offset + k * piece->nbytes ), piece->nbytes );
+	}
+}
+
+static void global_accumulate_piece (BSPObject * bsp, bsp_global_array_t * array, 
+	const GlobalPiece * piece, void * arg) {
+	GlobalRequest * req = (GlobalRequest *) arg;
+	const char * src = req->data + piece->offset;
+	const size_t esize = accumulate_type_size (req->type);
+	size_t k;
+	/* pieces end at block boundaries, which must also be element boundaries */
+	if ( piece->offset % esize != 0 || piece->nbytes % esize != 0 ) {
+		bsp_abort ( "bspx_global_put_accumulate: an element straddles two blocks "
+			"which are stored on different processors.\n" );
+	}
+	for ( k = 0; k < piece->count; ++k ) {
+		bspx_put_accumulate (bsp, piece->proc, src + k * piece->stride, array->local_slice, 
+			(long int) ( piece->local_offset + k * piece->nbytes ), piece->nbytes, 
+			req->op, req->type );
+	}
 }
 
 /** Get data from global shared memory block
@@ -95,25 +336,48 @@ void BSP_CALLING bspx_global_free (BSPObject * bsp, bsp_global_handle_t ptr ) {
  */
 
 void BSP_CALLING bspx_global_get (BSPObject * bsp, bsp_global_handle_t src, size_t offset, void * dest, size_t size ) {
-	size_t procs = bsp->nprocs;
-	size_t gsize = bsp->global_arrays[src].array_size;
-
-	size_t offset_proc = offset * procs / gsize;
-	size_t offset_idx = offset - offset_proc*bsp->global_arrays[src].local_size;
-
-	while ( size > 0 ) {
+	bsp_global_array_t * array = bsp->globals.arrays + src;
+	GlobalCache * cache = array->cache;
+	GlobalRequest req;
+	size_t l, last, first_missing;
+	int missing = 0;
+
+	if ( cache == NULL ) {
+		req.data = (char *) dest;
+		global_split (bsp, array, offset, size, global_get_piece, &req);
+		return;
+	}
+	if ( size == 0 ) {
+		return;
+	}
 
-		size_t size_todo = size > bsp->global_arrays[src].local_size - offset_idx ? 
-			bsp->global_arrays[src].local_size - offset_idx : size;
-		ASSERT(offset_proc < procs);
-		ASSERT(offset_idx < bsp->global_arrays[src].local_size);
-		ASSERT(offset_idx + size_todo <= bsp->global_arrays[src].local_size);
-		bspx_get (bsp, (int)offset_proc, bsp->global_arrays[src].local_slice, (long int)offset_idx, dest, size_todo );
-		size-= size_todo;
-		dest = ((char*) dest) + size_todo;
-		++offset_proc;
-		offset_idx = 0;
+	/* fetch every run of empty lines into the mirror with one request */
+	last = globalDivisor_divide ( &cache->lines, offset + size - 1 );
+	for ( l = globalDivisor_divide ( &cache->lines, offset ); l <= last + 1; ++l ) {
+		if ( l <= last && cache->state[l] == GLOBAL_LINE_EMPTY ) {
+			if ( !missing ) {
+				first_missing = l;
+				missing = 1;
+			}
+			globalCache_push_pending ( cache, l );
+			cache->stats.misses++;
+			continue;
+		}
+		if ( missing ) {
+			size_t start = first_missing * cache->line_size;
+			size_t end = l * cache->line_size;
+			if ( end > array->array_size ) {
+				end = array->array_size;
+			}
+			req.data = cache->mirror + start;
+			global_split (bsp, array, start, end - start, global_get_piece, &req);
+			missing = 0;
+		}
+		if ( l <= last ) {
+			cache->stats.hits++;
+		}
 	}
+	globalCache_push_read ( cache, dest, offset, size );
 }
 
 /** Put data to global shared memory block
@@ -123,26 +387,12 @@ void BSP_CALLING bspx_global_get (BSPObject * bsp, bsp_global_handle_t src, size
     @param size the size
  */
 void BSP_CALLING bspx_global_put (BSPObject * bsp, const void * src, bsp_global_handle_t dest, size_t offset, size_t size ) {
-	size_t procs = bsp->nprocs;
-	size_t gsize = bsp->global_arrays[dest].array_size;
-
-	size_t offset_proc = offset * procs / gsize;
-	size_t offset_idx = offset - offset_proc*bsp->global_arrays[dest].local_size;
-
-	while ( size > 0 ) {
-		size_t size_todo = size > bsp->global_arrays[dest].local_size - offset_idx ? 
-			bsp->global_arrays[dest].local_size - offset_idx : size;
-		ASSERT(offset_proc < procs);
-		ASSERT(offset_idx < bsp->global_arrays[dest].local_size);
-		ASSERT(offset_idx + size_todo <= bsp->global_arrays[dest].local_size);
-
-		bspx_put (bsp, (int)offset_proc, src, bsp->global_arrays[dest].local_slice, (long int)offset_idx, size_todo );
-		src = ((char*) src) + size_todo;
-		size-= size_todo;
-		++offset_proc;
-		offset_idx = 0;
+	GlobalRequest req;
+	if ( bsp->globals.arrays[dest].cache != NULL ) {
+		globalCache_write ( bsp->globals.arrays[dest].cache, offset, size );
 	}
-
+	req.data = (char *) src;
+	global_split (bsp, bsp->globals.arrays + dest, offset, size, global_put_piece, &req);
 }
 
 /** Get data from global shared memory block (unbuffered)
@@ -153,52 +403,276 @@ void BSP_CALLING bspx_global_put (BSPObject * bsp, const void * src, bsp_global_
  */
 
 void BSP_CALLING bspx_global_hpget (BSPObject * bsp, bsp_global_handle_t src, size_t offset, void * dest, size_t size ) {
-	size_t procs = bsp->nprocs;
-	size_t gsize = bsp->global_arrays[src].array_size;
+	GlobalRequest req;
+	req.data = (char *) dest;
+	global_split (bsp, bsp->globals.arrays + src, offset, size, global_hpget_piece, &req);
+}
 
-	size_t offset_proc = offset * procs / gsize;
-	size_t offset_idx = offset - offset_proc*bsp->global_arrays[src].local_size;
+/** Put data to global shared memory block (unbuffered)
+    @param src the source data
+    @param dest the destination block handle
+	@param offset the offset
+    @param size the size
+ */
 
-	while ( size > 0 ) {
-		size_t size_todo = size > bsp->global_arrays[src].local_size - offset_idx ? 
-			bsp->global_arrays[src].local_size - offset_idx : size;
-		ASSERT(offset_proc < procs);
-		ASSERT(offset_idx < bsp->global_arrays[src].local_size);
-		ASSERT(offset_idx + size_todo <= bsp->global_arrays[src].local_size);
-		bspx_hpget (bsp, (int)offset_proc, bsp->global_arrays[src].local_slice, (long int)offset_idx, dest, size_todo );
-		dest = ((char*) dest) + size_todo;
-		size-= size_todo;
-		++offset_proc;
-		offset_idx = 0;
+void BSP_CALLING bspx_global_hpput (BSPObject * bsp, const void * src, bsp_global_handle_t dest, size_t offset, size_t size ) {
+	GlobalRequest req;
+	if ( bsp->globals.arrays[dest].cache != NULL ) {
+		globalCache_write ( bsp->globals.arrays[dest].cache, offset, size );
 	}
+	req.data = (char *) src;
+	global_split (bsp, bsp->globals.arrays + dest, offset, size, global_hpput_piece, &req);
 }
 
-/** Put data to global shared memory block (unbuffered)
+/** Accumulate data into a global shared memory block 
+    (see bsp_put_accumulate). Elements must not straddle blocks which
+    are stored on different processors.
     @param src the source data
     @param dest the destination block handle
 	@param offset the offset
     @param size the size
+    @param op the operation
+    @param type the element type
  */
+void BSP_CALLING bspx_global_put_accumulate (BSPObject * bsp, const void * src, bsp_global_handle_t dest, size_t offset, size_t size, bsp_op_t op, bsp_type_t type ) {
+	GlobalRequest req;
+	if ( bsp->globals.arrays[dest].cache != NULL ) {
+		globalCache_write ( bsp->globals.arrays[dest].cache, offset, size );
+	}
+	req.data = (char *) src;
+	req.op = op;
+	req.type = type;
+	global_split (bsp, bsp->globals.arrays + dest, offset, size, global_accumulate_piece, &req);
+}
 
-void BSP_CALLING bspx_global_hpput (BSPObject * bsp, const void * src, bsp_global_handle_t dest, size_t offset, size_t size ) {
-	size_t procs = bsp->nprocs;
-	size_t gsize = bsp->global_arrays[dest].array_size;
+/** an element of a gather or scatter */
+typedef struct {
+	int proc;		/**< the owner */
+	size_t local;	/**< offset in the local slice of the owner */
+	size_t index;	/**< position in the request */
+} GlobalIndex;
+
+static int global_index_compare (const void * a, const void * b) {
+	const GlobalIndex * x = (const GlobalIndex *) a;
+	const GlobalIndex * y = (const GlobalIndex *) b;
+	if ( x->proc != y->proc ) {
+		return x->proc < y->proc ? -1 : 1;
+	}
+	if ( x->local != y->local ) {
+		return x->local < y->local ? -1 : 1;
+	}
+	return x->index < y->index ? -1 : ( x->index > y->index ? 1 : 0 );
+}
+
+/** Locate the elements of a gather or scatter, and sort them by owner and 
+    local offset. Elements which are split between two blocks are not 
+    included, they are transferred separately using \a fn.
+    @return the number of elements in \a sorted
+ */
+static size_t global_sort_indices (BSPObject * bsp, bsp_global_handle_t handle, 
+	const size_t * indices, size_t n, char * data, size_t nbytes, 
+	GlobalIndex * sorted, GlobalPieceFn fn ) {
+	bsp_global_array_t * array = bsp->globals.arrays + handle;
+	size_t i, m = 0;
+	for ( i = 0; i < n; ++i ) {
+		size_t offset = indices[i] * nbytes;
+		size_t r = offset - globalDivisor_divide ( &array->blocks, offset ) * array->block_size;
+		ASSERT( offset + nbytes <= array->array_size );
+		if ( r + nbytes > array->block_size ) {
+			GlobalRequest req;
+			req.data = data + i * nbytes;
+			global_split ( bsp, array, offset, nbytes, fn, &req );
+			continue;
+		}
+		sorted[m].proc = global_locate ( bsp, array, offset, &sorted[m].local );
+		sorted[m].index = i;
+		++m;
+	}
+	qsort ( sorted, m, sizeof(GlobalIndex), global_index_compare );
+	return m;
+}
+
+/** Gather elements of a global array. Element k of dest is set to
+    element indices[k] of the array at the next sync. 
+    @param src the block handle
+    @param indices the element indices
+    @param n the number of elements
+    @param dest the destination
+    @param nbytes the element size
+ */
+void BSP_CALLING bspx_global_gather (BSPObject * bsp, bsp_global_handle_t src, 
+	const size_t * indices, size_t n, void * dest, size_t nbytes ) {
+	GlobalIndex * sorted;
+	GlobalGather * gather;
+	size_t i, m, first, distinct = 0;
+
+	if ( n == 0 || nbytes == 0 ) {
+		return;
+	}
 
-	size_t offset_proc = offset * procs / gsize;
-	size_t offset_idx = offset - offset_proc*bsp->global_arrays[dest].local_size;
+	sorted = (GlobalIndex *) bsp_malloc ( n, sizeof(GlobalIndex) );
+	m = global_sort_indices ( bsp, src, indices, n, (char *) dest, nbytes, 
+		sorted, global_get_piece );
 
-	while ( size > 0 ) {
-		size_t size_todo = size > bsp->global_arrays[dest].local_size - offset_idx ? 
-			bsp->global_arrays[dest].local_size - offset_idx : size;
-		ASSERT(offset_proc < procs);
-		ASSERT(offset_idx < bsp->global_arrays[dest].local_size);
-		ASSERT(offset_idx + size_todo <= bsp->global_arrays[dest].local_size);
-		bspx_hpput (bsp, (int)offset_proc, src, bsp->global_arrays[dest].local_slice, (long int)offset_idx, size_todo );
-		src = ((char*) src) + size_todo;
-		size-= size_todo;
-		++offset_proc;
-		offset_idx = 0;
+	if ( m == 0 ) {
+		bsp_free ( sorted );
+		return;
 	}
 
+	gather = globalTable_push_gather ( &bsp->globals );
+	gather->dest = (char *) dest;
+	gather->nbytes = nbytes;
+	gather->count = m;
+	gather->targets = (size_t *) bsp_malloc ( m, sizeof(size_t) );
+	gather->positions = (size_t *) bsp_malloc ( m, sizeof(size_t) );
+	gather->staging = (char *) bsp_malloc ( m, nbytes );
+
+	/* one request per owner, which lists every element once */
+	for ( first = 0; first < m; ) {
+		size_t last, start = distinct;
+		long * offsets;
+		unsigned int count = 0;
+		for ( last = first; last < m && sorted[last].proc == sorted[first].proc; ++last ) {
+			if ( last == first || sorted[last].local != sorted[last - 1].local ) {
+				++count;
+			}
+		}
+		offsets = requestTable_push_gather ( &bsp->request_table, sorted[first].proc, 
+			memoryRegister_memoized_find ( &bsp->memory_register, sorted[first].proc, 
+				bsp->globals.arrays[src].local_slice ), 
+			gather->staging + start * nbytes, nbytes, count );
+		for ( i = first; i < last; ++i ) {
+			if ( i == first || sorted[i].local != sorted[i - 1].local ) {
+				offsets[distinct - start] = (long) sorted[i].local;
+				++distinct;
+			}
+			gather->targets[i] = sorted[i].index;
+			gather->positions[i] = distinct - 1;
+		}
+		first = last;
+	}
+	bsp_free ( sorted );
 }
 
+/** Scatter elements to a global array. Element indices[k] of the array is 
+    set to element k of src at the next sync. If an index occurs more than
+    once, the last of its elements is written. 
+    @param src the source data
+    @param dest the block handle
+    @param indices the element indices
+    @param n the number of elements
+    @param nbytes the element size
+ */
+void BSP_CALLING bspx_global_scatter (BSPObject * bsp, const void * src, bsp_global_handle_t dest, 
+	const size_t * indices, size_t n, size_t nbytes ) {
+	GlobalIndex * sorted;
+	size_t i, m, first;
+
+	if ( n == 0 || nbytes == 0 ) {
+		return;
+	}
+
+	if ( bsp->globals.arrays[dest].cache != NULL ) {
+		for ( i = 0; i < n; ++i ) {
+			globalCache_write ( bsp->globals.arrays[dest].cache, indices[i] * nbytes, nbytes );
+		}
+	}
+
+	sorted = (GlobalIndex *) bsp_malloc ( n, sizeof(GlobalIndex) );
+	m = global_sort_indices ( bsp, dest, indices, n, (char *) src, nbytes, 
+		sorted, global_put_piece );
+
+	/* one batch per owner, with the last element for every index */
+	for ( first = 0; first < m; ) {
+		size_t last, g = 0;
+		long * offsets;
+		char * values;
+		unsigned int count = 0;
+		for ( last = first; last < m && sorted[last].proc == sorted[first].proc; ++last ) {
+			if ( last == first || sorted[last].local != sorted[last - 1].local ) {
+				++count;
+			}
+		}
+		offsets = deliveryTable_push_putbatch ( &bsp->delivery_table, sorted[first].proc, 
+			memoryRegister_memoized_find ( &bsp->memory_register, sorted[first].proc, 
+				bsp->globals.arrays[dest].local_slice ), count, nbytes );
+		values = (char *) ( offsets + count );
+		for ( i = first; i < last; ++i ) {
+			if ( i + 1 == last || sorted[i + 1].local != sorted[i].local ) {
+				offsets[g] = (long) sorted[i].local;
+				memcpy ( values + g * nbytes, ((const char *) src) + sorted[i].index * nbytes, nbytes );
+				++g;
+			}
+		}
+		first = last;
+	}
+	bsp_free ( sorted );
+}
+
+/** Enable or disable the cache of a global array (see bsp_global_cache).
+    Must be called on all processors.
+    @param handle the block handle
+    @param line_size the size of the cache lines, or 0 to disable the cache
+ */
+void BSP_CALLING bspx_global_cache (BSPObject * bsp, bsp_global_handle_t handle, size_t line_size ) {
+	bsp_global_array_t * array = bsp->globals.arrays + handle;
+
+	if ( array->cache != NULL ) {
+		bspx_pop_reg ( bsp, array->cache->dirty );
+		globalCache_destruct ( array->cache );
+		bsp_free ( array->cache );
+		array->cache = NULL;
+		bsp->globals.ncached--;
+	}
+	if ( line_size == 0 ) {
+		return;
+	}
+
+	array->cache = (GlobalCache *) bsp_malloc ( 1, sizeof(GlobalCache) );
+	globalCache_initialize ( array->cache, array->array_size, line_size );
+	bspx_push_reg ( bsp, array->cache->dirty, array->cache->nwords * sizeof(unsigned int) );
+	bsp->globals.ncached++;
+}
+
+/** Get the cache statistics of a global array on this processor
+    @param handle the block handle
+    @param stats returns the statistics, which are zero if the array 
+           is not cached
+ */
+void BSP_CALLING bspx_global_cache_stats (BSPObject * bsp, bsp_global_handle_t handle, bsp_global_cache_stats_t * stats ) {
+	const GlobalCache * cache = bsp->globals.arrays[handle].cache;
+	if ( cache != NULL ) {
+		*stats = cache->stats;
+	} else {
+		memset ( stats, 0, sizeof(bsp_global_cache_stats_t) );
+	}
+}
+
+/** Notify all processors about the lines of cached arrays which were 
+    written by this processor. Called at the start of bspx_sync(): the 
+    words of the written bitmap which are not zero are ORed into the dirty
+    bitmap of every processor with one accumulating put, so the 
+    notifications of all writers travel with the puts of the superstep, 
+    and are applied in globalTable_complete(). Caches are enabled on all
+    processors together, so every processor caches the array.
+ */
+void bspx_global_flush (BSPObject * bsp ) {
+	unsigned int h;
+	int p;
+
+	for ( h = 0; bsp->globals.ncached > 0 && h < bsp->globals.count; ++h ) {
+		GlobalCache * cache = bsp->globals.arrays[h].cache;
+		size_t nbytes;
+		if ( cache == NULL || !cache->any_written ) {
+			continue;
+		}
+		nbytes = ( cache->written_last - cache->written_first + 1 ) * sizeof(unsigned int);
+		for ( p = 0; p < bsp->nprocs; ++p ) {
+			bspx_put_accumulate ( bsp, p, cache->written + cache->written_first, 
+				cache->dirty, (long int) ( cache->written_first * sizeof(unsigned int) ), 
+				nbytes, bsp_op_bor, bsp_type_int );
+		}
+		memset ( cache->written + cache->written_first, 0, nbytes );
+		cache->any_written = 0;
+	}
+}
@@ -98,4 +98,25 @@ memoryRegister_memoized_find (const ExpandableTable * RESTRICT table,
   return *(data_iter - table->info.reg.memoized_srccol + dstcol);
 }
 
+/** looks up the row of a registered local address, so the addresses on 
+ * many remote processors can be found without searching again: the address
+ * on processor p is row[table->rows * p]. Like 
+ * memoryRegister_memoized_find(), this requires a packed MemoryRegister.
+ @param table Reference to a MemoryRegister
+ @param pointer Local address of a registered memory location
+ @return the entry of processor 0 in the row of \a pointer
+*/
+static inline const MemRegElement *
+memoryRegister_memoized_row (const ExpandableTable * RESTRICT table,  
+                             const char * const pointer)
+{
+  const MemRegElement * RESTRICT data_iter = table->info.reg.memoized_data_iter;
+ 
+  /* WARNING: If element is not in register, then loop may not terminate */
+  while(*data_iter != pointer)
+    data_iter--;
+
+  return data_iter - table->info.reg.memoized_srccol;
+}
+
 #endif
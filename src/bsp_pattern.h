@@ -0,0 +1,127 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_pattern.h
+Defines BSPPattern, a recorded communication pattern (see
+bsp_pattern_begin()).
+
+While a pattern is recorded, every bsp_put() is also stored in the
+pattern. When recording ends, the destination addresses and sizes are
+sent to the receivers once, and the communication layer sets up
+persistent transfers between the send and receive buffers. Replaying
+the pattern then only copies the sources into the send buffer, starts
+the transfers, and copies the receive buffer to the destinations.
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_PATTERN_H
+#define BSP_PATTERN_H
+
+#include <string.h>
+
+#include "bsp.h"
+#include "bsp_config.h"
+#include "bsp_alloc.h"
+
+/** a recorded put */
+typedef struct
+{
+	const char * src;
+	char * dst;				/**< the address on the receiver */
+	size_t nbytes;
+	int pid;
+	unsigned int serial;	/**< keeps puts to the same processor in order */
+} PatternPut;
+
+/** a put which is received when the pattern is replayed */
+typedef struct
+{
+	char * dst;
+	size_t nbytes;
+} PatternDelivery;
+
+/** a communication pattern */
+typedef struct _bsp_pattern
+{
+	PatternPut * puts;		/**< the recorded puts, sorted by pid when recording ends */
+	unsigned int nputs;
+	unsigned int capacity;
+
+	PatternDelivery * deliveries;	/**< received puts, sorted by source */
+	unsigned int ndeliveries;
+
+	char * sendbuf;
+	int * send_bytes;		/**< bytes sent to every processor */
+	int * send_offsets;
+	char * recvbuf;
+	int * recv_bytes;		/**< bytes received from every processor */
+	int * recv_offsets;
+
+	void * transfers;		/**< persistent transfers of the communication layer */
+} BSPPattern;
+
+/** record a put
+@param pattern Reference to a BSPPattern
+@param pid the receiver
+@param src the source
+@param dst the address on the receiver
+@param nbytes the size
+*/
+static inline void
+	pattern_record (BSPPattern * RESTRICT pattern, const int pid, const void * src,
+		char * dst, const size_t nbytes)
+{
+	PatternPut * RESTRICT put;
+	if (pattern->nputs == pattern->capacity)
+	{
+		PatternPut * old = pattern->puts;
+		pattern->capacity = pattern->capacity ? 2 * pattern->capacity : 64;
+		pattern->puts = (PatternPut *) bsp_malloc (pattern->capacity, sizeof(PatternPut));
+		if (old != NULL)
+			memcpy (pattern->puts, old, pattern->nputs * sizeof(PatternPut));
+		bsp_free (old);
+	}
+	put = pattern->puts + pattern->nputs;
+	put->src = (const char *) src;
+	put->dst = dst;
+	put->nbytes = nbytes;
+	put->pid = pid;
+	put->serial = pattern->nputs++;
+}
+
+/** frees memory taken by a BSPPattern, and the pattern itself. The
+    persistent transfers must be freed by the caller.
+@param pattern Reference to a BSPPattern
+*/
+static inline void
+	pattern_free (BSPPattern * RESTRICT pattern)
+{
+	bsp_free (pattern->puts);
+	bsp_free (pattern->deliveries);
+	bsp_free (pattern->sendbuf);
+	bsp_free (pattern->send_bytes);
+	bsp_free (pattern->recvbuf);
+	bsp_free (pattern);
+}
+
+#endif
@@ -31,15 +31,11 @@ information.
 
 #include "bsp_exptable.h"
 #include "bsp_mesgqueue.h"
-
-#define BSP_MAX_GLOBAL_ARRAYS 128
-
-/** information to describe a BSP global array */
-typedef struct _bsp_global_array_t {
-	size_t array_size;
-	void * local_slice;
-	size_t local_size;
-} bsp_global_array_t;
+#include "bsp_combiner.h"
+#include "bsp_global.h"
+#include "bsp_symheap.h"
+#include "bsp_pattern.h"
+#include "bsp_eager.h"
 
 /** global variables used in bsp.c */
 typedef struct _BSPObject
@@ -63,13 +59,27 @@ typedef struct _BSPObject
 	/** Message queue. Points to all received data initiated by a bsp_send() on
 	* some processor. */
 	MessageQueue message_queue;
+	/** Sender-side message combining, see bsp_set_combiner() */
+	CombinerTable combiner;
+
+	/** global arrays, see bsp_global_alloc() */
+	GlobalTable globals;
+
+	/** symmetric heap, see bsp_symmetric_alloc() */
+	SymmetricHeap heap;
 
-	/** naive global array allocation */
-	int global_array_last;
-	/** global array allocation overflow indicator */
-	int global_overflow;
-	/** global array allocation */
-	bsp_global_array_t global_arrays[BSP_MAX_GLOBAL_ARRAYS];
+	/** neighbours, see bsp_set_neighbours(): nonzero for every processor 
+	*  this one communicates with, or NULL if it communicates with all */
+	unsigned char * neighbours;
+	/** the neighbourhood of the communication layer, or NULL */
+	void * neighbourhood;
+
+	/** the pattern which is recorded, see bsp_pattern_begin(), or NULL */
+	BSPPattern * recording;
+
+	/** columns of the delivery table which are sent during the superstep,
+	*  see bsp_set_eager_threshold() */
+	EagerChannel eager;
 
 	/** send indices. these need to be stored here since they can't be
 	*  put on the stack in a standard-conformant way */
@@ -79,4 +89,17 @@ typedef struct _BSPObject
 	unsigned int * recv_index;
 } BSPObject;
 
+/** A team: a BSP object for a subset of the processors, see bsp_team_split() */
+typedef struct _bsp_team
+{
+	BSPObject bsp;
+	/** the communicator of the team. While the team is entered, this holds
+	*  the communicator of the enclosing team instead */
+	void * comm;
+	/** the BSP object to return to in bsp_team_leave(), NULL if the team 
+	*  is not entered */
+	BSPObject * parent;
+	struct _bsp_team * parent_team;
+} BSPTeam;
+
 #endif
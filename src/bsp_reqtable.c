@@ -28,10 +28,16 @@
 #include "bsp_reqtable.h"
 #include "bsp_alloc.h"
 #include "bsp_delivtable.h"
+#include "bsp_accumulate.h"
 
 
 /** Executes the data requests. Reads all data requests and translates them in
- * data delivery: bsp_put() 
+ * data delivery: bsp_put(), or a strided put for strided gets. Gather 
+ * requests are answered with a single put of all requested elements.
+ * Atomic requests are applied after all other requests have been served, 
+ * so gets read the state from before the superstep. They are applied in 
+ * order of the requesting processor and, for every processor, in the 
+ * order they were issued, so their results are deterministic.
  @param table Reference to RequestTable
  @param deliv Reference to DeliveryTable
  */
@@ -43,15 +49,63 @@ requestTable_execute (const ExpandableTable * RESTRICT table, ExpandableTable *
 	char * RESTRICT pointer;
 	unsigned int i, j;
 
+	/* gets, strided gets and gathers */
 	for (i = 0; i < table->nprocs; i++)
 	{
 		element = (ReqElement *) table->data + i * table->rows;
 		for (j = 0; j < table->used_slot_count[i]; j++) 
 		{
+			if (element[j].count == 0 && element[j].op == REQ_OP_GATHER)
+			{
+				/* gather request, reply with all elements in one put */
+				const long * RESTRICT offsets = (const long *) (element + j + 1);
+				unsigned int k, n = element[j].info.gather.count;
+				delivery.size = n * element[j].size;
+				delivery.info.put.dst = element[j].dst;
+				pointer = deliveryTable_push(deliv, i, &delivery, it_put);
+				for (k = 0; k < n; k++)
+					memcpy(pointer + k * element[j].size, element[j].src + offsets[k], 
+						element[j].size);
+				j += requestTable_gather_slots(n);
+				continue;
+			}
+			if (element[j].count == 0)
+				continue;
+			if (element[j].count != 1)
+			{
+				/* strided get, reply with a single strided put */
+				deliveryTable_push_strided(deliv, i, element[j].dst, 
+					element[j].src + element[j].offset, element[j].info.strided.src_stride,
+					element[j].info.strided.dst_stride, element[j].size, element[j].count);
+				continue;
+			}
 			delivery.size = element[j].size;
 			delivery.info.put.dst = element[j].dst;
 			pointer = deliveryTable_push(deliv, i, &delivery, it_put);
 			memcpy(pointer, element[j].src + element[j].offset, delivery.size);
 		}  
 	}
+
+	/* atomic requests, reply with the previous value */
+	for (i = 0; i < table->nprocs; i++)
+	{
+		element = (ReqElement *) table->data + i * table->rows;
+		for (j = 0; j < table->used_slot_count[i]; j++) 
+		{
+			if (element[j].count != 0)
+				continue;
+			if (element[j].op == REQ_OP_GATHER)
+			{
+				j += requestTable_gather_slots(element[j].info.gather.count);
+				continue;
+			}
+			delivery.size = element[j].size;
+			delivery.info.put.dst = element[j].dst;
+			pointer = deliveryTable_push(deliv, i, &delivery, it_put);
+			accumulate_fetch(element[j].src + element[j].offset, pointer, 
+				(const char *) &element[j].info.atomic.operand, 
+				(const char *) &element[j].info.atomic.compare, 
+				element[j].size, element[j].op, element[j].type);
+		}  
+	}
 }
@@ -90,6 +90,31 @@ static void
 {
 }
 
+/** Number of delivery table slots the reply to a data request occupies
+@param element Description of data request
+*/
+static inline unsigned int
+	requestTable_reply_slots (const ReqElement * element)
+{
+	/* the reply is a put in the delivery table */
+	if (element->count == 0 && element->op == REQ_OP_GATHER)
+		return no_slots(sizeof(DelivElement), sizeof(ALIGNED_TYPE)) + 
+			no_slots(element->info.gather.count * element->size, sizeof(ALIGNED_TYPE));
+	return no_slots(sizeof(DelivElement), sizeof(ALIGNED_TYPE)) + 
+		(element->count <= 1 
+			? no_slots(element->size, sizeof(ALIGNED_TYPE))
+			: no_slots(sizeof(PutVector) + element->count * element->size, sizeof(ALIGNED_TYPE)));
+}
+
+/** Number of additional slots the offsets of a gather request occupy 
+@param count number of elements
+*/
+static inline unsigned int
+	requestTable_gather_slots (const unsigned int count)
+{
+	return no_slots(count * sizeof(long), sizeof(ReqElement));
+}
+
 /** Adds a data request element to the table
 @param table Reference to RequestTable
 @param proc Processor rank whereto the request is send
@@ -98,8 +123,112 @@ static void
 static inline void
 	requestTable_push (ExpandableTable * RESTRICT table, const unsigned int proc, const ReqElement * element)
 {
-	table->info.req.data_sizes[proc] += element->size + sizeof(DelivElement);
+	table->info.req.data_sizes[proc] += requestTable_reply_slots(element);
 	fixedElSizeTable_push (table, proc, &newReqInfoAtPush, element);
 }
 
+/** Adds an atomic request to the table. The owner of the source executes 
+it in requestTable_execute(), and the previous value is returned like 
+the data of a bsp_get()
+@param table Reference to RequestTable
+@param proc Processor rank whereto the request is send
+@param src remote pointer to the registered area
+@param offset offset of the element in the registered area
+@param dst local pointer where to store the previous value
+@param operand the operand (nbytes)
+@param compare the value to compare with if op is BSP_OP_CAS (nbytes), or NULL
+@param nbytes the element size
+@param op the operation (bsp_op_t or BSP_OP_CAS)
+@param type the element type (bsp_type_t)
+*/
+static inline void
+	requestTable_push_atomic (ExpandableTable * RESTRICT table, const unsigned int proc, 
+	char * src, const long offset, void * dst, const void * operand, const void * compare, 
+	const size_t nbytes, const unsigned int op, const unsigned int type)
+{
+	ReqElement elem;
+	elem.size = (int) nbytes;
+	elem.offset = (int) offset;
+	elem.src = src;
+	elem.dst = (char *) dst;
+	elem.count = 0;
+	elem.op = (unsigned short) op;
+	elem.type = (unsigned short) type;
+	memcpy (&elem.info.atomic.operand, operand, nbytes);
+	if (compare != NULL)
+		memcpy (&elem.info.atomic.compare, compare, nbytes);
+	else
+		memset (&elem.info.atomic.compare, 0, sizeof(elem.info.atomic.compare));
+	requestTable_push (table, proc, &elem);
+}
+
+/** Adds a gather request to the table. The owner of the source replies 
+with \a count elements of \a nbytes, which are read at the offsets the 
+caller copies to the returned location, as a single put to \a dst.
+@param table Reference to RequestTable
+@param proc Processor rank whereto the request is send
+@param src remote pointer to the registered area
+@param dst local pointer where to store the elements
+@param nbytes the element size
+@param count number of elements
+@return location of the \a count offsets (long)
+*/
+static inline long *
+	requestTable_push_gather (ExpandableTable * RESTRICT table, const unsigned int proc, 
+	char * src, void * dst, const size_t nbytes, const unsigned int count)
+{
+	ReqElement * RESTRICT elem;
+	unsigned int slots = 1 + requestTable_gather_slots(count);
+	int space_needed = (int) (table->used_slot_count[proc] + slots) - (int) table->rows;
+
+	if (space_needed > 0)
+		requestTable_expand(table, MAX(table->rows, (unsigned int) space_needed));
+
+	elem = (ReqElement *) (table->data + 
+		(proc * table->rows + table->used_slot_count[proc]) * table->slot_size);
+	memset (elem, 0, sizeof(ReqElement));
+	elem->size = (int) nbytes;
+	elem->src = src;
+	elem->dst = (char *) dst;
+	elem->count = 0;
+	elem->op = REQ_OP_GATHER;
+	elem->info.gather.count = count;
+	table->info.req.data_sizes[proc] += requestTable_reply_slots(elem);
+	table->used_slot_count[proc] += slots;
+	return (long *) (elem + 1);
+}
+
+/** Makes sure that every column p of a RequestTable has room for another 
+\a elements[p] requests, see requestTable_push_reserved()
+@param table Reference to RequestTable
+@param elements number of requests for every column
+*/
+static inline void
+	requestTable_reserve (ExpandableTable * RESTRICT table, const unsigned int * elements)
+{
+	unsigned int p;
+	int space_needed = 0;
+
+	for (p = 0; p < table->nprocs; p++)
+		space_needed = MAX(space_needed, 
+			(int) (elements[p] + table->used_slot_count[p]) - (int) table->rows);
+	if (space_needed > 0)
+		requestTable_expand(table, MAX(table->rows, (unsigned int) space_needed));
+}
+
+/** Adds a data request element to the table, which must have been 
+reserved using requestTable_reserve()
+@param table Reference to RequestTable
+@param proc Processor rank whereto the request is send
+@param element Description of data request
+*/
+static inline void
+	requestTable_push_reserved (ExpandableTable * RESTRICT table, const unsigned int proc, const ReqElement * element)
+{
+	table->info.req.data_sizes[proc] += requestTable_reply_slots(element);
+	memcpy (table->data + (proc * table->rows + table->used_slot_count[proc]) * table->slot_size, 
+		element, table->slot_size);
+	table->used_slot_count[proc] ++;
+}
+
 #endif
@@ -0,0 +1,220 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+/** @file bsp_symheap.h
+Defines SymmetricHeap, from which bsp_symmetric_alloc() allocates.
+
+Every processor reserves a heap of the same size. Allocations and frees
+are collective, and the allocator is deterministic, so a block has the
+same offset from the start of the heap on every processor. The address
+of a block on processor p is therefore bases[p] plus its offset, and no
+registration is needed.
+
+@author Peter Krusche
+*/
+
+#ifndef BSP_SYMHEAP_H
+#define BSP_SYMHEAP_H
+
+#include <string.h>
+#include <stdint.h>
+
+#include "bsp.h"
+#include "bsp_config.h"
+#include "bsp_alloc.h"
+#include "bsp_tools/aligned_malloc.h"
+
+/** alignment of blocks in the symmetric heap */
+#define SYMMETRIC_ALIGNMENT 64
+
+/** a block of the symmetric heap */
+typedef struct
+{
+	size_t offset;
+	size_t size;
+	int used;
+} SymmetricBlock;
+
+/** the symmetric heap */
+typedef struct
+{
+	char * base;			/**< start of the local heap, NULL until reserved */
+	size_t size;
+	char ** bases;			/**< start of the heap on every processor */
+	SymmetricBlock * blocks;	/**< all blocks, sorted by offset */
+	unsigned int nblocks;
+	unsigned int capacity;
+} SymmetricHeap;
+
+/** initializes a SymmetricHeap
+@param heap Reference to a SymmetricHeap
+*/
+static inline void
+	symmetricHeap_initialize (SymmetricHeap * RESTRICT heap)
+{
+	heap->base = NULL;
+	heap->size = 0;
+	heap->bases = NULL;
+	heap->blocks = NULL;
+	heap->nblocks = 0;
+	heap->capacity = 0;
+}
+
+/** frees memory taken by a SymmetricHeap
+@param heap Reference to a SymmetricHeap
+*/
+static inline void
+	symmetricHeap_destruct (SymmetricHeap * RESTRICT heap)
+{
+	if (heap->base != NULL)
+		aligned_free (heap->base);
+	bsp_free (heap->bases);
+	bsp_free (heap->blocks);
+}
+
+/** reserve the local heap. The caller must fill in heap->bases.
+@param heap Reference to a SymmetricHeap
+@param size the size of the heap
+@param nprocs the number of processors
+*/
+static inline void
+	symmetricHeap_reserve (SymmetricHeap * RESTRICT heap, size_t size,
+		const unsigned int nprocs)
+{
+	size = (size + SYMMETRIC_ALIGNMENT - 1) & ~(size_t) (SYMMETRIC_ALIGNMENT - 1);
+	heap->base = (char *) aligned_malloc (size, SYMMETRIC_ALIGNMENT);
+	heap->size = size;
+	heap->bases = (char **) bsp_calloc (nprocs, sizeof(char *));
+	heap->capacity = 16;
+	heap->blocks = (SymmetricBlock *) bsp_malloc (heap->capacity, sizeof(SymmetricBlock));
+	heap->blocks[0].offset = 0;
+	heap->blocks[0].size = size;
+	heap->blocks[0].used = 0;
+	heap->nblocks = 1;
+}
+
+/** test whether an address is in the local heap
+@param heap Reference to a SymmetricHeap
+@param pointer the address
+@return nonzero if the address is in the heap, 0 if there is no heap
+*/
+static inline int
+	symmetricHeap_contains (const SymmetricHeap * RESTRICT heap, const char * pointer)
+{
+	const uintptr_t base = (uintptr_t) heap->base;
+	if (heap->base == NULL)
+		return 0;
+	return (uintptr_t) pointer >= base && (uintptr_t) pointer - base < heap->size;
+}
+
+/** find the address on another processor of an address in the local heap
+@param heap Reference to a SymmetricHeap
+@param proc the processor
+@param pointer the local address
+@return the address on processor \a proc
+*/
+static inline char *
+	symmetricHeap_translate (const SymmetricHeap * RESTRICT heap, const unsigned int proc,
+		const char * pointer)
+{
+	return heap->bases[proc] + (pointer - heap->base);
+}
+
+/** allocate a block, using the first free block which is large enough
+@param heap Reference to a reserved SymmetricHeap
+@param size the size of the block
+@return the block, or NULL if the heap is exhausted
+*/
+static inline void *
+	symmetricHeap_alloc (SymmetricHeap * RESTRICT heap, size_t size)
+{
+	unsigned int b;
+	size = (size + SYMMETRIC_ALIGNMENT - 1) & ~(size_t) (SYMMETRIC_ALIGNMENT - 1);
+	if (size == 0)
+		size = SYMMETRIC_ALIGNMENT;
+
+	for (b = 0; b < heap->nblocks; b++)
+		if (!heap->blocks[b].used && heap->blocks[b].size >= size)
+			break;
+	if (b == heap->nblocks)
+		return NULL;
+
+	if (heap->blocks[b].size > size)
+	{
+		/* split, the remainder stays free */
+		if (heap->nblocks == heap->capacity)
+		{
+			SymmetricBlock * old = heap->blocks;
+			heap->capacity *= 2;
+			heap->blocks = (SymmetricBlock *) bsp_malloc (heap->capacity,
+				sizeof(SymmetricBlock));
+			memcpy (heap->blocks, old, heap->nblocks * sizeof(SymmetricBlock));
+			bsp_free (old);
+		}
+		memmove (heap->blocks + b + 2, heap->blocks + b + 1,
+			(heap->nblocks - b - 1) * sizeof(SymmetricBlock));
+		heap->blocks[b + 1].offset = heap->blocks[b].offset + size;
+		heap->blocks[b + 1].size = heap->blocks[b].size - size;
+		heap->blocks[b + 1].used = 0;
+		heap->blocks[b].size = size;
+		heap->nblocks++;
+	}
+	heap->blocks[b].used = 1;
+	return heap->base + heap->blocks[b].offset;
+}
+
+/** free a block, merging it with free neighbours
+@param heap Reference to a SymmetricHeap
+@param pointer the block
+@return 0 if \a pointer is not an allocated block, 1 otherwise
+*/
+static inline int
+	symmetricHeap_free (SymmetricHeap * RESTRICT heap, const void * pointer)
+{
+	const size_t offset = (size_t) ((const char *) pointer - heap->base);
+	unsigned int b;
+
+	for (b = 0; b < heap->nblocks; b++)
+		if (heap->blocks[b].offset == offset)
+			break;
+	if (b == heap->nblocks || !heap->blocks[b].used)
+		return 0;
+
+	heap->blocks[b].used = 0;
+	if (b + 1 < heap->nblocks && !heap->blocks[b + 1].used)
+	{
+		heap->blocks[b].size += heap->blocks[b + 1].size;
+		memmove (heap->blocks + b + 1, heap->blocks + b + 2,
+			(heap->nblocks - b - 2) * sizeof(SymmetricBlock));
+		heap->nblocks--;
+	}
+	if (b > 0 && !heap->blocks[b - 1].used)
+	{
+		heap->blocks[b - 1].size += heap->blocks[b].size;
+		memmove (heap->blocks + b, heap->blocks + b + 1,
+			(heap->nblocks - b - 1) * sizeof(SymmetricBlock));
+		heap->nblocks--;
+	}
+	return 1;
+}
+
+#endif
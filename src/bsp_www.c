@@ -342,6 +342,7 @@ digraph G {
 #include "bsp_private.h"
 #include "bsp_alloc.h"
 #include "bsp_abort.h"
+#include "bsp_accumulate.h"
 
 #include "bsp_threadsafe.h"
 
@@ -358,6 +359,16 @@ digraph G {
  ** To keep it private it is not included in bsp.h */
 BSPObject g_bsp;
 
+/** The BSP object of the team which is entered, or g_bsp */
+static BSPObject * g_current = &g_bsp;
+
+/** point-to-point communication of the eager channel */
+static const BSPX_EagerComm g_eager_comm = { _BSP_EAGER_ISEND, _BSP_EAGER_COMPLETE,
+	_BSP_EAGER_PROBE, _BSP_EAGER_RECV };
+
+/** The team which is entered, or NULL */
+static BSPTeam * g_team = NULL;
+
 /** @file bsp_www.c 
     Implements the BSPlib primitives for the BSP WWW standard.
     @author Wijnand Suijlen
@@ -426,6 +437,7 @@ bsp_end ()
 	BSP_TS_EXIT();
 
 	/* clean up datastructures */
+	_BSP_NEIGHBOURHOOD_FREE(g_bsp.neighbourhood);
 	bspx_destroy_bspobject(&g_bsp);
 
   exit_tbb();
@@ -466,7 +478,7 @@ void BSP_CALLING
 int BSP_CALLING
 	bsp_nprocs ()
 {
-	return g_bsp.nprocs;
+	return g_current->nprocs;
 }
 
 /** Returns the rank of the processor 
@@ -475,7 +487,7 @@ int BSP_CALLING
 int BSP_CALLING
 	bsp_pid ()
 {
-	return g_bsp.rank;
+	return g_current->rank;
 }
 
 /*@}*/
@@ -488,19 +500,230 @@ void BSP_CALLING
 	bsp_sync ()
 {
 	BSP_TS_LOCK();
-	bspx_sync(&g_bsp, _BSP_COMM0, _BSP_COMM1);
+	if (bspx_sync_neighbourhood(g_current) && g_current->neighbourhood != NULL)
+	{
+		_BSP_NEIGHBOURHOOD_SELECT(g_current->neighbourhood);
+		bspx_sync(g_current, _BSP_NCOMM0, _BSP_NCOMM1, &g_eager_comm, 1);
+	}
+	else
+		bspx_sync(g_current, _BSP_COMM0, _BSP_COMM1, &g_eager_comm, 0);
+	BSP_TS_UNLOCK();
+}
+
+/** Declare the processors this processor communicates with in all 
+  following supersteps, which must include all processors that 
+  communicate with it. bsp_sync() then only exchanges data and metadata 
+  with the neighbours, using neighbourhood collectives on a distributed 
+  graph communicator (MPI-3), instead of collectives over all processors.
+
+  Supersteps in which memory is registered or deregistered still 
+  synchronise all processors. Debug builds abort if a processor
+  communicates with a processor which is not its neighbour. 
+
+  Must be called by all processors of the current team, and aborts
+  unless every processor is a neighbour of its neighbours.
+  @param pids the neighbours
+  @param n the number of neighbours, or a negative number to 
+         communicate with all processors again
+*/
+void BSP_CALLING bsp_set_neighbours(const int * pids, int n) {
+	BSP_TS_LOCK();
+	_BSP_NEIGHBOURHOOD_FREE(g_current->neighbourhood);
+	g_current->neighbourhood = NULL;
+	bspx_set_neighbours(g_current, pids, n, _BSP_COMM0);
+	if (n >= 0)
+		g_current->neighbourhood = _BSP_NEIGHBOURHOOD_CREATE(pids, n, 
+			g_current->nprocs, g_current->rank);
+	BSP_TS_UNLOCK();
+}
+
+/** Start recording the puts of the current superstep. Every bsp_put() 
+  and bsp_hpput() until bsp_pattern_end() is stored in the pattern, and 
+  still delivered as usual by the next bsp_sync(). Other communication
+  requests abort while recording, only memory registration is allowed.
+
+  Iterative codes which put the same blocks to the same places in every 
+  superstep can then replay the pattern with bsp_pattern_sync(), which
+  neither exchanges the number and sizes of the puts, nor processes
+  headers: the sources are copied into a preallocated buffer, and sent 
+  with persistent point-to-point requests (MPI_Send_init, MPI_Recv_init).
+*/
+void BSP_CALLING bsp_pattern_begin() {
+	BSP_TS_LOCK();
+	bspx_pattern_begin(g_current);
+	BSP_TS_UNLOCK();
+}
+
+/** Stop recording. Must be called by all processors of the current team,
+  which exchange the destinations and sizes of the recorded puts once.
+  @return the pattern
+*/
+bsp_pattern_t BSP_CALLING bsp_pattern_end() {
+	BSPPattern * pattern;
+	BSP_TS_LOCK();
+	pattern = bspx_pattern_end(g_current, _BSP_COMM0, _BSP_COMM1);
+	pattern->transfers = _BSP_PATTERN_CREATE(pattern->sendbuf, 
+		pattern->send_bytes, pattern->send_offsets, pattern->recvbuf, 
+		pattern->recv_bytes, pattern->recv_offsets);
+	BSP_TS_UNLOCK();
+	return pattern;
+}
+
+/** Seperates two supersteps, in which only the puts of a pattern are 
+  communicated: the recorded sources are read again, and the data is 
+  written to the recorded destinations. The sources and destinations 
+  must still be valid, and no other communication may be pending.
+
+  Only processors which exchange data in the pattern synchronise with
+  each other. Must be called in the team the pattern was recorded in.
+  @param pattern the pattern
+*/
+void BSP_CALLING bsp_pattern_sync(bsp_pattern_t pattern) {
+	BSP_TS_LOCK();
+	bspx_pattern_sync(g_current, pattern, _BSP_PATTERN_RUN);
+	BSP_TS_UNLOCK();
+}
+
+/** Free a pattern
+  @param pattern the pattern
+*/
+void BSP_CALLING bsp_pattern_free(bsp_pattern_t pattern) {
+	BSP_TS_LOCK();
+	_BSP_PATTERN_FREE(pattern->transfers);
+	bspx_pattern_free(pattern);
+	BSP_TS_UNLOCK();
+}
+
+/** Send the data for a processor during the superstep, as soon as more 
+  than \a nbytes bytes have been put to it, so communication overlaps 
+  with the computation which produces the data. bsp_sync() still 
+  completes all communication, and the puts become visible at the sync 
+  as usual, in the order they were issued. The data is sent with 
+  non-blocking point-to-point messages; received data is picked up by 
+  polling in bsp_put() and at the sync, and stored until the sync.
+
+  Only puts (including bsp_put_strided() and bsp_put_indexed()) are sent 
+  early. Data for a processor which also receives messages, 
+  accumulating puts or registrations in the same superstep is sent at 
+  the sync. Processors can choose thresholds independently.
+
+  @param nbytes the threshold, or 0 (the default) to send all data at 
+         the sync
+*/
+void BSP_CALLING bsp_set_eager_threshold(size_t nbytes) {
+	BSP_TS_LOCK();
+	bspx_set_eager_threshold(g_current, nbytes, &g_eager_comm);
 	BSP_TS_UNLOCK();
 }
 
 /** Free message buffer memory */
 void BSP_CALLING bsp_reset_buffers() {
 	BSP_TS_LOCK();
-	bspx_resetbuffers(&g_bsp);
+	bspx_resetbuffers(g_current);
 	BSP_TS_UNLOCK();
 }
 
 /*@}*/
 
+/** @name Teams */
+/*@{*/
+
+/** Split the processors of the current team (initially all processors) 
+  into teams. Must be called by all processors of the current team.
+
+  A team has its own supersteps, memory register and message queue. 
+  After bsp_team_enter(), bsp_pid(), bsp_nprocs(), bsp_sync(), DRMA, 
+  BSMP, global arrays, the symmetric heap and the collectives in 
+  bsp_broadcast.h and bsp_fold.h refer to the team, so a bsp_sync() only 
+  synchronises its members. Registrations are local to the team. 
+  Teams can be nested, and can be entered and left repeatedly.
+
+  Teams are not supported in the C++ context layer (bsp::Context).
+
+  @param color processors with the same color form a team. A negative
+         color means the processor joins no team.
+  @param key the processors in a team are ranked by key, and then by their
+         pid in the current team
+  @return the new team, or NULL if \a color is negative
+*/
+bsp_team_t BSP_CALLING
+	bsp_team_split (int color, int key)
+{
+	BSPTeam * team;
+	void * comm;
+	int nprocs, rank;
+
+	BSP_TS_LOCK();
+	comm = _BSP_TEAM_SPLIT(color, key, &nprocs, &rank);
+	if (comm == NULL) 
+	{
+		BSP_TS_UNLOCK();
+		return NULL;
+	}
+	team = (BSPTeam *) bsp_malloc(1, sizeof(BSPTeam));
+	team->comm = comm;
+	team->parent = NULL;
+	team->parent_team = NULL;
+	bspx_init_bspobject(&team->bsp, nprocs, rank);
+	BSP_TS_UNLOCK();
+	return team;
+}
+
+/** Make a team the current team, until the matching bsp_team_leave().
+  Should be called at the start of a superstep of the enclosing team.
+  @param team a team created by bsp_team_split() in the current team
+*/
+void BSP_CALLING
+	bsp_team_enter (bsp_team_t team)
+{
+	BSP_TS_LOCK();
+	if (team->parent != NULL)
+		bsp_abort("bsp_team_enter: the team has already been entered.\n");
+	team->parent = g_current;
+	team->parent_team = g_team;
+	g_current = &team->bsp;
+	g_team = team;
+	_BSP_TEAM_SWAP(team->comm);
+	BSP_TS_UNLOCK();
+}
+
+/** Return to the team which was current before the last bsp_team_enter().
+  Communication in the team which has not been completed by a bsp_sync()
+  is kept until the team is entered again.
+*/
+void BSP_CALLING
+	bsp_team_leave ()
+{
+	BSPTeam * team;
+	BSP_TS_LOCK();
+	team = g_team;
+	if (team == NULL)
+		bsp_abort("bsp_team_leave: no team has been entered.\n");
+	_BSP_TEAM_SWAP(team->comm);
+	g_current = team->parent;
+	g_team = team->parent_team;
+	team->parent = NULL;
+	team->parent_team = NULL;
+	BSP_TS_UNLOCK();
+}
+
+/** Free a team. Must be called by all its members, after leaving it.
+  @param team the team
+*/
+void BSP_CALLING
+	bsp_team_free (bsp_team_t team)
+{
+	BSP_TS_LOCK();
+	if (team->parent != NULL)
+		bsp_abort("bsp_team_free: the team must be left first.\n");
+	_BSP_NEIGHBOURHOOD_FREE(team->bsp.neighbourhood);
+	bspx_destroy_bspobject(&team->bsp);
+	_BSP_TEAM_FREE(team->comm);
+	bsp_free(team);
+	BSP_TS_UNLOCK();
+}
+/*@}*/
+
 /** @name DRMA */
 /*@{*/
 /** Makes the memory location with specified size available for DRMA
@@ -514,7 +737,7 @@ void BSP_CALLING
 	bsp_push_reg (const void *ident, size_t size)
 {
 	BSP_TS_LOCK();
-	bspx_push_reg(&g_bsp, ident, size);
+	bspx_push_reg(g_current, ident, size);
 	BSP_TS_UNLOCK();
 }
 
@@ -526,10 +749,99 @@ void BSP_CALLING
 	bsp_pop_reg (const void *ident)
 {
 	BSP_TS_LOCK();
-	bspx_pop_reg(&g_bsp, ident);
+	bspx_pop_reg(g_current, ident);
 	BSP_TS_UNLOCK();
 }  
 
+/** Allocates memory which can be used with bsp_put(), bsp_get() and the 
+  other DRMA functions immediately, without bsp_push_reg(). 
+  
+  All processors must allocate and free the same sizes in the same order. 
+  Blocks are then at the same offset in a heap which every processor 
+  reserves (BSP_SYMMETRIC_HEAP_SIZE bytes, or more if the first block is
+  larger), so the remote address is found by adding the difference of 
+  the heap addresses instead of searching the memory register.
+
+  @param size the size of the block
+  @return the block
+  @see bsp_symmetric_free()
+*/
+void * BSP_CALLING
+	bsp_symmetric_alloc (size_t size)
+{
+	void * block;
+	BSP_TS_LOCK();
+	block = bspx_symmetric_alloc(g_current, size, _BSP_COMM0);
+	BSP_TS_UNLOCK();
+	return block;
+}
+
+/** Frees memory allocated with bsp_symmetric_alloc(). Must be called on 
+  all processors, and no DRMA operations on the block may be pending.
+  @param ptr the block
+*/
+void BSP_CALLING
+	bsp_symmetric_free (void * ptr)
+{
+	BSP_TS_LOCK();
+	bspx_symmetric_free(g_current, ptr);
+	BSP_TS_UNLOCK();
+}
+
+/** Dequeue all messages received in the last superstep, and start 
+  iterating over them without copying.
+
+  Messages are visited in order of their source pid, and stay valid
+  until the next bsp_sync() (see bsp_messages_keep()). Iterating needs 
+  no locking.
+
+  @param it the iterator, which is set to the first message
+  @return 1 if there is a message, 0 if the queue is empty
+*/
+int BSP_CALLING
+	bsp_messages_begin (bsp_message_t * it)
+{
+	int rv;
+	BSP_TS_LOCK();
+	rv = bspx_messages_begin(g_current, it);
+	BSP_TS_UNLOCK();
+	return rv;
+}
+
+/** Advance to the next message.
+  @param it the iterator
+  @return 1 if there is a message, 0 if all messages have been visited
+*/
+int BSP_CALLING
+	bsp_messages_next (bsp_message_t * it)
+{
+	return bspx_messages_next(it);
+}
+
+/** Take ownership of the buffer holding the messages received in the 
+  last superstep. Tags and payloads stay valid after the next bsp_sync(),
+  until the buffer is passed to bsp_messages_release().
+  @return the buffer
+*/
+void * BSP_CALLING
+	bsp_messages_keep ()
+{
+	void * rv;
+	BSP_TS_LOCK();
+	rv = bspx_messages_keep(g_current);
+	BSP_TS_UNLOCK();
+	return rv;
+}
+
+/** Free a message buffer obtained from bsp_messages_keep().
+  @param buffer the buffer
+*/
+void BSP_CALLING
+	bsp_messages_release (void * buffer)
+{
+	bsp_free(buffer);
+}
+
 /** Puts a block of data in the memory of some other processor at the next
  * superstep. This function is buffered, i.e.: the contents of \a src
  * is copied to a buffer and transmitted at the next bsp_sync() 
@@ -545,7 +857,7 @@ void BSP_CALLING
 	bsp_put (int pid, const void *src, void *dst, long int offset, size_t nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_put(&g_bsp, pid, src, dst, offset, nbytes);
+	bspx_put(g_current, pid, src, dst, offset, nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -567,7 +879,218 @@ void BSP_CALLING
 	bsp_get (int pid, const void *src, long int offset, void *dst, size_t nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_get(&g_bsp, pid, src, offset, dst, nbytes);
+	bspx_get(g_current, pid, src, offset, dst, nbytes);
+	BSP_TS_UNLOCK();
+}
+
+/** Puts \a count blocks of \a nbytes each. Block k is read from 
+ * \a src + k * \a src_stride and written to \a dst + \a offset + 
+ * k * \a dst_stride on processor \a pid. All blocks are transmitted as a
+ * single item, so this is cheaper than a put per block. This function is 
+ * buffered like bsp_put(). The order in which strided and other puts to 
+ * the same location are performed within a superstep is not defined.
+ * @param pid rank of destination (remote) processor
+ * @param src pointer to the first source block
+ * @param src_stride distance between source blocks in bytes
+ * @param dst pointer to the registered destination area
+ * @param offset offset of the first block from \a dst in bytes
+ * @param dst_stride distance between destination blocks in bytes
+ * @param nbytes size of each block
+ * @param count number of blocks
+*/
+void BSP_CALLING
+	bsp_put_strided (int pid, const void *src, long int src_stride, void *dst, 
+	long int offset, long int dst_stride, size_t nbytes, int count)
+{
+	BSP_TS_LOCK();
+	bspx_put_strided(g_current, pid, src, src_stride, dst, offset, dst_stride, nbytes, count);
+	BSP_TS_UNLOCK();
+}
+
+/** Gets \a count blocks of \a nbytes each. Block k is read from 
+ * \a src + \a offset + k * \a src_stride on processor \a pid and written 
+ * to \a dst + k * \a dst_stride. The blocks are requested and returned as
+ * a single item. This function is buffered like bsp_get().
+ * @param pid Rank of the source (remote) processor 
+ * @param src pointer to the registered source area
+ * @param offset offset of the first block from \a src in bytes
+ * @param src_stride distance between source blocks in bytes
+ * @param dst pointer to the first destination block
+ * @param dst_stride distance between destination blocks in bytes
+ * @param nbytes size of each block
+ * @param count number of blocks
+*/
+void BSP_CALLING
+	bsp_get_strided (int pid, const void *src, long int offset, long int src_stride, 
+	void *dst, long int dst_stride, size_t nbytes, int count)
+{
+	BSP_TS_LOCK();
+	bspx_get_strided(g_current, pid, src, offset, src_stride, dst, dst_stride, nbytes, count);
+	BSP_TS_UNLOCK();
+}
+
+/** Puts \a count blocks of different sizes. Block k is read from 
+ * \a src + blocks[k].src_offset and written to \a dst + blocks[k].dst_offset
+ * on processor \a pid. All blocks are transmitted as a single item. This 
+ * function is buffered like bsp_put().
+ * @param pid rank of destination (remote) processor
+ * @param src source pointer
+ * @param dst pointer to the registered destination area
+ * @param blocks the blocks
+ * @param count number of blocks
+*/
+void BSP_CALLING
+	bsp_put_indexed (int pid, const void *src, void *dst, const bsp_block_t * blocks, int count)
+{
+	BSP_TS_LOCK();
+	bspx_put_indexed(g_current, pid, src, dst, blocks, count);
+	BSP_TS_UNLOCK();
+}
+
+/** Gets \a count blocks of different sizes. Block k is read from 
+ * \a src + blocks[k].src_offset on processor \a pid and written to 
+ * \a dst + blocks[k].dst_offset. This function is buffered like bsp_get().
+ * @param pid Rank of the source (remote) processor 
+ * @param src pointer to the registered source area
+ * @param dst destination pointer
+ * @param blocks the blocks
+ * @param count number of blocks
+*/
+void BSP_CALLING
+	bsp_get_indexed (int pid, const void *src, void *dst, const bsp_block_t * blocks, int count)
+{
+	BSP_TS_LOCK();
+	bspx_get_indexed(g_current, pid, src, dst, blocks, count);
+	BSP_TS_UNLOCK();
+}
+
+/** Puts data which is combined with the destination at the next superstep
+ * using a reduction operation, e.g. bsp_op_sum adds it. Puts from several 
+ * processors to the same location are all combined. Accumulating puts are
+ * executed after all other puts of the same superstep. This function is 
+ * buffered like bsp_put().
+ * @param pid rank of destination (remote) processor
+ * @param src pointer to the source data
+ * @param dst pointer to the registered destination area
+ * @param offset offset from \a dst in bytes, which must be aligned for 
+ *        the element type
+ * @param nbytes number of bytes (a multiple of the element size)
+ * @param op the operation, bitwise operations are only defined for 
+ *        integer types
+ * @param type the element type
+*/
+void BSP_CALLING
+	bsp_put_accumulate (int pid, const void *src, void *dst, long int offset, 
+	size_t nbytes, bsp_op_t op, bsp_type_t type)
+{
+	BSP_TS_LOCK();
+	bspx_put_accumulate(g_current, pid, src, dst, offset, nbytes, op, type);
+	BSP_TS_UNLOCK();
+}
+
+/** Registers a user-defined operation for bsp_put_accumulate(). All 
+ * processors must register the same operations in the same order, 
+ * the element type is ignored for user-defined operations.
+ * @param fn the operation
+ * @return the number of the operation
+*/
+bsp_op_t BSP_CALLING
+	bsp_register_op (bsp_accumulate_fn fn)
+{
+	bsp_op_t op;
+	BSP_TS_LOCK();
+	op = accumulate_register(fn);
+	BSP_TS_UNLOCK();
+	return op;
+}
+
+/** Combines an operand with one element of a registered area on a remote
+ * processor, e.g. adds it for bsp_op_sum, and stores the previous value
+ * of the element in \a result at the next bsp_sync(). Like the data of 
+ * bsp_get(), the previous value is read before any puts of the same 
+ * superstep are delivered. Every processor executes the requests it 
+ * receives one after the other, in the order of the requesting pids and 
+ * then in the order they were issued, so the results are deterministic.
+ * @param pid rank of the remote processor
+ * @param src pointer to the registered area
+ * @param offset offset of the element from \a src in bytes
+ * @param operand the operand (one element)
+ * @param result where to store the previous value (one element)
+ * @param op the operation
+ * @param type the element type
+*/
+void BSP_CALLING
+	bsp_fetch_op (int pid, const void *src, long int offset, const void *operand, 
+	void *result, bsp_op_t op, bsp_type_t type)
+{
+	BSP_TS_LOCK();
+	bspx_fetch_op(g_current, pid, src, offset, operand, result, op, type);
+	BSP_TS_UNLOCK();
+}
+
+/** Compare-and-swap on one element of a registered area on a remote 
+ * processor. The element is replaced by \a value if it is bitwise equal 
+ * to \a compare, and its previous value is stored in \a result at the 
+ * next bsp_sync(). The swap succeeded if the result equals \a compare.
+ * Requests are executed in the same order as those of bsp_fetch_op().
+ * @param pid rank of the remote processor
+ * @param src pointer to the registered area
+ * @param offset offset of the element from \a src in bytes
+ * @param compare the expected value (one element)
+ * @param value the new value (one element)
+ * @param result where to store the previous value (one element)
+ * @param type the element type
+*/
+void BSP_CALLING
+	bsp_cas (int pid, const void *src, long int offset, const void *compare, 
+	const void *value, void *result, bsp_type_t type)
+{
+	BSP_TS_LOCK();
+	bspx_cas(g_current, pid, src, offset, compare, value, result, type);
+	BSP_TS_UNLOCK();
+}
+
+/** Puts \a count values of \a nbytes each into one registered area. Value 
+ * k is written to \a dst + offsets[k] on processor pids[k]. This has the
+ * same effect as a bsp_put() for every value, but the lock, the address
+ * translation and the buffer management are done once per call, and 
+ * every destination receives all its values as a single item. This 
+ * function is buffered like bsp_put().
+ * @param dst pointer to the registered destination area
+ * @param pids destination processor of every value
+ * @param offsets offset from \a dst in bytes for every value
+ * @param values the values (\a count * \a nbytes bytes)
+ * @param nbytes size of each value
+ * @param count number of values
+*/
+void BSP_CALLING
+	bsp_put_batch (void *dst, const int * pids, const long int * offsets, 
+	const void * values, size_t nbytes, int count)
+{
+	BSP_TS_LOCK();
+	bspx_put_batch(g_current, dst, pids, offsets, values, nbytes, count);
+	BSP_TS_UNLOCK();
+}
+
+/** Gets \a count values of \a nbytes each from one registered area. Value 
+ * k is read from \a src + offsets[k] on processor pids[k] and written to 
+ * values + k * \a nbytes. This has the same effect as a bsp_get() for 
+ * every value, but the lock, the address translation and the buffer 
+ * management are done once per call. This function is buffered like 
+ * bsp_get().
+ * @param src pointer to the registered source area
+ * @param pids source processor of every value
+ * @param offsets offset from \a src in bytes for every value
+ * @param values destination of the values (\a count * \a nbytes bytes)
+ * @param nbytes size of each value
+ * @param count number of values
+*/
+void BSP_CALLING
+	bsp_get_batch (const void *src, const int * pids, const long int * offsets, 
+	void * values, size_t nbytes, int count)
+{
+	BSP_TS_LOCK();
+	bspx_get_batch(g_current, src, pids, offsets, values, nbytes, count);
 	BSP_TS_UNLOCK();
 }
 /*@}*/
@@ -587,7 +1110,7 @@ void BSP_CALLING
 	bsp_send (int pid, const void *tag, const void *payload, size_t payload_nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_send(&g_bsp, pid, tag, payload, payload_nbytes);
+	bspx_send(g_current, pid, tag, payload, payload_nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -601,7 +1124,7 @@ void BSP_CALLING
 	bsp_qsize (int * RESTRICT nmessages, size_t * RESTRICT accum_nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_qsize(&g_bsp, nmessages, accum_nbytes);
+	bspx_qsize(g_current, nmessages, accum_nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -616,7 +1139,7 @@ void BSP_CALLING
 bsp_get_tag (int * RESTRICT status , void * RESTRICT tag)
 {
 	BSP_TS_LOCK();
-	bspx_get_tag(&g_bsp, status, tag);
+	bspx_get_tag(g_current, status, tag);
 	BSP_TS_UNLOCK();
 }
 
@@ -629,7 +1152,23 @@ void BSP_CALLING
 	bsp_move (void *payload, size_t reception_nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_move(&g_bsp, payload, reception_nbytes);
+	bspx_move(g_current, payload, reception_nbytes);
+	BSP_TS_UNLOCK();
+}
+
+/** Sets a sender-side combiner. Messages to the same destination with the
+  same key are combined into a single message before they are sent, the
+  combined message keeps the tag of the first one. The combiner applies 
+  to all subsequent calls to bsp_send() by this processor, until it is 
+  switched off by passing NULL.
+  @param key key extractor
+  @param combine associative combine function
+ */ 
+void BSP_CALLING
+	bsp_set_combiner (bsp_combiner_key_fn key, bsp_combiner_fn combine)
+{
+	BSP_TS_LOCK();
+	bspx_set_combiner(g_current, key, combine);
 	BSP_TS_UNLOCK();
 }
 
@@ -641,7 +1180,7 @@ void BSP_CALLING
 	bsp_set_tagsize (size_t *tag_nbytes)
 {
 	BSP_TS_LOCK();
-	bspx_set_tagsize(&g_bsp, tag_nbytes);
+	bspx_set_tagsize(g_current, tag_nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -663,7 +1202,7 @@ int BSP_CALLING
 {
 	int rv;
 	BSP_TS_LOCK();
-	rv = bspx_hpmove(&g_bsp, tag_ptr, payload_ptr);
+	rv = bspx_hpmove(g_current, tag_ptr, payload_ptr);
 	BSP_TS_UNLOCK();
 	return rv;
 }
@@ -681,7 +1220,7 @@ int BSP_CALLING
 */
 void BSP_CALLING bsp_hpput (int pid, const void * src, void * dst, long int offset, size_t nbytes) {
 	BSP_TS_LOCK();
-	bspx_hpput(&g_bsp, pid, src, dst, offset, nbytes);
+	bspx_hpput(g_current, pid, src, dst, offset, nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -700,7 +1239,7 @@ void BSP_CALLING bsp_hpput (int pid, const void * src, void * dst, long int offs
 */
 void BSP_CALLING bsp_hpget (int pid, const void * src, long int offset, void * dst, size_t nbytes) {
 	BSP_TS_LOCK();
-	bspx_hpget(&g_bsp, pid, src, offset, dst, nbytes);
+	bspx_hpget(g_current, pid, src, offset, dst, nbytes);
 	BSP_TS_UNLOCK();
 }
 
@@ -711,37 +1250,112 @@ void BSP_CALLING bsp_hpget (int pid, const void * src, long int offset, void * d
 
 bsp_global_handle_t BSP_CALLING bsp_global_alloc(size_t array_size) {
 	bsp_global_handle_t v;
-	v = bspx_global_alloc(&g_bsp, array_size);
+	v = bspx_global_alloc(g_current, array_size);
+	return v;
+}
+
+bsp_global_handle_t BSP_CALLING bsp_global_alloc_dist(size_t array_size, bsp_dist_t dist, size_t block_size, bsp_global_owner_fn owner) {
+	bsp_global_handle_t v;
+	v = bspx_global_alloc_dist(g_current, array_size, dist, block_size, owner);
 	return v;
 }
 
+int BSP_CALLING bsp_global_owner(bsp_global_handle_t handle, size_t offset) {
+	return bspx_global_owner(g_current, handle, offset);
+}
+
 void BSP_CALLING bsp_global_free(bsp_global_handle_t ptr) {
-	bspx_global_free(&g_bsp, ptr);
+	bspx_global_free(g_current, ptr);
 }
 
 void BSP_CALLING bsp_global_get(bsp_global_handle_t src, size_t offset, void * dest, size_t size) {
 	BSP_TS_LOCK();
-	bspx_global_get(&g_bsp, src, offset, dest, size);
+	bspx_global_get(g_current, src, offset, dest, size);
 	BSP_TS_UNLOCK();	
 }
 
 void BSP_CALLING bsp_global_put(const void * src, bsp_global_handle_t dest, size_t offset, size_t size) {
 	BSP_TS_LOCK();
-	bspx_global_put(&g_bsp, src, dest, offset, size);
+	bspx_global_put(g_current, src, dest, offset, size);
 	BSP_TS_UNLOCK();	
 }
 
 void BSP_CALLING bsp_global_hpget(bsp_global_handle_t src, size_t offset, void * dest, size_t size) {
 	BSP_TS_LOCK();
-	bspx_global_hpget(&g_bsp, src, offset, dest, size);
+	bspx_global_hpget(g_current, src, offset, dest, size);
 	BSP_TS_UNLOCK();	
 }
 
 void BSP_CALLING bsp_global_hpput(const void * src, bsp_global_handle_t dest, size_t offset, size_t size) {
 	BSP_TS_LOCK();
-	bspx_global_hpput(&g_bsp, src, dest, offset, size);
+	bspx_global_hpput(g_current, src, dest, offset, size);
+	BSP_TS_UNLOCK();	
+}
+
+void BSP_CALLING bsp_global_put_accumulate(const void * src, bsp_global_handle_t dest, size_t offset, size_t size, bsp_op_t op, bsp_type_t type) {
+	BSP_TS_LOCK();
+	bspx_global_put_accumulate(g_current, src, dest, offset, size, op, type);
+	BSP_TS_UNLOCK();	
+}
+
+/** Gather elements of a global array: element k of \a dest is set to 
+    element indices[k] of the array at the next bsp_sync(). Every owner
+    receives a single list of the distinct elements it holds, and 
+    replies with them in the same superstep.
+    @param src the global array
+    @param indices the element indices
+    @param n the number of elements
+    @param dest the destination
+    @param nbytes the element size
+ */
+void BSP_CALLING bsp_global_gather(bsp_global_handle_t src, const size_t * indices, size_t n, void * dest, size_t nbytes) {
+	BSP_TS_LOCK();
+	bspx_global_gather(g_current, src, indices, n, dest, nbytes);
 	BSP_TS_UNLOCK();	
 }
 
+/** Scatter elements to a global array: element indices[k] of the array 
+    is set to element k of \a src at the next bsp_sync(). Every owner 
+    receives a single batch. If an index occurs more than once, the last
+    of its elements is written. \a src is copied immediately.
+    @param src the source data
+    @param dest the global array
+    @param indices the element indices
+    @param n the number of elements
+    @param nbytes the element size
+ */
+void BSP_CALLING bsp_global_scatter(const void * src, bsp_global_handle_t dest, const size_t * indices, size_t n, size_t nbytes) {
+	BSP_TS_LOCK();
+	bspx_global_scatter(g_current, src, dest, indices, n, nbytes);
+	BSP_TS_UNLOCK();	
+}
+
+/** Enable or disable the cache of a global array. Cached bsp_global_get()
+    requests are served from a local copy of the array, which is split 
+    into lines of \a line_size bytes. Lines are fetched when they are 
+    first read, and stay valid until any processor writes to them with 
+    bsp_global_put(), bsp_global_hpput(), bsp_global_put_accumulate() or
+    bsp_global_scatter(). Lines which are written in a superstep are 
+    invalidated on all processors at the end of the following bsp_sync().
+
+    All processors must call this function for the same array in the 
+    same superstep, and the cache can be used after the next bsp_sync().
+    @param handle the global array
+    @param line_size the size of the cache lines, or 0 to disable the cache
+ */
+void BSP_CALLING bsp_global_cache(bsp_global_handle_t handle, size_t line_size) {
+	BSP_TS_LOCK();
+	bspx_global_cache(g_current, handle, line_size);
+	BSP_TS_UNLOCK();	
+}
+
+/** Get the statistics of the cache of a global array on this processor
+    @param handle the global array
+    @param stats returns the statistics
+ */
+void BSP_CALLING bsp_global_cache_stats(bsp_global_handle_t handle, bsp_global_cache_stats_t * stats) {
+	bspx_global_cache_stats(g_current, handle, stats);
+}
+
 /*@}*/
 
@@ -30,6 +30,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "bspx.h"
 #include "bsp_memreg.h"
@@ -39,6 +40,7 @@
 #include "bsp_private.h"
 #include "bsp_alloc.h"
 #include "bsp_abort.h"
+#include "bsp_accumulate.h"
 
 /** Create buffers within a BSP object
  *
@@ -50,13 +52,14 @@ inline void bspx_init_bspobject (BSPObject * bsp, int nprocs, int rank) {
 	bsp->nprocs = nprocs;
 	bsp->rank = rank;
 
-	bsp->send_index = (unsigned int *)bsp_malloc(3 * bsp->nprocs, sizeof(unsigned int));
-	bsp->recv_index = (unsigned int *)bsp_malloc(3 * bsp->nprocs, sizeof(unsigned int));
+	bsp->send_index = (unsigned int *)bsp_malloc(4 * bsp->nprocs, sizeof(unsigned int));
+	bsp->recv_index = (unsigned int *)bsp_malloc(4 * bsp->nprocs, sizeof(unsigned int));
 
 	/* initialize data structures */
 	memoryRegister_initialize(&bsp->memory_register, bsp->nprocs, BSP_MEMREG_MIN_SIZE,
 		bsp->rank);
 	messageQueue_initialize (&bsp->message_queue);
+	combinerTable_initialize (&bsp->combiner, bsp->nprocs);
 	deliveryTable_initialize(&bsp->delivery_table, bsp->nprocs, BSP_DELIVTAB_MIN_SIZE);
 	requestTable_initialize(&bsp->request_table, bsp->nprocs, BSP_REQTAB_MIN_SIZE);
 	deliveryTable_initialize(&bsp->delivery_received_table, bsp->nprocs, 
@@ -64,8 +67,12 @@ inline void bspx_init_bspobject (BSPObject * bsp, int nprocs, int rank) {
 	requestTable_initialize(&bsp->request_received_table, bsp->nprocs,
 		BSP_REQTAB_MIN_SIZE);
 
-	bsp->global_array_last = 0;
-	bsp->global_overflow = 0;
+	globalTable_initialize(&bsp->globals);
+	symmetricHeap_initialize(&bsp->heap);
+	bsp->neighbours = NULL;
+	bsp->neighbourhood = NULL;
+	bsp->recording = NULL;
+	eagerChannel_initialize(&bsp->eager, bsp->nprocs);
 
 	/* save starting time */
 	bsp->begintime = 0; // bsp->begintime is used in bsp_time(), so must be initialized
@@ -84,6 +91,13 @@ inline void bspx_destroy_bspobject (BSPObject * bsp) {
 	requestTable_destruct(&bsp->request_table);
 	deliveryTable_destruct(&bsp->delivery_received_table);
 	requestTable_destruct(&bsp->request_received_table);
+	combinerTable_destruct(&bsp->combiner);
+	globalTable_destruct(&bsp->globals);
+	symmetricHeap_destruct(&bsp->heap);
+	bsp_free(bsp->neighbours);
+	if (bsp->recording != NULL)
+		pattern_free(bsp->recording);
+	eagerChannel_destruct(&bsp->eager);
 
 	bsp_free(bsp->recv_index);
 	bsp_free(bsp->send_index);
@@ -93,8 +107,61 @@ inline void bspx_destroy_bspobject (BSPObject * bsp) {
 /** @name Superstep */
 /*@{*/
 
-/** Execute superstep data transfers. */ 
-void bspx_sync (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator ) {
+/** Receive the chunks which were sent during the superstep and have not
+ * been received while polling. Then wait until the chunks this processor 
+ * sent have been received. The chunks are executed by bspx_eager_execute().
+ * @param bsp The BSPObject to use. 
+ * @param eager the point-to-point communication of the eager channel
+ */
+static void bspx_eager_complete (BSPObject * bsp, const BSPX_EagerComm * eager)
+{
+	EagerChannel * RESTRICT channel = &bsp->eager;
+	int p;
+
+	channel->comm = eager;
+	for (p = 0; p < bsp->nprocs; p++)
+	{
+		while (channel->received[p] < bsp->recv_index[4*p + 3])
+		{
+			int source = p;
+			const int size = eager->probe(&source, 1);
+			eagerChannel_receive(channel, source, size);
+		}
+	}
+
+	eagerChannel_complete_sends(channel, 1);
+	memset(channel->sent, 0, 2 * bsp->nprocs * sizeof(unsigned int));
+}
+
+/** Executes and frees the chunks received from a processor. Called by 
+ * deliveryTable_execute() before the column of that processor, since
+ * the chunks hold its earlier puts.
+ * @param arg the EagerChannel
+ * @param pid the source
+ */
+static void bspx_eager_execute (void * arg, unsigned int pid)
+{
+	EagerChannel * RESTRICT channel = (EagerChannel *) arg;
+	EagerChunk * RESTRICT staged = channel->staged[pid];
+	unsigned int i;
+
+	for (i = 0; i < channel->nstaged[pid]; i++)
+	{
+		const unsigned int * RESTRICT index = (const unsigned int *) staged[i].data;
+		deliveryColumn_execute_puts((const ALIGNED_TYPE *) staged[i].data, 
+			index, index + it_count);
+		bsp_free(staged[i].data);
+	}
+	channel->nstaged[pid] = 0;
+}
+
+/** Execute superstep data transfers.
+ * @param neighbourhood nonzero if infocomm and communicator only reach the
+ *        neighbours. Processors then do not know whether any processor 
+ *        has gets, so the requests are always exchanged.
+ */ 
+void bspx_sync (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator,
+	const BSPX_EagerComm * eager, int neighbourhood ) {
 	unsigned int maxreqrows = 0, maxdelrows = 0, p;
 	unsigned int any_gets = 0; 
 	/* any_gets is a boolean value, whether there are
@@ -106,25 +173,29 @@ void bspx_sync (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator
 	requestTable_reset(&bsp->request_received_table);
 	deliveryTable_reset(&bsp->delivery_received_table);
 
+	/* notify the readers of cached global arrays about writes */
+	bspx_global_flush(bsp);
+
 	/* communicate information */
 	for (p = 0; p < (unsigned)bsp->nprocs; p++)
 		any_gets |= bsp->request_table.used_slot_count[p];
 
 	for (p = 0; p < (unsigned)bsp->nprocs; p++)
 	{
-		bsp->send_index[3*p    ] = bsp->request_table.used_slot_count[p];
-		bsp->send_index[3*p + 1] = bsp->delivery_table.used_slot_count[p];
-		bsp->send_index[3*p + 2] = any_gets;
+		bsp->send_index[4*p    ] = bsp->request_table.used_slot_count[p];
+		bsp->send_index[4*p + 1] = bsp->delivery_table.used_slot_count[p];
+		bsp->send_index[4*p + 2] = any_gets;
+		bsp->send_index[4*p + 3] = bsp->eager.sent[p];
 	}  
 
-	infocomm (	bsp->send_index, 3*sizeof(unsigned int), 
-				bsp->recv_index, 3*sizeof(unsigned int)
+	infocomm (	bsp->send_index, 4*sizeof(unsigned int), 
+				bsp->recv_index, 4*sizeof(unsigned int)
 	);
 
 	/* expand buffers if necessary */
-	maxreqrows = array_max(bsp->recv_index, 3*bsp->nprocs, 3);
+	maxreqrows = array_max(bsp->recv_index, 4*bsp->nprocs, 4);
 	for (p = 0; p < (unsigned)bsp->nprocs; p++)
-		maxdelrows = MAX( bsp->recv_index[1 + 3*p] + 
+		maxdelrows = MAX( bsp->recv_index[1 + 4*p] + 
 		bsp->request_table.info.req.data_sizes[p], maxdelrows);
 
 	if ( bsp->request_received_table.rows < maxreqrows ) {
@@ -141,15 +212,15 @@ void bspx_sync (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator
 	/* copy necessary indices to received_tables */
 	for (p = 0; p < (unsigned)bsp->nprocs; p++) 
 	{
-		bsp->request_received_table.used_slot_count[p] = bsp->recv_index[3*p];
+		bsp->request_received_table.used_slot_count[p] = bsp->recv_index[4*p];
 		bsp->delivery_received_table.used_slot_count[p] =
-			bsp->recv_index[1 + 3*p] + bsp->request_table.info.req.data_sizes[p] ;
+			bsp->recv_index[1 + 4*p] + bsp->request_table.info.req.data_sizes[p] ;
 	}	
 
 	/* Now we may conclude something about the communcation pattern */
-	any_gets = 0;
+	any_gets = neighbourhood;
 	for (p = 0; p < (unsigned)bsp->nprocs; p++)   
-		any_gets |= bsp->recv_index[3*p + 2];
+		any_gets |= bsp->recv_index[4*p + 2];
 
 	/* communicate & execute */
 	if (any_gets) 
@@ -161,17 +232,270 @@ void bspx_sync (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator
 
 	expandableTable_comm(&bsp->delivery_table, &bsp->delivery_received_table,
 		communicator);
+	/* puts sent during the superstep come before the rest of their column */
+	bspx_eager_complete(bsp, eager);
 	deliveryTable_execute(&bsp->delivery_received_table, 
-		&bsp->memory_register, &bsp->message_queue, bsp->rank);
+		&bsp->memory_register, &bsp->message_queue, bsp->rank,
+		bspx_eager_execute, &bsp->eager);
+	globalTable_complete(&bsp->globals);
 	
 	/* clear the buffers */			
 	requestTable_reset(&bsp->request_table);
 	deliveryTable_reset(&bsp->delivery_table);
+	combinerTable_reset(&bsp->combiner);
 
 	/* pack the memoryRegister */
 	memoryRegister_pack(&bsp->memory_register);
 }
 
+/** Restricts communication to a set of neighbours, or lifts the 
+ * restriction.
+ * @param bsp The BSPObject to use. 
+ * @param pids the neighbours
+ * @param n the number of neighbours, or a negative number to communicate 
+ *        with all processors
+ * @param infocomm exchanges the neighbours to check that they are symmetric
+ * @see bsp_set_neighbours()
+ */
+void bspx_set_neighbours (BSPObject * bsp, const int * pids, int n, BSPX_CommFn0 infocomm)
+{
+	int i;
+	unsigned char * RESTRICT flags = (unsigned char *) 
+		bsp_malloc(bsp->nprocs, sizeof(unsigned char));
+	unsigned char * RESTRICT mirrored = (unsigned char *) 
+		bsp_malloc(bsp->nprocs, sizeof(unsigned char));
+
+	memset(flags, n < 0, bsp->nprocs);
+	flags[bsp->rank] = 1;
+	for (i = 0; i < n; i++)
+	{
+		if (pids[i] < 0 || pids[i] >= bsp->nprocs)
+			bsp_abort("bsp_set_neighbours: neighbour %d is out of range.\n", pids[i]);
+		flags[pids[i]] = 1;
+	}
+
+	/* processor p receives whether q declared it as a neighbour */
+	infocomm(flags, sizeof(unsigned char), mirrored, sizeof(unsigned char));
+	for (i = 0; i < bsp->nprocs; i++)
+		if (flags[i] != mirrored[i])
+			bsp_abort("bsp_set_neighbours: processor %d declares %d as a neighbour, "
+				"but not vice versa.\n", flags[i] ? bsp->rank : i, flags[i] ? i : bsp->rank);
+	bsp_free(mirrored);
+
+	bsp_free(bsp->neighbours);
+	bsp->neighbours = NULL;
+	if (n < 0)
+		bsp_free(flags);
+	else
+		bsp->neighbours = flags;
+}
+
+/** Tests whether the next sync can be restricted to the neighbours. This
+ * is the case unless memory is registered or deregistered in this 
+ * superstep, or global arrays are cached, which all processors do at the 
+ * same time. In debug builds,
+ * communication with other processors is reported.
+ * @param bsp The BSPObject to use. 
+ * @return nonzero if only neighbours need to communicate
+ */
+int bspx_sync_neighbourhood (BSPObject * bsp)
+{
+	const unsigned int * RESTRICT count;
+	if (bsp->neighbours == NULL)
+		return 0;
+
+	/* cached global arrays notify all processors about writes */
+	count = bsp->delivery_table.info.deliv.count[bsp->rank];
+	if (count[it_pushreg] > 0 || count[it_popreg] > 0 || bsp->globals.ncached > 0)
+		return 0;
+
+#ifdef _DEBUG
+	{
+		int p;
+		for (p = 0; p < bsp->nprocs; p++)
+			if (!bsp->neighbours[p] && 
+				(bsp->request_table.used_slot_count[p] > 0 ||
+				 bsp->delivery_table.used_slot_count[p] > (unsigned int) DELIVTABLE_INDEX_SIZE ||
+				 bsp->eager.sent[p] > 0))
+				bsp_abort("bsp_sync: processor %d communicates with %d, "
+					"which is not a neighbour.\n", bsp->rank, p);
+	}
+#endif
+	return 1;
+}
+
+/** Starts recording the puts of a superstep into a new pattern.
+ * @param bsp The BSPObject to use. 
+ * @see bsp_pattern_begin()
+ */
+void bspx_pattern_begin (BSPObject * bsp)
+{
+	if (bsp->recording != NULL)
+		bsp_abort("bsp_pattern_begin: a pattern is already recorded.\n");
+	bsp->recording = (BSPPattern *) bsp_calloc(1, sizeof(BSPPattern));
+}
+
+static int pattern_put_compare (const void * a, const void * b)
+{
+	const PatternPut * x = (const PatternPut *) a, * y = (const PatternPut *) b;
+	if (x->pid != y->pid)
+		return x->pid - y->pid;
+	return x->serial < y->serial ? -1 : (x->serial > y->serial);
+}
+
+/** Stops recording, and sends the destinations and sizes of the recorded
+ * puts to their receivers. Must be called on all processors. The puts of 
+ * the superstep are still delivered by the next bsp_sync().
+ * @param bsp The BSPObject to use. 
+ * @param infocomm used to exchange the number of puts
+ * @param communicator used to exchange the destinations and sizes
+ * @return the pattern, without transfers
+ */
+BSPPattern * bspx_pattern_end (BSPObject * bsp, BSPX_CommFn0 infocomm, BSPX_CommFn communicator)
+{
+	BSPPattern * RESTRICT pattern = bsp->recording;
+	PatternDelivery * sent;
+	const unsigned int nprocs = (unsigned) bsp->nprocs;
+	unsigned int p, i;
+	int * RESTRICT counts;
+	size_t total;
+
+	if (pattern == NULL)
+		bsp_abort("bsp_pattern_end: no pattern is recorded.\n");
+	bsp->recording = NULL;
+
+	qsort(pattern->puts, pattern->nputs, sizeof(PatternPut), pattern_put_compare);
+
+	/* send_bytes, send_offsets, recv_bytes and recv_offsets */
+	counts = (int *) bsp_malloc(4 * nprocs, sizeof(int));
+	pattern->send_bytes = counts;
+	pattern->send_offsets = counts + nprocs;
+	pattern->recv_bytes = counts + 2 * nprocs;
+	pattern->recv_offsets = counts + 3 * nprocs;
+
+	/* exchange the number of puts */
+	for (p = 0; p < nprocs; p++)
+		bsp->send_index[p] = 0;
+	for (i = 0; i < pattern->nputs; i++)
+		bsp->send_index[pattern->puts[i].pid]++;
+	infocomm(bsp->send_index, sizeof(unsigned int), bsp->recv_index, sizeof(unsigned int));
+
+	/* exchange destinations and sizes */
+	pattern->ndeliveries = 0;
+	for (p = 0; p < nprocs; p++)
+	{
+		pattern->send_bytes[p] = (int) (bsp->send_index[p] * sizeof(PatternDelivery));
+		pattern->recv_bytes[p] = (int) (bsp->recv_index[p] * sizeof(PatternDelivery));
+		pattern->send_offsets[p] = p == 0 ? 0 : 
+			pattern->send_offsets[p - 1] + pattern->send_bytes[p - 1];
+		pattern->recv_offsets[p] = p == 0 ? 0 :
+			pattern->recv_offsets[p - 1] + pattern->recv_bytes[p - 1];
+		pattern->ndeliveries += bsp->recv_index[p];
+	}
+	sent = (PatternDelivery *) bsp_malloc(pattern->nputs + 1, sizeof(PatternDelivery));
+	for (i = 0; i < pattern->nputs; i++)
+	{
+		sent[i].dst = pattern->puts[i].dst;
+		sent[i].nbytes = pattern->puts[i].nbytes;
+	}
+	pattern->deliveries = (PatternDelivery *) bsp_malloc(pattern->ndeliveries + 1, 
+		sizeof(PatternDelivery));
+	communicator(sent, pattern->send_bytes, pattern->send_offsets,
+		pattern->deliveries, pattern->recv_bytes, pattern->recv_offsets);
+	bsp_free(sent);
+
+	/* sizes of the payloads */
+	for (p = 0; p < nprocs; p++)
+		pattern->send_bytes[p] = pattern->recv_bytes[p] = 0;
+	for (i = 0; i < pattern->nputs; i++)
+		pattern->send_bytes[pattern->puts[i].pid] += (int) pattern->puts[i].nbytes;
+	i = 0;
+	for (p = 0; p < nprocs; p++)
+	{
+		unsigned int end = i + bsp->recv_index[p];
+		for (; i < end; i++)
+			pattern->recv_bytes[p] += (int) pattern->deliveries[i].nbytes;
+	}
+	for (p = 0; p < nprocs; p++)
+	{
+		pattern->send_offsets[p] = p == 0 ? 0 : 
+			pattern->send_offsets[p - 1] + pattern->send_bytes[p - 1];
+		pattern->recv_offsets[p] = p == 0 ? 0 :
+			pattern->recv_offsets[p - 1] + pattern->recv_bytes[p - 1];
+	}
+	total = (size_t) pattern->send_offsets[nprocs - 1] + pattern->send_bytes[nprocs - 1];
+	pattern->sendbuf = (char *) bsp_malloc(total + 1, sizeof(char));
+	total = (size_t) pattern->recv_offsets[nprocs - 1] + pattern->recv_bytes[nprocs - 1];
+	pattern->recvbuf = (char *) bsp_malloc(total + 1, sizeof(char));
+	return pattern;
+}
+
+/** Ends a superstep in which only the puts of a pattern are communicated.
+ * The sources are read again, and copied into the send buffer, which 
+ * \a run transfers to the receive buffers. No metadata is exchanged.
+ * @param bsp The BSPObject to use. 
+ * @param pattern the pattern
+ * @param run starts the transfers of the pattern and waits for them
+ * @see bsp_pattern_sync()
+ */
+void bspx_pattern_sync (BSPObject * bsp, BSPPattern * pattern, void (*run)(void *))
+{
+	const PatternPut * RESTRICT put;
+	const PatternDelivery * RESTRICT delivery;
+	char * RESTRICT buffer;
+	int p;
+
+	for (p = 0; p < bsp->nprocs; p++)
+		if (bsp->request_table.used_slot_count[p] > 0 ||
+			bsp->delivery_table.used_slot_count[p] > (unsigned int) DELIVTABLE_INDEX_SIZE ||
+			bsp->eager.sent[p] > 0)
+			bsp_abort("bsp_pattern_sync: communication which is not part of the "
+				"pattern is pending.\n");
+
+	/* messages of the previous superstep are discarded as in bspx_sync */
+	messageQueue_sync(&bsp->message_queue);
+	requestTable_reset(&bsp->request_received_table);
+	deliveryTable_reset(&bsp->delivery_received_table);
+
+	buffer = pattern->sendbuf;
+	for (put = pattern->puts; put < pattern->puts + pattern->nputs; put++)
+	{
+		memcpy(buffer, put->src, put->nbytes);
+		buffer += put->nbytes;
+	}
+
+	run(pattern->transfers);
+
+	buffer = pattern->recvbuf;
+	for (delivery = pattern->deliveries; 
+		 delivery < pattern->deliveries + pattern->ndeliveries; delivery++)
+	{
+		memcpy(delivery->dst, buffer, delivery->nbytes);
+		buffer += delivery->nbytes;
+	}
+}
+
+/** Frees a pattern. Its transfers must have been freed.
+ * @param pattern the pattern
+ */
+void bspx_pattern_free (BSPPattern * pattern)
+{
+	pattern_free(pattern);
+}
+
+/** Sends columns of the delivery table which hold at least \a nbytes 
+ * bytes during the superstep.
+ * @param bsp The BSPObject to use. 
+ * @param nbytes the threshold, or 0 to send all data at the sync
+ * @param eager the point-to-point communication of the eager channel
+ * @see bsp_set_eager_threshold()
+ */
+void bspx_set_eager_threshold (BSPObject * bsp, size_t nbytes, const BSPX_EagerComm * eager)
+{
+	bsp->eager.threshold = nbytes;
+	bsp->eager.comm = eager;
+}
+
 /** Reset buffer sizes 
   As messages are buffered, the buffers will not be reset to their standard size
   unless this function is called. 
@@ -193,12 +517,39 @@ void bspx_resetbuffers(BSPObject * bsp) {
 	deliveryTable_resetrowcount(&bsp->delivery_table, BSP_DELIVTAB_MIN_SIZE);
 	deliveryTable_resetrowcount(&bsp->delivery_received_table, BSP_DELIVTAB_MIN_SIZE);
 	messageQueue_sync (&bsp->message_queue);
+	combinerTable_reset(&bsp->combiner);
 }
 
 /*@}*/
 
 /** @name DRMA */
 /*@{*/
+
+/** Translates a local address to the address on another processor.
+ * Addresses in the symmetric heap are translated by adding the offset
+ * of the heap, all others are looked up in the memory register.
+ * @param bsp The BSPObject to use. 
+ * @param pid the processor
+ * @param pointer a registered local address, or an address in the 
+ *        symmetric heap
+ * @return the address on processor \a pid
+ */
+static inline char * bspx_remote_address (BSPObject * bsp, int pid, const void * pointer)
+{
+	if (symmetricHeap_contains(&bsp->heap, (const char *) pointer))
+		return symmetricHeap_translate(&bsp->heap, pid, (const char *) pointer);
+	return memoryRegister_memoized_find(&bsp->memory_register, pid, (const char *) pointer);
+}
+
+/** Aborts if a pattern is being recorded, since only puts can be replayed.
+ * @param bsp The BSPObject to use. 
+ * @param name the function which requests communication
+ */
+static inline void bspx_check_not_recording (BSPObject * bsp, const char * name)
+{
+	if (bsp->recording != NULL)
+		bsp_abort("%s: only bsp_put() and bsp_hpput() can be recorded.\n", name);
+}
 /** Makes the memory location with specified size available for DRMA
  * operations at the next and additional supersteps. 
  * @param bsp The BSPObject to use. 
@@ -230,6 +581,153 @@ inline void bspx_pop_reg (BSPObject * bsp, const void *ident)
 	deliveryTable_push(&bsp->delivery_table, bsp->rank, &element, it_popreg);
 }  
 
+/** Allocates a block of the symmetric heap. Must be called on all 
+ * processors with the same size. The heap is reserved, and the addresses
+ * of the heaps on all processors are exchanged using \a infocomm, at the 
+ * first call. The block can be used in DRMA operations immediately and 
+ * needs no registration.
+ * @param bsp The BSPObject to use. 
+ * @param size the size of the block
+ * @param infocomm used to exchange the addresses of the heaps
+ * @return the block
+ * @see bsp_symmetric_alloc()
+ */
+void * bspx_symmetric_alloc (BSPObject * bsp, size_t size, BSPX_CommFn0 infocomm)
+{
+	void * block;
+	if (bsp->heap.base == NULL)
+	{
+		char ** bases;
+		int p;
+		symmetricHeap_reserve(&bsp->heap, MAX(size, BSP_SYMMETRIC_HEAP_SIZE), bsp->nprocs);
+		bases = (char **) bsp_malloc(bsp->nprocs, sizeof(char *));
+		for (p = 0; p < bsp->nprocs; p++)
+			bases[p] = bsp->heap.base;
+		infocomm(bases, sizeof(char *), bsp->heap.bases, sizeof(char *));
+		bsp_free(bases);
+	}
+	block = symmetricHeap_alloc(&bsp->heap, size);
+	if (block == NULL)
+		bsp_abort("bsp_symmetric_alloc: the symmetric heap of %lu bytes is exhausted.\n",
+			(unsigned long) bsp->heap.size);
+	return block;
+}
+
+/** Frees a block of the symmetric heap. Must be called on all processors.
+ * @param bsp The BSPObject to use. 
+ * @param ptr a block allocated with bspx_symmetric_alloc()
+ */
+void bspx_symmetric_free (BSPObject * bsp, void * ptr)
+{
+	if (!symmetricHeap_free(&bsp->heap, ptr))
+		bsp_abort("bsp_symmetric_free: %p was not allocated with bsp_symmetric_alloc.\n", ptr);
+}
+
+/** Dequeue all messages, and start iterating over them in place.
+ *  The messages stay valid until the next sync, or until they are released
+ *  when bspx_messages_keep is called.
+ * @param bsp The BSPObject to use. 
+ * @param it iterator which is set to the first message
+ * @return 1 if there is a message, 0 if the queue is empty
+ */
+int bspx_messages_begin (BSPObject * bsp, bsp_message_t * it)
+{
+	const ExpandableTable * RESTRICT table = &bsp->delivery_received_table;
+	it->next_ = (const char *) bsp->message_queue.head;
+	it->remaining_ = bsp->message_queue.n_mesg;
+	it->base_ = table->data;
+	it->column_bytes_ = (size_t) table->rows * table->slot_size;
+	it->tag_offset_ = sizeof(ALIGNED_TYPE) * 
+		no_slots( sizeof(DelivElement), sizeof(ALIGNED_TYPE));
+	it->payload_offset_ = it->tag_offset_ + bsp->message_queue.recv_tag_size;
+
+	bsp->message_queue.head = NULL;
+	bsp->message_queue.n_mesg = 0;
+	bsp->message_queue.accum_size = 0;
+	return bspx_messages_next (it);
+}
+
+/** Advance to the next message.
+ * @param it the iterator
+ * @return 1 if there is a message, 0 if all messages have been visited
+ */
+int bspx_messages_next (bsp_message_t * it)
+{
+	const DelivElement * RESTRICT message;
+	if (it->remaining_ == 0)
+		return 0;
+
+	message = (const DelivElement *) it->next_;
+	/* messages are stored in the column of their source */
+	it->source = (int) ((it->next_ - it->base_) / it->column_bytes_);
+	it->tag = it->next_ + it->tag_offset_;
+	it->payload = it->next_ + it->payload_offset_;
+	it->nbytes = message->info.send.payload_size;
+	it->next_ += message->next * sizeof(ALIGNED_TYPE);
+	it->remaining_--;
+	return 1;
+}
+
+/** Take ownership of the received messages, so they stay valid after 
+ *  the next sync. 
+ * @param bsp The BSPObject to use. 
+ * @return a block to free using bsp_messages_release
+ */
+void * bspx_messages_keep (BSPObject * bsp)
+{
+	return deliveryTable_detach (&bsp->delivery_received_table);
+}
+
+/** Sends a column of the delivery table, and clears it.
+ * @param bsp The BSPObject to use. 
+ * @param pid the column
+ */
+static void bspx_eager_flush (BSPObject * bsp, int pid)
+{
+	ExpandableTable * RESTRICT table = &bsp->delivery_table;
+	const size_t size = table->used_slot_count[pid] * sizeof(ALIGNED_TYPE);
+	char * chunk = (char *) bsp_malloc(size, sizeof(char));
+	void * request;
+
+	memcpy(chunk, (ALIGNED_TYPE *) table->data + pid * table->rows, size);
+	request = bsp->eager.comm->isend(pid, chunk, (int) size);
+	eagerChannel_append(&bsp->eager.sending, &bsp->eager.nsending, 
+		&bsp->eager.sending_capacity, chunk, request);
+	bsp->eager.sent[pid]++;
+	deliveryTable_reset_column(table, pid);
+}
+
+/** Frees the chunks which have been sent, and stages the chunks which 
+ * have arrived.
+ * @param bsp The BSPObject to use. 
+ */
+static void bspx_eager_poll (BSPObject * bsp)
+{
+	int pid, size;
+	bsp->eager.puts = 0;
+	eagerChannel_complete_sends(&bsp->eager, 0);
+	while ((size = bsp->eager.comm->probe(&pid, 0)) >= 0)
+		eagerChannel_receive(&bsp->eager, pid, size);
+}
+
+/** Called after a put to processor \a pid: sends its column if it has 
+ * reached the threshold of the eager channel, and polls every 
+ * BSP_EAGER_POLL_INTERVAL puts.
+ * @param bsp The BSPObject to use. 
+ * @param pid the destination of the put
+ */
+static inline void bspx_eager_progress (BSPObject * bsp, int pid)
+{
+	if (bsp->eager.threshold == 0)
+		return;
+	if (pid != bsp->rank && 
+		bsp->delivery_table.used_slot_count[pid] * sizeof(ALIGNED_TYPE) >= bsp->eager.threshold &&
+		deliveryTable_only_puts(&bsp->delivery_table, pid))
+		bspx_eager_flush(bsp, pid);
+	if (++bsp->eager.puts >= BSP_EAGER_POLL_INTERVAL)
+		bspx_eager_poll(bsp);
+}
+
 /** Puts a block of data in the memory of some other processor at the next
  * superstep. This function is buffered, i.e.: the contents of \a src
  * is copied to a buffer and transmitted at the next bsp_sync() 
@@ -249,9 +747,12 @@ inline void bspx_put (BSPObject * bsp, int pid, const void *src, void *dst, long
 	DelivElement element;
 	element.size = (unsigned int) nbytes;
 	element.info.put.dst = 
-		memoryRegister_memoized_find(&bsp->memory_register, pid, dst) + offset;
+		bspx_remote_address(bsp, pid, dst) + offset;
 	pointer = deliveryTable_push(&bsp->delivery_table, pid, &element, it_put);
 	memcpy(pointer, src, nbytes);
+	if (bsp->recording != NULL)
+		pattern_record(bsp->recording, pid, src, element.info.put.dst, nbytes);
+	bspx_eager_progress(bsp, pid);
 }
 
 
@@ -272,15 +773,323 @@ inline void bspx_put (BSPObject * bsp, int pid, const void *src, void *dst, long
 inline void bspx_get (BSPObject * bsp, int pid, const void *src, long int offset, void *dst, size_t nbytes)
 {
 	ReqElement elem;
+	bspx_check_not_recording(bsp, "bsp_get");
 	elem.size = (unsigned int )nbytes;
 	elem.src = 
-		memoryRegister_memoized_find(&bsp->memory_register, pid, src);
+		bspx_remote_address(bsp, pid, src);
 	elem.dst = dst;
 	elem.offset = offset;
+	elem.count = 1;
+	elem.info.strided.src_stride = 0;
+	elem.info.strided.dst_stride = 0;
 
 	/* place get command in buffer */
 	requestTable_push(&bsp->request_table, pid, &elem);
 }
+
+/** Puts \a count blocks of \a nbytes each, which are \a src_stride bytes 
+ * apart at the source and \a dst_stride bytes apart at the destination. 
+ * All blocks are transmitted as a single delivery. This function is 
+ * buffered like bspx_put().
+ * @param bsp The BSPObject to use. 
+ * @param pid rank of destination (remote) processor
+ * @param src pointer to the first source block
+ * @param src_stride distance between source blocks in bytes
+ * @param dst pointer to the registered destination area
+ * @param offset offset of the first block from \a dst in bytes
+ * @param dst_stride distance between destination blocks in bytes
+ * @param nbytes size of each block
+ * @param count number of blocks
+ */
+inline void bspx_put_strided (BSPObject * bsp, int pid, const void *src, long int src_stride, 
+	void *dst, long int offset, long int dst_stride, size_t nbytes, int count)
+{
+	bspx_check_not_recording(bsp, "bsp_put_strided");
+	if (count <= 0 || nbytes == 0)
+		return;
+	deliveryTable_push_strided(&bsp->delivery_table, pid, 
+		bspx_remote_address(bsp, pid, dst) + offset, 
+		(const char *) src, src_stride, dst_stride, nbytes, (unsigned int) count);
+	bspx_eager_progress(bsp, pid);
+}
+
+/** Gets \a count blocks of \a nbytes each, which are \a src_stride bytes
+ * apart at the source and \a dst_stride bytes apart at the destination.
+ * The blocks are requested and returned as a single item. This function 
+ * is buffered like bspx_get().
+ * @param bsp The BSPObject to use. 
+ * @param pid Rank of the source (remote) processor 
+ * @param src pointer to the registered source area
+ * @param offset offset of the first block from \a src in bytes
+ * @param src_stride distance between source blocks in bytes
+ * @param dst pointer to the first destination block
+ * @param dst_stride distance between destination blocks in bytes
+ * @param nbytes size of each block
+ * @param count number of blocks
+ */
+inline void bspx_get_strided (BSPObject * bsp, int pid, const void *src, long int offset, 
+	long int src_stride, void *dst, long int dst_stride, size_t nbytes, int count)
+{
+	ReqElement elem;
+	bspx_check_not_recording(bsp, "bsp_get_strided");
+	if (count <= 0 || nbytes == 0)
+		return;
+	elem.size = (unsigned int )nbytes;
+	elem.src = 
+		bspx_remote_address(bsp, pid, src);
+	elem.dst = dst;
+	elem.offset = offset;
+	elem.count = (unsigned int) count;
+	elem.info.strided.src_stride = src_stride;
+	elem.info.strided.dst_stride = dst_stride;
+	requestTable_push(&bsp->request_table, pid, &elem);
+}
+
+/** Puts \a count blocks of different sizes. Block k is read from 
+ * \a src + blocks[k].src_offset and written to \a dst + blocks[k].dst_offset.
+ * All blocks are transmitted as a single delivery. This function is 
+ * buffered like bspx_put().
+ * @param bsp The BSPObject to use. 
+ * @param pid rank of destination (remote) processor
+ * @param src source pointer
+ * @param dst pointer to the registered destination area
+ * @param blocks the blocks
+ * @param count number of blocks
+ */
+inline void bspx_put_indexed (BSPObject * bsp, int pid, const void *src, void *dst, 
+	const bsp_block_t * blocks, int count)
+{
+	bspx_check_not_recording(bsp, "bsp_put_indexed");
+	if (count <= 0)
+		return;
+	deliveryTable_push_indexed(&bsp->delivery_table, pid, 
+		bspx_remote_address(bsp, pid, dst), 
+		(const char *) src, blocks, (unsigned int) count);
+	bspx_eager_progress(bsp, pid);
+}
+
+/** Gets \a count blocks of different sizes. Block k is read from 
+ * \a src + blocks[k].src_offset and written to \a dst + blocks[k].dst_offset.
+ * Request table entries have a fixed size, so every block is requested 
+ * separately.
+ * @param bsp The BSPObject to use. 
+ * @param pid Rank of the source (remote) processor 
+ * @param src pointer to the registered source area
+ * @param dst destination pointer
+ * @param blocks the blocks
+ * @param count number of blocks
+ */
+inline void bspx_get_indexed (BSPObject * bsp, int pid, const void *src, void *dst, 
+	const bsp_block_t * blocks, int count)
+{
+	int k;
+	bspx_check_not_recording(bsp, "bsp_get_indexed");
+	for (k = 0; k < count; k++)
+		bspx_get(bsp, pid, src, blocks[k].src_offset, 
+			(char *) dst + blocks[k].dst_offset, blocks[k].nbytes);
+}
+
+/** Puts data which is combined with the destination at the next superstep,
+ * e.g. added to it. This function is buffered like bspx_put(). Accumulating 
+ * puts are executed after all other puts of the same superstep, in the 
+ * order of the source processors.
+ * @param bsp The BSPObject to use. 
+ * @param pid rank of destination (remote) processor
+ * @param src pointer to the source data
+ * @param dst pointer to the registered destination area
+ * @param offset offset from \a dst in bytes 
+ * @param nbytes number of bytes (a multiple of the element size)
+ * @param op the operation
+ * @param type the element type
+ */
+inline void bspx_put_accumulate (BSPObject * bsp, int pid, const void *src, void *dst, 
+	long int offset, size_t nbytes, bsp_op_t op, bsp_type_t type)
+{
+	bspx_check_not_recording(bsp, "bsp_put_accumulate");
+	if (!accumulate_valid(op, type))
+		bsp_intern_abort (ERR_INVALID_OPERATION, __func__, __FILE__, __LINE__);
+	if (nbytes % accumulate_type_size(type) != 0)
+		bsp_abort("bsp_put_accumulate: %lu bytes are not a whole number of elements.\n",
+			(unsigned long) nbytes);
+	deliveryTable_push_accumulate(&bsp->delivery_table, pid, 
+		bspx_remote_address(bsp, pid, dst) + offset, 
+		src, nbytes, op, type);
+}
+
+/** Combines an operand with one element of a registered area on a remote 
+ * processor, and returns the previous value of the element at the next 
+ * superstep. The request is executed by the remote processor when it 
+ * executes gets: requests from one processor in the order they were 
+ * issued, requests from different processors in the order of their pids.
+ * @param bsp The BSPObject to use. 
+ * @param pid rank of the remote processor
+ * @param src pointer to the registered area
+ * @param offset offset of the element from \a src in bytes
+ * @param operand the operand (one element)
+ * @param result where to store the previous value (one element)
+ * @param op the operation
+ * @param type the element type
+ */
+inline void bspx_fetch_op (BSPObject * bsp, int pid, const void *src, long int offset, 
+	const void *operand, void *result, bsp_op_t op, bsp_type_t type)
+{
+	bspx_check_not_recording(bsp, "bsp_fetch_op");
+	if (!accumulate_valid(op, type))
+		bsp_intern_abort (ERR_INVALID_OPERATION, __func__, __FILE__, __LINE__);
+	requestTable_push_atomic(&bsp->request_table, pid, 
+		bspx_remote_address(bsp, pid, src), offset, 
+		result, operand, NULL, accumulate_type_size(type), op, type);
+}
+
+/** Compare-and-swap on one element of a registered area on a remote 
+ * processor: the element is replaced by \a value if it is bitwise equal to
+ * \a compare. The previous value is returned at the next superstep. 
+ * Requests are executed like those of bspx_fetch_op().
+ * @param bsp The BSPObject to use. 
+ * @param pid rank of the remote processor
+ * @param src pointer to the registered area
+ * @param offset offset of the element from \a src in bytes
+ * @param compare the expected value (one element)
+ * @param value the new value (one element)
+ * @param result where to store the previous value (one element)
+ * @param type the element type
+ */
+inline void bspx_cas (BSPObject * bsp, int pid, const void *src, long int offset, 
+	const void *compare, const void *value, void *result, bsp_type_t type)
+{
+	size_t nbytes = accumulate_type_size(type);
+	bspx_check_not_recording(bsp, "bsp_cas");
+	if (nbytes == 0)
+		bsp_intern_abort (ERR_INVALID_OPERATION, __func__, __FILE__, __LINE__);
+	requestTable_push_atomic(&bsp->request_table, pid, 
+		bspx_remote_address(bsp, pid, src), offset, 
+		result, value, compare, nbytes, BSP_OP_CAS, type);
+}
+
+/** Puts \a count values of \a nbytes each into one registered area. Value k
+ * is written to \a dst + offsets[k] on processor pids[k]. The values are 
+ * sorted by destination (counting sort), space for all of them is reserved 
+ * in one step, and every destination receives them as a single delivery.
+ * This function is buffered like bspx_put().
+ * @param bsp The BSPObject to use. 
+ * @param dst pointer to the registered destination area
+ * @param pids destination processor of every value
+ * @param offsets offset from \a dst in bytes for every value
+ * @param values the values (\a count * \a nbytes bytes)
+ * @param nbytes size of each value
+ * @param count number of values
+ */
+void bspx_put_batch (BSPObject * bsp, void *dst, const int * pids, const long int * offsets, 
+	const void * values, size_t nbytes, int count)
+{
+	unsigned int * RESTRICT counts, * RESTRICT slots;
+	long ** RESTRICT offset_ptr;
+	char ** RESTRICT value_ptr;
+	const MemRegElement * row;
+	unsigned int stride = bsp->memory_register.rows;
+	ptrdiff_t delta = 0;
+	const char * RESTRICT v = (const char *) values;
+	int k, p;
+
+	bspx_check_not_recording(bsp, "bsp_put_batch");
+	if (count <= 0 || nbytes == 0)
+		return;
+
+	counts = (unsigned int *) bsp_calloc(2 * bsp->nprocs, sizeof(unsigned int));
+	slots = counts + bsp->nprocs;
+	offset_ptr = (long **) bsp_malloc(bsp->nprocs, sizeof(long *));
+	value_ptr = (char **) bsp_malloc(bsp->nprocs, sizeof(char *));
+
+	for (k = 0; k < count; k++)
+		counts[pids[k]]++;
+	for (p = 0; p < bsp->nprocs; p++)
+		if (counts[p] > 0)
+			slots[p] = deliveryTable_putbatch_slots(counts[p], nbytes);
+	deliveryTable_reserve(&bsp->delivery_table, slots);
+
+	/* translate the destination once per processor */
+	if (symmetricHeap_contains(&bsp->heap, (const char *) dst))
+	{
+		row = bsp->heap.bases;
+		stride = 1;
+		delta = (const char *) dst - bsp->heap.base;
+	}
+	else
+		row = memoryRegister_memoized_row(&bsp->memory_register, (const char *) dst);
+	for (p = 0; p < bsp->nprocs; p++)
+	{
+		if (counts[p] == 0)
+			continue;
+		offset_ptr[p] = deliveryTable_push_putbatch(&bsp->delivery_table, p, 
+			row[stride * p] + delta, counts[p], nbytes);
+		value_ptr[p] = (char *) (offset_ptr[p] + counts[p]);
+	}
+
+	for (k = 0; k < count; k++, v += nbytes)
+	{
+		p = pids[k];
+		*(offset_ptr[p]++) = offsets[k];
+		memcpy(value_ptr[p], v, nbytes);
+		value_ptr[p] += nbytes;
+	}
+
+	bsp_free(value_ptr);
+	bsp_free(offset_ptr);
+	bsp_free(counts);
+}
+
+/** Gets \a count values of \a nbytes each from one registered area. Value k
+ * is read from \a src + offsets[k] on processor pids[k]. Space for all 
+ * requests is reserved in one step, and the address is translated once per 
+ * processor. This function is buffered like bspx_get().
+ * @param bsp The BSPObject to use. 
+ * @param src pointer to the registered source area
+ * @param pids source processor of every value
+ * @param offsets offset from \a src in bytes for every value
+ * @param values destination of the values (\a count * \a nbytes bytes)
+ * @param nbytes size of each value
+ * @param count number of values
+ */
+void bspx_get_batch (BSPObject * bsp, const void *src, const int * pids, const long int * offsets, 
+	void * values, size_t nbytes, int count)
+{
+	unsigned int * RESTRICT counts;
+	const MemRegElement * row;
+	unsigned int stride = bsp->memory_register.rows;
+	ptrdiff_t delta = 0;
+	ReqElement elem;
+	int k;
+
+	bspx_check_not_recording(bsp, "bsp_get_batch");
+	if (count <= 0 || nbytes == 0)
+		return;
+
+	counts = (unsigned int *) bsp_calloc(bsp->nprocs, sizeof(unsigned int));
+	for (k = 0; k < count; k++)
+		counts[pids[k]]++;
+	requestTable_reserve(&bsp->request_table, counts);
+	bsp_free(counts);
+
+	if (symmetricHeap_contains(&bsp->heap, (const char *) src))
+	{
+		row = bsp->heap.bases;
+		stride = 1;
+		delta = (const char *) src - bsp->heap.base;
+	}
+	else
+		row = memoryRegister_memoized_row(&bsp->memory_register, (const char *) src);
+	elem.size = (unsigned int) nbytes;
+	elem.count = 1;
+	elem.info.strided.src_stride = 0;
+	elem.info.strided.dst_stride = 0;
+	elem.dst = (char *) values;
+	for (k = 0; k < count; k++, elem.dst += nbytes)
+	{
+		elem.src = row[stride * pids[k]] + delta;
+		elem.offset = offsets[k];
+		requestTable_push_reserved(&bsp->request_table, pids[k], &elem);
+	}
+}
 /*@}*/
 
 /** @name BSMP */
@@ -299,11 +1108,52 @@ inline void bspx_send (BSPObject * bsp, int pid, const void *tag, const void *pa
 {
 	DelivElement element;
 	char * RESTRICT pointer;
+	ExpandableTable * RESTRICT table = &bsp->delivery_table;
+	long key = -1;
+	size_t location;
+
+	bspx_check_not_recording(bsp, "bsp_send");
+	if (bsp->combiner.combine != NULL)
+	{
+		key = bsp->combiner.key(tag, payload, payload_nbytes);
+		if (key >= 0 && 
+			combinerTable_find(&bsp->combiner, pid, key, payload_nbytes, &location))
+		{
+			/* combine into the payload of the buffered message */
+			pointer = table->data + (pid * table->rows + location) * sizeof(ALIGNED_TYPE);
+			bsp->combiner.combine(pointer + bsp->message_queue.send_tag_size, payload, payload_nbytes);
+			bsp->combiner.combined++;
+			return;
+		}
+	}
+
 	element.size = (unsigned int )payload_nbytes + bsp->message_queue.send_tag_size;
 	element.info.send.payload_size = (unsigned int )payload_nbytes;
-	pointer = deliveryTable_push(&bsp->delivery_table, pid, &element, it_send);
+	pointer = deliveryTable_push(table, pid, &element, it_send);
 	memcpy( pointer, tag, bsp->message_queue.send_tag_size);
 	memcpy( pointer + bsp->message_queue.send_tag_size, payload, payload_nbytes);
+
+	if (key >= 0)
+	{
+		/* remember the slot offset in the column, the table may be 
+		   reallocated by later sends */
+		location = (pointer - table->data) / sizeof(ALIGNED_TYPE) - pid * table->rows;
+		combinerTable_insert(&bsp->combiner, pid, key, location, payload_nbytes);
+	}
+}
+
+/** Set the combiner for messages sent by this processor. This takes 
+ * effect immediately, and messages which have been sent in the current
+ * superstep before are not combined with later ones.
+ @param bsp The BSPObject to use. 
+ @param key key extractor, or NULL to switch combining off
+ @param combine associative combine function
+ */
+void bspx_set_combiner (BSPObject * bsp, bsp_combiner_key_fn key, bsp_combiner_fn combine)
+{
+	combinerTable_reset(&bsp->combiner);
+	bsp->combiner.key = key;
+	bsp->combiner.combine = key != NULL ? combine : NULL;
 }
 
 /** Gives the number of messages and the sum of the payload sizes in queue.
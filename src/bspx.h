@@ -57,8 +57,15 @@ extern "C" {
 
 	/** @name Superstep */
 	/*@{*/
-	void bspx_sync (BSPObject *, BSPX_CommFn0,  BSPX_CommFn);
+	void bspx_sync (BSPObject *, BSPX_CommFn0,  BSPX_CommFn, const BSPX_EagerComm *, int);
 	void bspx_resetbuffers(BSPObject *);
+	void bspx_set_eager_threshold (BSPObject *, size_t, const BSPX_EagerComm *);
+	void bspx_set_neighbours (BSPObject *, const int *, int, BSPX_CommFn0);
+	int bspx_sync_neighbourhood (BSPObject *);
+	void bspx_pattern_begin (BSPObject *);
+	BSPPattern * bspx_pattern_end (BSPObject *, BSPX_CommFn0, BSPX_CommFn);
+	void bspx_pattern_sync (BSPObject *, BSPPattern *, void (*)(void *));
+	void bspx_pattern_free (BSPPattern *);
 	/*@}*/
 	
 
@@ -68,6 +75,17 @@ extern "C" {
 	void bspx_pop_reg (BSPObject *, const void *);
 	void bspx_put (BSPObject *, int, const void *, void *, long int, size_t);
 	void bspx_get (BSPObject *, int, const void *, long int, void *, size_t);
+	void bspx_put_strided (BSPObject *, int, const void *, long int, void *, long int, long int, size_t, int);
+	void bspx_get_strided (BSPObject *, int, const void *, long int, long int, void *, long int, size_t, int);
+	void bspx_put_indexed (BSPObject *, int, const void *, void *, const bsp_block_t *, int);
+	void bspx_get_indexed (BSPObject *, int, const void *, void *, const bsp_block_t *, int);
+	void bspx_put_batch (BSPObject *, void *, const int *, const long int *, const void *, size_t, int);
+	void bspx_get_batch (BSPObject *, const void *, const int *, const long int *, void *, size_t, int);
+	void bspx_put_accumulate (BSPObject *, int, const void *, void *, long int, size_t, bsp_op_t, bsp_type_t);
+	void bspx_fetch_op (BSPObject *, int, const void *, long int, const void *, void *, bsp_op_t, bsp_type_t);
+	void bspx_cas (BSPObject *, int, const void *, long int, const void *, const void *, void *, bsp_type_t);
+	void * bspx_symmetric_alloc (BSPObject *, size_t, BSPX_CommFn0);
+	void bspx_symmetric_free (BSPObject *, void *);
 	/*@}*/
 
 	/** @name BSMP */
@@ -77,6 +95,7 @@ extern "C" {
 	void bspx_get_tag (BSPObject *, int * RESTRICT , void * RESTRICT );
 	void bspx_move (BSPObject *, void *, size_t);
 	void bspx_set_tagsize (BSPObject *, size_t *);
+	void bspx_set_combiner (BSPObject *, bsp_combiner_key_fn, bsp_combiner_fn);
 	/*@}*/
 
 	/** @name High Performance */
@@ -86,15 +105,30 @@ extern "C" {
 	int bspx_hpmove (BSPObject *, void **, void **);
 	/*@}*/
 
+	/** @name Bulk message access */
+	/*@{*/
+	int bspx_messages_begin (BSPObject *, bsp_message_t *);
+	int bspx_messages_next (bsp_message_t *);
+	void * bspx_messages_keep (BSPObject *);
+	/*@}*/
+
 	/** @section Global (BSPRAM) DRMA */
 	/*@{*/
 
 	bsp_global_handle_t BSP_CALLING bspx_global_alloc(BSPObject *, size_t array_size);
+	bsp_global_handle_t BSP_CALLING bspx_global_alloc_dist(BSPObject *, size_t array_size, bsp_dist_t dist, size_t block_size, bsp_global_owner_fn owner);
+	int BSP_CALLING bspx_global_owner(BSPObject *, bsp_global_handle_t handle, size_t offset);
 	void BSP_CALLING bspx_global_free(BSPObject *, bsp_global_handle_t ptr);
 	void BSP_CALLING bspx_global_get(BSPObject *, bsp_global_handle_t src, size_t offset, void * dest, size_t size);
 	void BSP_CALLING bspx_global_put(BSPObject *, const void * src, bsp_global_handle_t dest, size_t offset, size_t size);
 	void BSP_CALLING bspx_global_hpget(BSPObject *, bsp_global_handle_t src, size_t offset, void * dest, size_t size);
 	void BSP_CALLING bspx_global_hpput(BSPObject *, const void * src, bsp_global_handle_t dest, size_t offset, size_t size);
+	void BSP_CALLING bspx_global_put_accumulate(BSPObject *, const void * src, bsp_global_handle_t dest, size_t offset, size_t size, bsp_op_t op, bsp_type_t type);
+	void BSP_CALLING bspx_global_gather(BSPObject *, bsp_global_handle_t src, const size_t * indices, size_t n, void * dest, size_t nbytes);
+	void BSP_CALLING bspx_global_scatter(BSPObject *, const void * src, bsp_global_handle_t dest, const size_t * indices, size_t n, size_t nbytes);
+	void BSP_CALLING bspx_global_cache(BSPObject *, bsp_global_handle_t handle, size_t line_size);
+	void BSP_CALLING bspx_global_cache_stats(BSPObject *, bsp_global_handle_t handle, bsp_global_cache_stats_t * stats);
+	void bspx_global_flush(BSPObject *);
 	/*@}*/
 
 #ifdef __cplusplus
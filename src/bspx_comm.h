@@ -35,5 +35,22 @@ typedef void (*BSPX_CommFn0) (void * , int, void * , int );
 typedef void (*BSPX_CommFn) (void * sendbuf, int * sendcounts, int * sendoffsets,
 	void * recvbuf, int * recvcounts, int * recvoffsets );
 
+/** Wrappers for the non-blocking point-to-point transfers which flush 
+    columns of the delivery table during a superstep, see 
+    bsp_set_eager_threshold() */
+typedef struct {
+	/** start sending \a size bytes to \a pid, returns a request */
+	void * (*isend) (int pid, void * buf, int size);
+	/** test (or wait, if \a wait is nonzero) for the completion of a 
+	    request, which is freed when it has completed */
+	int (*complete) (void * request, int wait);
+	/** size of the next incoming chunk, or -1 if there is none. Waits for
+	    a chunk from *pid if \a wait is nonzero, otherwise *pid is set to 
+	    the source of the chunk. */
+	int (*probe) (int * pid, int wait);
+	/** receive the chunk found by probe */
+	void (*recv) (int pid, void * buf, int size);
+} BSPX_EagerComm;
+
 
 #endif // __bspx_comm_H__
@@ -46,4 +46,45 @@ void BSP_MPI_ALLTOALL_COMM (void * sendbuf, int  sendcount, void * recvbuf, int
 void BSP_MPI_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets,
 	void * recvbuf, int * recvcounts, int * recvoffsets );
 
+/** MPI_Comm_split wrapper, creates the communicator of a team */
+void * BSP_MPI_TEAM_SPLIT (int color, int key, int * nprocs, int * rank);
+
+/** Exchange bsp_communicator and the communicator of a team */
+void BSP_MPI_TEAM_SWAP (void * comm);
+
+/** MPI_Comm_free wrapper */
+void BSP_MPI_TEAM_FREE (void * comm);
+
+/** MPI_Dist_graph_create_adjacent wrapper, creates a neighbourhood */
+void * BSP_MPI_NEIGHBOURHOOD_CREATE (const int * pids, int n, int nprocs, int rank);
+
+/** Free a neighbourhood */
+void BSP_MPI_NEIGHBOURHOOD_FREE (void * neighbourhood);
+
+/** Select the neighbourhood used by the neighbourhood communication routines */
+void BSP_MPI_NEIGHBOURHOOD_SELECT (void * neighbourhood);
+
+/** MPI_Neighbor_alltoall wrapper */
+void BSP_MPI_NEIGHBOUR_ALLTOALL_COMM (void * sendbuf, int  sendcount, void * recvbuf, int  recvcount);
+
+/** MPI_Neighbor_alltoallv wrapper */
+void BSP_MPI_NEIGHBOUR_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets );
+
+/** MPI_Send_init / MPI_Recv_init wrapper, creates the transfers of a pattern */
+void * BSP_MPI_PATTERN_CREATE (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets );
+
+/** MPI_Startall / MPI_Waitall wrapper */
+void BSP_MPI_PATTERN_RUN (void * transfers);
+
+/** Free the transfers of a pattern */
+void BSP_MPI_PATTERN_FREE (void * transfers);
+
+/** MPI_Isend / MPI_Test / MPI_Probe / MPI_Recv wrappers for the eager channel */
+void * BSP_MPI_EAGER_ISEND (int pid, void * buf, int size);
+int BSP_MPI_EAGER_COMPLETE (void * request, int wait);
+int BSP_MPI_EAGER_PROBE (int * pid, int wait);
+void BSP_MPI_EAGER_RECV (int pid, void * buf, int size);
+
 #endif // __bsp_mpi_comm_H__
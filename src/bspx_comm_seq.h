@@ -42,5 +42,26 @@ void BSP_SEQ_ALLTOALL_COMM (void * sendbuf, int  sendcount, void * recvbuf, int
 void BSP_SEQ_ALLTOALLV_COMM (void * sendbuf, int * sendcounts, int * sendoffsets,
 	void * recvbuf, int * recvcounts, int * recvoffsets );
 
+/** team creation wrappers */
+void * BSP_SEQ_TEAM_SPLIT (int color, int key, int * nprocs, int * rank);
+void BSP_SEQ_TEAM_SWAP (void * comm);
+void BSP_SEQ_TEAM_FREE (void * comm);
+
+/** neighbourhood wrappers */
+void * BSP_SEQ_NEIGHBOURHOOD_CREATE (const int * pids, int n, int nprocs, int rank);
+void BSP_SEQ_NEIGHBOURHOOD_FREE (void * neighbourhood);
+void BSP_SEQ_NEIGHBOURHOOD_SELECT (void * neighbourhood);
+
+/** pattern wrappers */
+void * BSP_SEQ_PATTERN_CREATE (void * sendbuf, int * sendcounts, int * sendoffsets,
+	void * recvbuf, int * recvcounts, int * recvoffsets );
+void BSP_SEQ_PATTERN_RUN (void * transfers);
+void BSP_SEQ_PATTERN_FREE (void * transfers);
+
+/** eager channel wrappers */
+void * BSP_SEQ_EAGER_ISEND (int pid, void * buf, int size);
+int BSP_SEQ_EAGER_COMPLETE (void * request, int wait);
+int BSP_SEQ_EAGER_PROBE (int * pid, int wait);
+void BSP_SEQ_EAGER_RECV (int pid, void * buf, int size);
 
 #endif // __bspx_comm_seq_H__
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bsp_test_coroutine.cpp
+
+Test coroutine-based supersteps.
+
+@author Peter Krusche
+*/
+
+#include <iostream>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "unittest.h"
+
+#ifdef __BSP_COROUTINE_H__
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+class TestCoroutine : public bsp::CoroutineContext {
+public:
+	bsp::Coroutine process () {
+		int right = (bsp_pid() + 1) % bsp_nprocs();
+		int value = bsp_pid();
+
+		bsp_push_reg(&token, sizeof(int));
+		co_await bsp_sync();
+
+		// pass a token around the ring, keeping state in
+		// coroutine-local variables
+		for (int step = 0; step < bsp_nprocs(); ++step) {
+			bsp_put(right, &value, &token, 0, sizeof(int));
+			co_await bsp_sync();
+			value = token;
+		}
+
+		CHECK_EQUAL(bsp_pid(), value);
+
+		int messages = 0;
+		size_t bytes = 0;
+		bsp_send(right, NULL, &value, sizeof(int));
+		co_await bsp_sync();
+
+		bsp_qsize(&messages, &bytes);
+		CHECK_EQUAL(1, messages);
+		int v = -1;
+		bsp_move(&v, sizeof(int));
+		CHECK_EQUAL((bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs(), v);
+
+		bsp_pop_reg(&token);
+		co_await bsp_sync();
+	}
+
+	int token;
+};
+
+/** virtual processor 0 fails, or runs more supersteps than the others */
+class TestCoroutineFailure : public bsp::CoroutineContext {
+public:
+	bsp::Coroutine process () {
+		co_await bsp_sync();
+		if (bsp_pid() == 0 && extra_steps == 0) {
+			throw std::runtime_error("virtual processor 0 failed.");
+		}
+		for (int step = 0; step < (bsp_pid() == 0 ? extra_steps : 0); ++step) {
+			co_await bsp_sync();
+		}
+	}
+
+	static int extra_steps;
+};
+
+int TestCoroutineFailure::extra_steps = 0;
+
+/** run a failing computation, and check that all nodes throw */
+static void test_failure (int procs, int extra_steps) {
+	bool caught = false;
+	TestCoroutineFailure::extra_steps = extra_steps;
+	try {
+		bsp::Runner<TestCoroutineFailure> (procs).run( );
+	} catch (std::runtime_error const &) {
+		caught = true;
+	}
+	CHECK(caught);
+}
+
+#define HAVE_COROUTINE_TEST
+#endif
+#endif
+
+int main (int argc, char** argv) {
+	using namespace std;
+	bsp_init (&argc, &argv);
+
+#ifdef HAVE_COROUTINE_TEST
+	try {
+		for (int procs = 1; procs <= 9; ++procs) {
+			cout << "Testing coroutines p = " << procs << endl;
+			bsp::Runner<TestCoroutine> (procs).run( );
+			bsp_sync();
+		}
+
+		// all nodes throw when a virtual processor fails on one of them
+		cout << "Testing coroutine failures" << endl;
+		test_failure (bsp_nprocs(), 0);
+		test_failure (2 * bsp_nprocs(), 0);
+		if (bsp_nprocs() > 1) {
+			test_failure (bsp_nprocs(), 3);
+		}
+		bsp::Runner<TestCoroutine> (bsp_nprocs()).run( );
+		bsp_sync();
+	} catch (std::runtime_error e) {
+		string s = string ("BSP Application runtime error: ") + e.what() + "\n";
+		bsp_abort(s.c_str());
+	}
+#else
+	cout << "Coroutines are not supported by this compiler, skipping test." << endl;
+#endif
+
+	bsp_end();
+}
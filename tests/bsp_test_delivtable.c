@@ -35,8 +35,7 @@ main(int argc, char *argv[])
   DelivElement sendobj, pushobj, popobj, settagobj, putobj;
   int a = 0, b = 10, i, *t;
   unsigned int k;
-  const int index_size = 
-    no_slots(3 * 6 * sizeof(unsigned int), sizeof(ALIGNED_TYPE));
+  const int index_size = DELIVTABLE_INDEX_SIZE;
 
  
   messageQueue_initialize(&mesgq);
@@ -109,7 +108,7 @@ main(int argc, char *argv[])
   assert(deliv.info.deliv.count[0][it_settag] == 1);
   assert(deliv.info.deliv.end[0][it_settag] == k);
 
-  deliveryTable_execute(&deliv, &memreg, &mesgq, 0);
+  deliveryTable_execute(&deliv, &memreg, &mesgq, 0, NULL, NULL);
 
   assert(a == 10);
   assert(b == 10);
@@ -94,9 +94,160 @@ void an_all_to_all()
 	bsp_free(array2);
 }
 
+void a_strided_transpose()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	int * a = (int *) bsp_malloc(P * P + 1, sizeof(int));
+	int * t = (int *) bsp_malloc(P * P, sizeof(int));
+	int * v = (int *) bsp_malloc(P * 3, sizeof(int));
+	bsp_block_t blocks[2];
+	int i, k;
+
+	for (i = 0; i < P * P + 1; i++)
+		a[i] = s * P * P + i;
+	bsp_push_reg(a, (P * P + 1) * sizeof(int));
+	bsp_sync();
+
+	blocks[0].src_offset = 0;
+	blocks[0].nbytes = sizeof(int);
+	blocks[1].src_offset = P * sizeof(int);
+	blocks[1].nbytes = sizeof(int);
+	for (i = 0; i < P; i++)
+	{
+		/* column s of a on processor i to row i of t */
+		bsp_get_strided(i, a, s * sizeof(int), P * sizeof(int), 
+			t + i * P, sizeof(int), sizeof(int), P);
+		blocks[0].dst_offset = 3 * i * sizeof(int);
+		blocks[1].dst_offset = (3 * i + 1) * sizeof(int);
+		bsp_get_indexed(i, a, v, blocks, 2);
+	}
+	bsp_sync();
+
+	for (i = 0; i < P; i++)
+	{
+		for (k = 0; k < P; k++)
+			assert(t[i * P + k] == i * P * P + k * P + s);
+		assert(v[3 * i] == i * P * P);
+		assert(v[3 * i + 1] == i * P * P + P);
+	}
+
+	bsp_pop_reg(a);
+	bsp_sync();
+	bsp_free(a);
+	bsp_free(t);
+	bsp_free(v);
+}
+
+void a_batch()
+{
+	const int P = bsp_nprocs(), s = bsp_pid(), N = 100;
+	int * table = (int *) bsp_malloc(N, sizeof(int));
+	int * values = (int *) bsp_malloc(N, sizeof(int));
+	int * pids = (int *) bsp_malloc(N, sizeof(int));
+	long * offsets = (long *) bsp_malloc(N, sizeof(long));
+	int k;
+
+	for (k = 0; k < N; k++)
+		table[k] = s * N + k;
+	bsp_push_reg(table, N * sizeof(int));
+	bsp_sync();
+
+	/* value k is read from processor (s + k) % P, entry N - 1 - k */
+	for (k = 0; k < N; k++)
+	{
+		pids[k] = (s + k) % P;
+		offsets[k] = (N - 1 - k) * sizeof(int);
+	}
+	bsp_get_batch(table, pids, offsets, values, sizeof(int), N);
+	bsp_sync();
+
+	for (k = 0; k < N; k++)
+		assert(values[k] == ((s + k) % P) * N + N - 1 - k);
+
+	bsp_pop_reg(table);
+	bsp_sync();
+	bsp_free(table);
+	bsp_free(values);
+	bsp_free(pids);
+	bsp_free(offsets);
+}
+
+void a_fetch_op()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	long counter = 100;
+	int owner = -1;
+	double low = 1e10;
+	long one = 1, before[2] = { -1, -1 };
+	int me = s, nobody = -1, previous = -2;
+	double mine = s, lowest = -1.0;
+
+	bsp_push_reg(&counter, sizeof(long));
+	bsp_push_reg(&owner, sizeof(int));
+	bsp_push_reg(&low, sizeof(double));
+	bsp_sync();
+
+	/* requests are executed in pid order, so processor s sees the 
+	   counter after s increments, and only processor 0 claims */
+	bsp_fetch_op(0, &counter, 0, &one, &before[0], bsp_op_sum, bsp_type_long);
+	bsp_fetch_op(0, &counter, 0, &one, &before[1], bsp_op_sum, bsp_type_long);
+	bsp_cas(P - 1, &owner, 0, &nobody, &me, &previous, bsp_type_int);
+	bsp_fetch_op(P - 1, &low, 0, &mine, &lowest, bsp_op_min, bsp_type_double);
+	bsp_sync();
+
+	assert(before[0] == 100 + 2 * s);
+	assert(before[1] == 100 + 2 * s + 1);
+	assert(previous == (s == 0 ? -1 : 0));
+	assert(lowest == (s == 0 ? 1e10 : 0.0));
+	if (s == 0)
+		assert(counter == 100 + 2 * P);
+	if (s == P - 1)
+	{
+		assert(owner == 0);
+		assert(low == 0.0);
+	}
+
+	bsp_pop_reg(&low);
+	bsp_pop_reg(&owner);
+	bsp_pop_reg(&counter);
+	bsp_sync();
+}
+
+void a_get_before_fetch_op()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	long word = 7, one = 1, before = -1, seen = -1;
+
+	bsp_push_reg(&word, sizeof(long));
+	bsp_sync();
+
+	/* gets see the word before the atomics of the superstep, even when 
+	   a processor with a lower pid updates it */
+	if (s == 0)
+		bsp_fetch_op(P - 1, &word, 0, &one, &before, bsp_op_sum, bsp_type_long);
+	if (s == P - 1)
+		bsp_get(P - 1, &word, 0, &seen, sizeof(long));
+	bsp_sync();
+
+	if (s == 0)
+		assert(before == 7);
+	if (s == P - 1)
+	{
+		assert(seen == 7);
+		assert(word == 8);
+	}
+
+	bsp_pop_reg(&word);
+	bsp_sync();
+}
+
 void bsp_test_get(void) {
 	a_simple_summation();
 	an_all_to_all();
+	a_strided_transpose();
+	a_batch();
+	a_fetch_op();
+	a_get_before_fetch_op();
 }
 
 
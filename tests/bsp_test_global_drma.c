@@ -63,8 +63,271 @@ void test_drma() {
     bsp_global_free ( h );
 }
 
+void test_accumulate() {
+    int * counts = bsp_malloc ( bsp_nprocs() * 2, sizeof ( int ) );
+    int ones[2] = { 1, 1 };
+    int k;
+
+    bsp_global_handle_t h = bsp_global_alloc ( sizeof ( int ) * bsp_nprocs() * 2 );
+    bsp_sync();
+
+    for ( k = 0; k < bsp_nprocs() * 2; ++k ) {
+        counts[k] = 0;
+    }
+    bsp_global_put ( counts, h, 0, sizeof ( int ) * bsp_nprocs() * 2 );
+    bsp_sync();
+
+    /* every processor increments all counters, two of them in one go across a slice boundary */
+    for ( k = 0; k < bsp_nprocs() * 2; ++k ) {
+        if ( k == 1 && bsp_nprocs() > 1 ) {
+            bsp_global_put_accumulate ( ones, h, sizeof ( int ) * k, 2 * sizeof ( int ),
+                bsp_op_sum, bsp_type_int );
+            ++k;
+        } else {
+            bsp_global_put_accumulate ( ones, h, sizeof ( int ) * k, sizeof ( int ),
+                bsp_op_sum, bsp_type_int );
+        }
+    }
+    bsp_sync();
+
+    bsp_global_get ( h, 0, counts, sizeof ( int ) * bsp_nprocs() * 2 );
+    bsp_sync();
+
+    for ( k = 0; k < bsp_nprocs() * 2; ++k ) {
+        if ( counts[k] != bsp_nprocs() ) {
+            printf ( "Global accumulate Failed: %i != %i\n", counts[k], bsp_nprocs() );
+        }
+        assert ( counts[k] == bsp_nprocs() );
+    }
+
+    bsp_sync();
+
+    bsp_free ( counts );
+    bsp_global_free ( h );
+}
+
+static int reversed_owner ( size_t block, int nprocs ) {
+    return (int) ( ( block * 7 + 3 ) % nprocs );
+}
+
+void test_distributions() {
+    const int n = 1000, bs = 12;
+    int * data = bsp_malloc ( n, sizeof ( int ) );
+    int * check = bsp_malloc ( n, sizeof ( int ) );
+    bsp_global_handle_t handles[40];
+    bsp_global_handle_t h[3];
+    int d, k;
+
+    /* more handles than the table holds initially, and reuse of freed ones */
+    for ( k = 0; k < 40; ++k ) {
+        handles[k] = bsp_global_alloc ( 16 );
+    }
+    bsp_sync();
+    for ( k = 0; k < 40; k += 2 ) {
+        bsp_global_free ( handles[k] );
+    }
+    bsp_sync();
+
+    h[0] = bsp_global_alloc_dist ( n * sizeof ( int ), bsp_dist_block, 0, NULL );
+    h[1] = bsp_global_alloc_dist ( n * sizeof ( int ), bsp_dist_block_cyclic, bs, NULL );
+    h[2] = bsp_global_alloc_dist ( n * sizeof ( int ), bsp_dist_custom, bs, reversed_owner );
+    assert ( h[0] == handles[0] );
+    assert ( h[1] == handles[2] );
+    assert ( h[2] == handles[4] );
+    bsp_sync();
+
+    for ( k = 0; k < n * (int) sizeof ( int ); k += 5 ) {
+        assert ( bsp_global_owner ( h[1], k ) == ( k / bs ) % bsp_nprocs() );
+        assert ( bsp_global_owner ( h[2], k ) == reversed_owner ( k / bs, bsp_nprocs() ) );
+    }
+
+    for ( d = 0; d < 3; ++d ) {
+        /* processor 0 writes everything in one go (but not at an aligned
+           offset), the others write the first entries */
+        for ( k = 0; k < n; ++k ) {
+            data[k] = d * n + k;
+        }
+        if ( bsp_pid() == 0 ) {
+            bsp_global_put ( data + 1, h[d], sizeof ( int ), ( n - 1 ) * sizeof ( int ) );
+        } else if ( bsp_pid() == 1 ) {
+            bsp_global_hpput ( data, h[d], 0, sizeof ( int ) );
+        }
+        if ( bsp_nprocs() == 1 ) {
+            bsp_global_put ( data, h[d], 0, sizeof ( int ) );
+        }
+        bsp_sync();
+
+        memset ( check, 0, n * sizeof ( int ) );
+        bsp_global_get ( h[d], 0, check, n * sizeof ( int ) );
+        bsp_sync();
+        for ( k = 0; k < n; ++k ) {
+            assert ( check[k] == d * n + k );
+        }
+
+        memset ( check, 0, n * sizeof ( int ) );
+        bsp_global_hpget ( h[d], 7 * sizeof ( int ), check, 333 * sizeof ( int ) );
+        bsp_sync();
+        for ( k = 0; k < 333; ++k ) {
+            assert ( check[k] == d * n + k + 7 );
+        }
+    }
+
+    for ( d = 0; d < 3; ++d ) {
+        bsp_global_free ( h[d] );
+    }
+    for ( k = 1; k < 40; k += 2 ) {
+        bsp_global_free ( handles[k] );
+    }
+    bsp_sync();
+    bsp_free ( data );
+    bsp_free ( check );
+}
+
+void test_gather_scatter() {
+    const int n = 500, m = 300;
+    const int s = bsp_pid(), P = bsp_nprocs();
+    const int w = m < n / P ? m : n / P; /* rows written */
+    size_t * indices = bsp_malloc ( m, sizeof ( size_t ) );
+    int * values = bsp_malloc ( m, sizeof ( int ) );
+    int * all = bsp_malloc ( n, sizeof ( int ) );
+    bsp_global_handle_t h[2];
+    int d, k;
+
+    /* a block distribution where elements straddle slices, and a 
+       block-cyclic one */
+    h[0] = bsp_global_alloc ( n * sizeof ( int ) + 2 );
+    h[1] = bsp_global_alloc_dist ( n * sizeof ( int ), bsp_dist_block_cyclic, 
+        4 * sizeof ( int ), NULL );
+    bsp_sync();
+
+    for ( d = 0; d < 2; ++d ) {
+        /* every processor writes the elements k % P == s, twice: the 
+           second value must win */
+        for ( k = 0; k < m; ++k ) {
+            indices[k] = ( k % ( n / P ) ) * P + s;
+            values[k] = k < n / P ? -1 : (int) indices[k] * 10 + d;
+        }
+        bsp_global_scatter ( values, h[d], indices, m, sizeof ( int ) );
+        bsp_sync();
+
+        /* read them back with repeated, random indices */
+        for ( k = 0; k < m; ++k ) {
+            indices[k] = ( ( k / 2 ) * 7919 + s * 13 ) % ( w * P );
+            values[k] = 0;
+        }
+        bsp_global_gather ( h[d], indices, m, values, sizeof ( int ) );
+        bsp_sync();
+        for ( k = 0; k < m; ++k ) {
+            int expect = m - n / P > (int) ( indices[k] / P ) 
+                ? (int) indices[k] * 10 + d : -1;
+            assert ( values[k] == expect );
+        }
+
+        bsp_global_get ( h[d], 0, all, w * P * sizeof ( int ) );
+        bsp_sync();
+        for ( k = 0; k < w * P; ++k ) {
+            assert ( all[k] == ( m - n / P > k / P ? k * 10 + d : -1 ) );
+        }
+    }
+
+    bsp_global_free ( h[0] );
+    bsp_global_free ( h[1] );
+    bsp_sync();
+    bsp_free ( indices );
+    bsp_free ( values );
+    bsp_free ( all );
+}
+
+void test_cache() {
+    const int n = 1000, line = 16;
+    const int lines = ( n * (int) sizeof ( int ) + line - 1 ) / line;
+    const int s = bsp_pid(), P = bsp_nprocs();
+    int * all = bsp_malloc ( n, sizeof ( int ) );
+    int value = -5;
+    bsp_global_cache_stats_t stats;
+    bsp_global_handle_t h;
+    int k;
+
+    h = bsp_global_alloc_dist ( n * sizeof ( int ), bsp_dist_block_cyclic, 
+        8 * sizeof ( int ), NULL );
+    bsp_global_cache ( h, line );
+    bsp_sync();
+
+    if ( s == 0 ) {
+        for ( k = 0; k < n; ++k ) {
+            all[k] = k;
+        }
+        bsp_global_put ( all, h, 0, n * sizeof ( int ) );
+    }
+    bsp_sync();
+
+    /* first read fetches every line */
+    memset ( all, 0, n * sizeof ( int ) );
+    bsp_global_get ( h, 0, all, n * sizeof ( int ) );
+    bsp_sync();
+    for ( k = 0; k < n; ++k ) {
+        assert ( all[k] == k );
+    }
+    bsp_global_cache_stats ( h, &stats );
+    assert ( stats.misses == (unsigned long) lines );
+    assert ( stats.hits == 0 );
+
+    /* second read is served locally, and sees the values before the 
+       put in the same superstep */
+    memset ( all, 0, n * sizeof ( int ) );
+    bsp_global_get ( h, 0, all, n * sizeof ( int ) );
+    if ( s == P - 1 ) {
+        bsp_global_put ( &value, h, 5 * sizeof ( int ), sizeof ( int ) );
+    }
+    bsp_sync();
+    for ( k = 0; k < n; ++k ) {
+        assert ( all[k] == k );
+    }
+    bsp_global_cache_stats ( h, &stats );
+    assert ( stats.misses == (unsigned long) lines );
+    assert ( stats.hits == (unsigned long) lines );
+    assert ( stats.invalidations == 1 );
+
+    /* only the written line is fetched again */
+    bsp_global_get ( h, 0, all, n * sizeof ( int ) );
+    bsp_sync();
+    for ( k = 0; k < n; ++k ) {
+        assert ( all[k] == ( k == 5 ? -5 : k ) );
+    }
+    bsp_global_cache_stats ( h, &stats );
+    assert ( stats.misses == (unsigned long) lines + 1 );
+    assert ( stats.hits == 2 * (unsigned long) lines - 1 );
+
+    /* writes of different processors to the first and last line are 
+       combined, and both lines are invalidated */
+    if ( s == 0 ) {
+        bsp_global_put ( &value, h, sizeof ( int ), sizeof ( int ) );
+    }
+    if ( s == P - 1 ) {
+        bsp_global_put ( &value, h, ( n - 1 ) * sizeof ( int ), sizeof ( int ) );
+    }
+    bsp_sync();
+    bsp_global_cache_stats ( h, &stats );
+    assert ( stats.invalidations == 3 );
+    bsp_global_get ( h, 0, all, n * sizeof ( int ) );
+    bsp_sync();
+    for ( k = 0; k < n; ++k ) {
+        assert ( all[k] == ( k == 1 || k == 5 || k == n - 1 ? -5 : k ) );
+    }
+    bsp_global_cache_stats ( h, &stats );
+    assert ( stats.misses == (unsigned long) lines + 3 );
+
+    bsp_global_free ( h );
+    bsp_sync();
+    bsp_free ( all );
+}
+
 void bsp_test_get ( void ) {
     test_drma();
+    test_accumulate();
+    test_distributions();
+    test_gather_scatter();
+    test_cache();
 }
 
 int main ( int argc, char *argv[] ) {
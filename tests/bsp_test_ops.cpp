@@ -33,9 +33,17 @@ Test all BSP communication operations in a context.
 
 #include "ops/test_put.h"
 #include "ops/test_hpput.h"
+#include "ops/test_putdeferred.h"
+#include "ops/test_array.h"
 #include "ops/test_get.h"
 #include "ops/test_hpget.h"
 #include "ops/test_send.h"
+#include "ops/test_channel.h"
+#include "ops/test_memreg.h"
+#include "ops/test_balance.h"
+#include "ops/test_commbalance.h"
+#include "ops/test_nested.h"
+#include "ops/test_numa.h"
 
 
 /**
@@ -86,6 +94,12 @@ int main (int argc, char** argv) {
 			cout << "Testing hpput p = " << procs << endl;
 			bsp::Runner<TestHpPut> (procs).run( );
 			bsp_sync();
+			cout << "Testing deferred put p = " << procs << endl;
+			bsp::Runner<TestPutDeferred> (procs).run( );
+			bsp_sync();
+			cout << "Testing typed arrays p = " << procs << endl;
+			bsp::Runner<TestArray> (procs).run( );
+			bsp_sync();
 			cout << "Testing get p = " << procs << endl;
 			bsp::Runner<TestGet> (procs).run( );
 			bsp_sync();
@@ -95,6 +109,42 @@ int main (int argc, char** argv) {
 			cout << "Testing BSMP p = " << procs << endl;
 			bsp::Runner<TestSend> (procs).run( );
 			bsp_sync();
+			cout << "Testing channels p = " << procs << endl;
+			bsp::Runner<TestChannel> (procs).run( );
+			bsp_sync();
+			cout << "Testing memory registers p = " << procs << endl;
+			bsp::Runner<TestMemReg> (procs).run( );
+			bsp_sync();
+			cout << "Testing NUMA affinity p = " << procs << endl;
+			{
+				bsp::Runner<TestNuma, bsp::NumaTaskMapper> r (procs);
+				for (int k = 0; k < 2; ++k) {
+					r.run( );
+					TestNuma::check_unbound();
+				}
+			}
+			bsp_sync();
+			cout << "Testing runner reuse p = " << procs << endl;
+			{
+				bsp::Runner<TestPut> r (procs);
+				for (int k = 0; k < 3; ++k) {
+					r.run( );
+				}
+			}
+			bsp_sync();
+			cout << "Testing nested runners p = " << procs << endl;
+			{
+				bsp::Runner<TestNested> r (procs);
+				r.run( );
+				r.check_total(procs);
+			}
+			bsp_sync();
+			cout << "Testing load balancing p = " << procs << endl;
+			bsp::Runner<TestBalance, bsp::LoadBalancingTaskMapper> (procs).run( );
+			bsp_sync();
+			cout << "Testing communication-aware placement p = " << procs << endl;
+			bsp::Runner<TestCommBalance, bsp::CommunicationAwareTaskMapper> (procs).run( );
+			bsp_sync();
 			++procs;
 		}
 
@@ -98,10 +98,398 @@ void an_all_to_all()
 	bsp_free(array2);
 }
 
+void a_strided_transpose()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	int * a = (int *) bsp_malloc(P * P + 2, sizeof(int));
+	int * t = (int *) bsp_malloc(P * P, sizeof(int));
+	int * u = (int *) bsp_malloc(P * P, sizeof(int));
+	int * v = (int *) bsp_malloc(P * 3, sizeof(int));
+	bsp_block_t blocks[2];
+	int i, k;
+
+	for (i = 0; i < P * P + 2; i++)
+		a[i] = s * P * P + i;
+	bsp_push_reg(t, P * P * sizeof(int));
+	bsp_push_reg(u, P * P * sizeof(int));
+	bsp_push_reg(v, P * 3 * sizeof(int));
+	bsp_sync();
+
+	/* indexed blocks: a[0] to v[3s], a[P..P+1] to v[3s+1..3s+2] */
+	blocks[0].src_offset = 0;
+	blocks[0].dst_offset = 3 * s * sizeof(int);
+	blocks[0].nbytes = sizeof(int);
+	blocks[1].src_offset = P * sizeof(int);
+	blocks[1].dst_offset = (3 * s + 1) * sizeof(int);
+	blocks[1].nbytes = 2 * sizeof(int);
+
+	for (i = 0; i < P; i++)
+	{
+		/* column i of a to row s of t on processor i */
+		bsp_put_strided(i, a + i, P * sizeof(int), t, s * P * sizeof(int), 
+			sizeof(int), sizeof(int), P);
+		/* row i of a to column s of u on processor i */
+		bsp_put_strided(i, a + i * P, sizeof(int), u, s * sizeof(int), 
+			P * sizeof(int), sizeof(int), P);
+		bsp_put_indexed(i, a, v, blocks, 2);
+	}
+	bsp_sync();
+
+	for (i = 0; i < P; i++)
+	{
+		for (k = 0; k < P; k++)
+		{
+			assert(t[i * P + k] == i * P * P + k * P + s);
+			assert(u[k * P + i] == i * P * P + s * P + k);
+		}
+		assert(v[3 * i] == i * P * P);
+		assert(v[3 * i + 1] == i * P * P + P);
+		assert(v[3 * i + 2] == i * P * P + P + 1);
+	}
+
+	bsp_pop_reg(v);
+	bsp_pop_reg(u);
+	bsp_pop_reg(t);
+	bsp_sync();
+	bsp_free(a);
+	bsp_free(t);
+	bsp_free(u);
+	bsp_free(v);
+}
+
+void a_batch()
+{
+	const int P = bsp_nprocs(), s = bsp_pid(), N = 100;
+	double * histogram = (double *) bsp_malloc(P * N, sizeof(double));
+	double * values = (double *) bsp_malloc(N, sizeof(double));
+	int * pids = (int *) bsp_malloc(N, sizeof(int));
+	long * offsets = (long *) bsp_malloc(N, sizeof(long));
+	int i, k;
+
+	bsp_push_reg(histogram, P * N * sizeof(double));
+	bsp_sync();
+
+	/* value k goes to processor k % P, into slot k of row s */
+	for (k = 0; k < N; k++)
+	{
+		pids[k] = k % P;
+		offsets[k] = (s * N + k) * sizeof(double);
+		values[k] = s * 1000.0 + k;
+	}
+	for (i = 0; i < P * N; i++)
+		histogram[i] = -1.0;
+	bsp_put_batch(histogram, pids, offsets, values, sizeof(double), N);
+	bsp_sync();
+
+	for (i = 0; i < P; i++)
+		for (k = 0; k < N; k++)
+			assert(histogram[i * N + k] == (k % P == s ? i * 1000.0 + k : -1.0));
+
+	bsp_pop_reg(histogram);
+	bsp_sync();
+	bsp_free(histogram);
+	bsp_free(values);
+	bsp_free(pids);
+	bsp_free(offsets);
+}
+
+static void multiply_longs(void * accumulated, const void * src, size_t nbytes)
+{
+	long * a = (long *) accumulated;
+	const long * b = (const long *) src;
+	size_t i;
+	for (i = 0; i < nbytes / sizeof(long); i++)
+		a[i] *= b[i];
+}
+
+void an_accumulate()
+{
+	const int P = bsp_nprocs(), s = bsp_pid(), N = 16;
+	bsp_op_t multiply = bsp_register_op(multiply_longs);
+	double * sums = (double *) bsp_malloc(N, sizeof(double));
+	double * values = (double *) bsp_malloc(N, sizeof(double));
+	int minmax[2];
+	long products[2];
+	long factors[2];
+	int i, k;
+
+	bsp_push_reg(sums, N * sizeof(double));
+	bsp_push_reg(minmax, 2 * sizeof(int));
+	bsp_push_reg(products, 2 * sizeof(long));
+	bsp_sync();
+
+	for (k = 0; k < N; k++)
+	{
+		sums[k] = 1.0;
+		values[k] = s + k;
+	}
+	minmax[0] = 1000;
+	minmax[1] = -1000;
+	products[0] = products[1] = 1;
+	factors[0] = 2;
+	factors[1] = s + 1;
+	for (i = 0; i < P; i++)
+	{
+		/* every processor adds to all entries but the first */
+		bsp_put_accumulate(i, values + 1, sums, sizeof(double), 
+			(N - 1) * sizeof(double), bsp_op_sum, bsp_type_double);
+		bsp_put_accumulate(i, &s, minmax, 0, sizeof(int), bsp_op_min, bsp_type_int);
+		bsp_put_accumulate(i, &s, minmax, sizeof(int), sizeof(int), bsp_op_max, bsp_type_int);
+		bsp_put_accumulate(i, factors, products, 0, 2 * sizeof(long), multiply, bsp_type_long);
+	}
+	bsp_sync();
+
+	assert(sums[0] == 1.0);
+	for (k = 1; k < N; k++)
+		assert(sums[k] == 1.0 + P * k + P * (P - 1) / 2);
+	assert(minmax[0] == 0);
+	assert(minmax[1] == P - 1);
+	for (i = 0, factors[0] = 1, factors[1] = 1; i < P; i++)
+	{
+		factors[0] *= 2;
+		factors[1] *= i + 1;
+	}
+	assert(products[0] == factors[0]);
+	assert(products[1] == factors[1]);
+
+	bsp_pop_reg(products);
+	bsp_pop_reg(minmax);
+	bsp_pop_reg(sums);
+	bsp_sync();
+	bsp_free(sums);
+	bsp_free(values);
+}
+
+void a_symmetric_heap()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	int * a = (int *) bsp_symmetric_alloc(P * sizeof(int));
+	double * b = (double *) bsp_symmetric_alloc(P * sizeof(double));
+	double * values = (double *) bsp_malloc(P, sizeof(double));
+	int * pids = (int *) bsp_malloc(P, sizeof(int));
+	long * offsets = (long *) bsp_malloc(P, sizeof(long));
+	int * c;
+	int i;
+
+	/* no registration and no sync are needed before the first put */
+	for (i = 0; i < P; i++)
+	{
+		bsp_put(i, &s, a, s * sizeof(int), sizeof(int));
+		pids[i] = i;
+		offsets[i] = s * sizeof(double);
+		values[i] = s + 0.5;
+	}
+	bsp_put_batch(b, pids, offsets, values, sizeof(double), P);
+	bsp_sync();
+	for (i = 0; i < P; i++)
+	{
+		assert(a[i] == i);
+		assert(b[i] == i + 0.5);
+	}
+
+	/* freed blocks are reused at the same offset on every processor */
+	bsp_symmetric_free(a);
+	c = (int *) bsp_symmetric_alloc(P * sizeof(int));
+	assert(c == a);
+	for (i = 0; i < P; i++)
+	{
+		c[i] = s;
+		offsets[i] = i * sizeof(double);
+		values[i] = 0;
+	}
+	bsp_get_batch(b, pids, offsets, values, sizeof(double), P);
+	bsp_get((s + 1) % P, c, 0, a, sizeof(int));
+	bsp_sync();
+	assert(c[0] == (s + 1) % P);
+	for (i = 0; i < P; i++)
+		assert(values[i] == i + 0.5);
+
+	bsp_symmetric_free(c);
+	bsp_symmetric_free(b);
+	bsp_free(values);
+	bsp_free(pids);
+	bsp_free(offsets);
+}
+
+void a_neighbourhood()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	int neighbours[2], halo[2], k;
+	double x = 0, y = 0;
+
+	/* a ring */
+	neighbours[0] = (s + P - 1) % P;
+	neighbours[1] = (s + 1) % P;
+	bsp_set_neighbours(neighbours, 2);
+
+	/* registration supersteps still synchronise all processors */
+	bsp_push_reg(halo, 2 * sizeof(int));
+	bsp_push_reg(&x, sizeof(double));
+	bsp_sync();
+
+	for (k = 0; k < 3; k++)
+	{
+		halo[0] = halo[1] = -1;
+		bsp_put(neighbours[0], &s, halo, sizeof(int), sizeof(int));
+		bsp_put(neighbours[1], &s, halo, 0, sizeof(int));
+		x = s + k;
+		bsp_get(neighbours[1], &x, 0, &y, sizeof(double));
+		bsp_sync();
+		assert(halo[0] == neighbours[0]);
+		assert(halo[1] == neighbours[1]);
+		assert(y == neighbours[1] + k);
+	}
+
+	/* only one processor gets */
+	for (k = 0; k < 3; k++)
+	{
+		halo[0] = -1;
+		y = -1;
+		bsp_put(neighbours[1], &s, halo, 0, sizeof(int));
+		x = s + k;
+		if (s == 0)
+			bsp_get(neighbours[1], &x, 0, &y, sizeof(double));
+		bsp_sync();
+		assert(halo[0] == neighbours[0]);
+		assert(s != 0 || y == neighbours[1] + k);
+	}
+
+	bsp_pop_reg(&x);
+	bsp_pop_reg(halo);
+	bsp_sync();
+	bsp_set_neighbours(NULL, -1);
+}
+
+void a_pattern()
+{
+	const int P = bsp_nprocs(), s = bsp_pid();
+	const int left = (s + P - 1) % P, right = (s + 1) % P;
+	int halo[3], value[2], k;
+	int * last;
+	bsp_pattern_t pattern;
+
+	last = (int *) bsp_symmetric_alloc(sizeof(int));
+	bsp_push_reg(halo, 3 * sizeof(int));
+	bsp_sync();
+
+	/* record a superstep, which is delivered as usual */
+	value[0] = s;
+	value[1] = -s;
+	bsp_pattern_begin();
+	bsp_put(left, &value[0], halo, 2 * sizeof(int), sizeof(int));
+	bsp_put(right, &value[0], halo, 0, sizeof(int));
+	bsp_put(s, &value[1], halo, sizeof(int), sizeof(int));
+	/* later puts to the same place win */
+	bsp_put(right, &value[1], last, 0, sizeof(int));
+	bsp_put(right, &value[0], last, 0, sizeof(int));
+	pattern = bsp_pattern_end();
+	bsp_sync();
+	assert(halo[0] == left && halo[1] == -s && halo[2] == right);
+	assert(*last == left);
+
+	/* replay with new data */
+	for (k = 1; k < 4; k++)
+	{
+		value[0] = s + k * P;
+		value[1] = -value[0];
+		halo[0] = halo[1] = halo[2] = *last = -1;
+		bsp_pattern_sync(pattern);
+		assert(halo[0] == left + k * P);
+		assert(halo[1] == -value[0]);
+		assert(halo[2] == right + k * P);
+		assert(*last == left + k * P);
+	}
+
+	bsp_pattern_free(pattern);
+	bsp_pop_reg(halo);
+	bsp_sync();
+	bsp_symmetric_free(last);
+}
+
+void an_eager_flush()
+{
+	const int P = bsp_nprocs(), s = bsp_pid(), N = 256;
+	int * area = (int *) bsp_malloc(P * N, sizeof(int));
+	int * old = (int *) bsp_malloc(N, sizeof(int));
+	int k, p, i, winner = -1;
+
+	bsp_push_reg(area, P * N * sizeof(int));
+	bsp_push_reg(&winner, sizeof(int));
+	bsp_sync();
+
+	/* columns are sent after 64 bytes */
+	bsp_set_eager_threshold(64);
+	for (k = 0; k < 3; k++)
+	{
+		const int next = (s + 1) % P;
+		for (i = 0; i < P * N; i++)
+			area[i] = -1;
+		bsp_sync();
+
+		/* gets see the data before the puts of the superstep */
+		bsp_get(next, area, s * N * sizeof(int), old, N * sizeof(int));
+		for (i = 0; i < N; i++)
+			for (p = 0; p < P; p++)
+			{
+				const int value = k * P * N + s * N + i;
+				bsp_put(p, &value, area, (s * N + i) * sizeof(int), sizeof(int));
+			}
+		/* a later put to the same place wins */
+		bsp_put(next, &k, area, s * N * sizeof(int), sizeof(int));
+		/* a column with messages is sent at the sync */
+		bsp_send(next, NULL, &s, sizeof(int));
+		for (i = 0; i < P * N; i++)
+			assert(area[i] == -1);
+		bsp_sync();
+
+		for (p = 0; p < P; p++)
+			for (i = 0; i < N; i++)
+			{
+				const int expected = p == (s + P - 1) % P && i == 0 ?
+					k : k * P * N + p * N + i;
+				assert(area[p * N + i] == expected);
+			}
+		for (i = 0; i < N; i++)
+			assert(old[i] == -1);
+		{
+			int nmessages, source;
+			size_t nbytes;
+			bsp_qsize(&nmessages, &nbytes);
+			assert(nmessages == 1);
+			bsp_move(&source, sizeof(int));
+			assert(source == (s + P - 1) % P);
+		}
+	}
+
+	/* puts from different processors to the same place are executed in 
+	   the order of the sources, also if the last one was sent eagerly */
+	bsp_put(0, &s, &winner, 0, sizeof(int));
+	if (s == P - 1)
+		for (i = 0; i < N; i++)
+			bsp_put(0, &i, area, i * sizeof(int), sizeof(int));
+	bsp_sync();
+	if (s == 0)
+		assert(winner == P - 1);
+	bsp_set_eager_threshold(0);
+
+	bsp_pop_reg(&winner);
+	bsp_pop_reg(area);
+	bsp_sync();
+	bsp_free(old);
+	bsp_free(area);
+}
+
 void bsp_test_put(void)
 {
 	a_simple_summation();
 	an_all_to_all(); 
+	a_strided_transpose();
+	a_batch();
+	an_accumulate();
+	a_symmetric_heap();
+	a_neighbourhood();
+	a_pattern();
+	an_eager_flush();
 }
 
 int	main (int argc, char *argv[]) {
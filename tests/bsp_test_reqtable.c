@@ -37,6 +37,9 @@ main(int argc, char *argv[])
   req2.offset = req1.offset = 0;
   req2.src=(char *) &a ; req1.src = (char *) &b;
   req2.dst=(char *) &x ; req1.dst = (char *) &y;
+  req2.count = req1.count = 1;
+  req2.info.strided.src_stride = req1.info.strided.src_stride = 0;
+  req2.info.strided.dst_stride = req1.info.strided.dst_stride = 0;
  
   requestTable_initialize(&reqtab, NPROCS, 1);
   deliveryTable_initialize(&delivtab, NPROCS, 1);
@@ -44,7 +47,7 @@ main(int argc, char *argv[])
   requestTable_push(&reqtab, 0, &req2);
 
   requestTable_execute(&reqtab, &delivtab);
-  deliveryTable_execute(&delivtab, NULL, NULL, 0);
+  deliveryTable_execute(&delivtab, NULL, NULL, 0, NULL, NULL);
 
   assert(x == 3);
   assert(y == 10);
@@ -83,10 +83,154 @@ void just_messages () {
 	}
 }
 
+void bulk_messages () {
+	bsp_message_t m;
+	int i, count = 0, sum = 0;
+	const int P = bsp_nprocs(), s = bsp_pid();
+	const int * kept_payload = NULL;
+	int kept_source = -1;
+	void * kept;
+	size_t tag_size = sizeof(int);
+	int payload[2];
+
+	bsp_set_tagsize(&tag_size);
+	bsp_sync();
+
+	for (i = 0; i < P; i++)
+	{
+		payload[0] = s;
+		payload[1] = 10 * s + i;
+		bsp_send (i, &i, payload, sizeof(payload));
+	}
+
+	bsp_sync ();
+
+	if (bsp_messages_begin(&m))
+	{
+		do
+		{
+			const int * p = (const int *) m.payload;
+			assert (m.nbytes == sizeof(payload));
+			assert (m.source == p[0]);
+			assert (*(const int *) m.tag == s);
+			assert (p[1] == 10 * m.source + s);
+			sum += m.source;
+			count++;
+			if (m.source == P - 1)
+			{
+				kept_payload = p;
+				kept_source = m.source;
+			}
+		} while (bsp_messages_next(&m));
+	}
+	assert (count == P);
+	assert (sum == (P-1)*P / 2);
+
+	/* all messages have been dequeued */
+	{
+		int n;
+		size_t b;
+		bsp_qsize(&n, &b);
+		assert (n == 0);
+	}
+
+	kept = bsp_messages_keep();
+
+	/* the kept messages survive the next exchange of messages */
+	for (i = 0; i < P; i++)
+	{
+		payload[0] = -1;
+		payload[1] = -1;
+		bsp_send (i, &i, payload, sizeof(payload));
+	}
+	bsp_sync ();
+
+	assert (kept_payload[0] == kept_source);
+	assert (kept_payload[1] == 10 * kept_source + s);
+	bsp_messages_release(kept);
+
+	count = 0;
+	if (bsp_messages_begin(&m))
+	{
+		do
+		{
+			assert (((const int *) m.payload)[0] == -1);
+			count++;
+		} while (bsp_messages_next(&m));
+	}
+	assert (count == P);
+	bsp_sync ();
+}
+
+static long tag_key (const void * tag, const void * payload, size_t nbytes)
+{
+	return *(const int *) tag;
+}
+
+static void sum_ints (void * accumulated, const void * payload, size_t nbytes)
+{
+	*(int *) accumulated += *(const int *) payload;
+}
+
+void combined_messages () {
+	bsp_message_t m;
+	int i, k, count = 0, sum = 0, uncombined = 0;
+	const int P = bsp_nprocs(), s = bsp_pid();
+	size_t tag_size = sizeof(int);
+	int tag, value;
+
+	bsp_set_tagsize(&tag_size);
+	bsp_sync();
+
+	bsp_set_combiner(tag_key, sum_ints);
+	for (i = 0; i < P; i++)
+	{
+		/* combined into a single message per destination */
+		tag = 7;
+		for (k = 0; k < 10; k++)
+		{
+			value = s + k;
+			bsp_send (i, &tag, &value, sizeof(int));
+		}
+		/* negative keys are not combined */
+		tag = -1;
+		value = 1;
+		bsp_send (i, &tag, &value, sizeof(int));
+		bsp_send (i, &tag, &value, sizeof(int));
+	}
+	bsp_set_combiner(NULL, NULL);
+	bsp_sync ();
+
+	if (bsp_messages_begin(&m))
+	{
+		do
+		{
+			assert (m.nbytes == sizeof(int));
+			if (*(const int *) m.tag == 7)
+			{
+				assert (*(const int *) m.payload == 10 * m.source + 45);
+				sum += *(const int *) m.payload;
+				count++;
+			}
+			else
+			{
+				assert (*(const int *) m.tag == -1);
+				uncombined += *(const int *) m.payload;
+			}
+		} while (bsp_messages_next(&m));
+	}
+	assert (count == P);
+	assert (sum == 10 * (P-1)*P / 2 + 45 * P);
+	assert (uncombined == 2 * P);
+	bsp_sync ();
+}
+
 void bsp_test_send(void)
 {
 	a_simple_summation();
 	just_messages();
+	bulk_messages();
+	combined_messages();
 }
 
 int	main (int argc, char *argv[])
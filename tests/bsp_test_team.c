@@ -0,0 +1,125 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file bsp_test_team.c
+
+@author Peter Krusche
+*/
+
+#include "bsp.h"
+#include "bsp_level1.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+void sum_op (void * res, void *l, void * r, int* nbytes) {
+	assert (*nbytes == sizeof(int));
+	*((int*)res) = (*((int*)l) + *((int*)r));
+}
+
+/** two teams of the even and the odd processors, which sync a different
+    number of times */
+void two_teams () {
+	const int P = bsp_nprocs(), s = bsp_pid();
+	const int color = s % 2;
+	const int members = ( P - color + 1 ) / 2;
+	int * ring = (int *) bsp_malloc (members, sizeof(int));
+	int pid, k, sum = 0, status, value;
+	bsp_team_t team = bsp_team_split (color, -s);
+
+	assert (team != NULL);
+	bsp_team_enter (team);
+
+	/* ranked by key, i.e. in reverse order */
+	assert (bsp_nprocs() == members);
+	pid = bsp_pid();
+	assert (pid == members - 1 - s / 2);
+
+	bsp_push_reg (ring, members * sizeof(int));
+	bsp_sync();
+
+	for (k = 0; k < 1 + 2 * color; ++k) {
+		bsp_put ((pid + 1) % members, &s, ring, pid * sizeof(int), sizeof(int));
+		bsp_send ((pid + 1) % members, NULL, &k, sizeof(int));
+		bsp_sync();
+
+		/* the processor before us in the team is 2 pids after us */
+		assert (ring[(pid + members - 1) % members] == 
+			( members == 1 ? s : color + 2 * ( members - 1 - (pid + members - 1) % members ) ));
+		bsp_get_tag (&status, NULL);
+		assert (status == sizeof(int));
+		bsp_move (&value, sizeof(int));
+		assert (value == k);
+	}
+
+	value = s;
+	bsp_fold (sum_op, &value, &sum, sizeof(int));
+	assert (sum == ( color == 0 ? members * (members - 1) : members * members ));
+
+	bsp_pop_reg (ring);
+	bsp_sync();
+	bsp_team_leave();
+	bsp_team_free (team);
+
+	/* back in the team of all processors */
+	assert (bsp_nprocs() == P);
+	assert (bsp_pid() == s);
+	bsp_sync();
+	bsp_free (ring);
+}
+
+/** a nested team, which only the first processor joins */
+void nested_teams () {
+	const int s = bsp_pid();
+	bsp_team_t all = bsp_team_split (0, s);
+	bsp_team_t first;
+	int * x;
+
+	bsp_team_enter (all);
+	first = bsp_team_split (s == 0 ? 0 : -1, 0);
+	assert ( ( first != NULL ) == ( s == 0 ) );
+	if (first != NULL) {
+		bsp_team_enter (first);
+		assert (bsp_nprocs() == 1);
+		/* the symmetric heap is local to the team as well */
+		x = (int *) bsp_symmetric_alloc (sizeof(int));
+		*x = -1;
+		bsp_put (0, &s, x, 0, sizeof(int));
+		bsp_sync();
+		assert (*x == 0);
+		bsp_symmetric_free (x);
+		bsp_team_leave();
+		bsp_team_free (first);
+	}
+	bsp_sync();
+	bsp_team_leave();
+	bsp_team_free (all);
+}
+
+int main(int argc, char **argv) {
+	bsp_init(&argc, &argv);
+	two_teams();
+	nested_teams();
+	bsp_end();
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_array.h
+
+@author Peter Krusche
+*/
+#ifndef __test_array_H__
+#define __test_array_H__
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+class TestArray : public bsp::Context {
+public:
+	void init() {
+		for (int j = 0; j < 16; ++j) {
+			values[j] = -1.0;
+			got[j] = -1.0;
+		}
+		count = -1;
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestArray);
+		BSP_BEGIN();
+
+		a = bsp_push_array(values, 16);
+		c = bsp_push_var(count);
+
+		BSP_SYNC();
+
+		right = (bsp_pid() + 1) % bsp_nprocs();
+		for (int j = 0; j < 4; ++j) {
+			mine[j] = bsp_pid() * 10 + j;
+		}
+
+		put (right, mine, a, 2, 4);
+		put<3> (right, mine + 1, a, 10);
+		put (right, bsp_pid(), c);
+
+		BSP_SYNC();
+
+		left = (bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs();
+		CHECK_EQUAL( left, *c );
+		CHECK_EQUAL( -1.0, values[0] );
+		CHECK_EQUAL( -1.0, values[1] );
+		for (int j = 0; j < 4; ++j) {
+			CHECK_EQUAL( (double)(left * 10 + j), a[2 + j] );
+		}
+		CHECK_EQUAL( -1.0, values[6] );
+		CHECK_EQUAL( -1.0, values[9] );
+		for (int j = 0; j < 3; ++j) {
+			CHECK_EQUAL( (double)(left * 10 + j + 1), values[10 + j] );
+		}
+		CHECK_EQUAL( -1.0, values[13] );
+
+		get (right, a, 10, got, 3);
+		get (right, a, 2, got + 3, 1);
+
+		BSP_SYNC();
+
+		for (int j = 0; j < 3; ++j) {
+			CHECK_EQUAL( (double)(bsp_pid() * 10 + j + 1), got[j] );
+		}
+		CHECK_EQUAL( (double)(bsp_pid() * 10), got[3] );
+		CHECK_EQUAL( -1.0, got[4] );
+
+		bsp_pop_array(a);
+		bsp_pop_array(c);
+
+		BSP_END();
+	}
+
+protected:
+	double values[16];
+	double got[16];
+	double mine[4];
+	int count;
+	int left;
+	int right;
+	bsp::Array<double> a;
+	bsp::Registered<int> c;
+};
+
+
+#endif // __test_array_H__
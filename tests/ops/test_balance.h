@@ -0,0 +1,118 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_balance.h
+
+Test remapping of contexts by the load-balancing task mapper.
+
+@author Peter Krusche
+*/
+#ifndef __test_balance_H__
+#define __test_balance_H__
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+class TestBalance : public bsp::Context {
+public:
+	TestBalance() {
+		state = 0;
+		CONTEXT_SHARED_INIT(state, int);
+	}
+
+	void init() {
+		var = -1;
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestBalance);
+		BSP_BEGIN();
+
+		state = 7 * bsp_pid() + 1;
+
+		// the first half of the processors gets all the work
+		if (bsp_pid() < bsp_nprocs() / 2) {
+			double t0 = bsp_time();
+			while (bsp_time() - t0 < 0.002) ;
+		}
+
+		BSP_END();
+
+		get_mapper()->rebalance();
+
+		BSP_BEGIN();
+
+		// shared state must survive migration
+		CHECK_EQUAL(7 * bsp_pid() + 1, state);
+		CHECK_EQUAL(bsp_pid(), 
+			get_mapper()->local_to_global_pid(bsp_local_pid()));
+
+		{
+			// the busy processors start in blocks of ceil(p/nodes); when 
+			// spreading them clearly lowers the maximum load, some must move
+			const int P = bsp_nprocs(), N = get_mapper()->nodes();
+			const int mppn = (P + N - 1) / N, busy = P / 2;
+			int old_max = 0, moved = 0;
+			for (int n = 0; n < N; ++n) {
+				old_max = max(old_max, max(0, min(busy, (n + 1) * mppn) - n * mppn));
+			}
+			for (int q = 0; q < P; ++q) {
+				if (get_mapper()->global_to_node(q) != q / mppn) {
+					++moved;
+				}
+			}
+			if ( (busy + N - 1) / N < 0.8 * old_max ) {
+				CHECK(moved > 0);
+			}
+		}
+
+		bsp_push_reg(&var, sizeof (int));
+
+		BSP_SYNC();
+
+		right = (bsp_pid() + 1) % bsp_nprocs();
+		left = (bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs();
+		bsp_put (right, &state, &var, 0, sizeof(int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(7 * left + 1, var);
+		bsp_pop_reg(&var);
+
+		BSP_END();
+	}
+
+	int state;
+
+protected:
+	int var;
+	int left;
+	int right;
+};
+
+
+#endif // __test_balance_H__
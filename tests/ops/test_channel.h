@@ -0,0 +1,94 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_channel.h
+
+@author Peter Krusche
+*/
+#ifndef __test_channel_H__
+#define __test_channel_H__
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+class TestChannel : public bsp::Context {
+public:
+	TestChannel () : values (this), neighbours (this) {}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestChannel);
+		BSP_BEGIN();
+
+		CHECK_EQUAL( (size_t)0, values.size() );
+
+		// every processor sends j+1 records to processor j
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			for (int k = 0; k <= j; ++k) {
+				values.send (j, bsp_pid(), (double) (bsp_pid() * 100 + k));
+			}
+		}
+		neighbours.send ((bsp_pid() + 1) % bsp_nprocs(), bsp_pid(), bsp_pid() * 2);
+
+		BSP_SYNC();
+
+		CHECK_EQUAL( (size_t)(bsp_nprocs() * (bsp_pid() + 1)), values.size() );
+		{
+			std::vector<double> sums (bsp_nprocs(), 0.0);
+			for (bsp::Channel<int, double>::const_iterator it = values.begin(); 
+				it != values.end(); ++it) {
+				CHECK( it->tag >= 0 && it->tag < bsp_nprocs() );
+				sums[it->tag] += it->payload;
+			}
+			for (int j = 0; j < bsp_nprocs(); ++j) {
+				double k = bsp_pid();
+				CHECK_EQUAL( (k + 1) * j * 100 + k * (k + 1) / 2, sums[j] );
+			}
+		}
+
+		CHECK_EQUAL( (size_t)1, neighbours.size() );
+		left = (bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs();
+		CHECK_EQUAL( left, neighbours[0].tag );
+		CHECK_EQUAL( left * 2, neighbours[0].payload );
+
+		BSP_SYNC();
+
+		// records are only valid for one superstep
+		CHECK_EQUAL( (size_t)0, values.size() );
+		CHECK_EQUAL( (size_t)0, neighbours.size() );
+
+		BSP_END();
+	}
+
+protected:
+	bsp::Channel<int, double> values;
+	bsp::Channel<int, int> neighbours;
+	int left;
+};
+
+
+#endif // __test_channel_H__
@@ -0,0 +1,129 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_commbalance.h
+
+Test communication-aware placement of contexts.
+
+@author Peter Krusche
+*/
+#ifndef __test_commbalance_H__
+#define __test_commbalance_H__
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+#define TEST_COMMBALANCE_SIZE 1024
+
+class TestCommBalance : public bsp::Context {
+public:
+	TestCommBalance() {
+		state = 0;
+		CONTEXT_SHARED_INIT(state, int);
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestCommBalance);
+		BSP_BEGIN();
+
+		state = 3 * bsp_pid() + 2;
+		partner = (bsp_pid() + bsp_nprocs() / 2) % bsp_nprocs();
+		source = (bsp_pid() + bsp_nprocs() - bsp_nprocs() / 2) % bsp_nprocs();
+		bsp_push_reg(buffer, sizeof (int) * TEST_COMMBALANCE_SIZE);
+
+		BSP_SYNC();
+
+		// pairs of processors which are far apart in the default 
+		// mapping exchange a lot of data
+		for (int j = 0; j < TEST_COMMBALANCE_SIZE; ++j) {
+			outgoing[j] = bsp_pid();
+		}
+		bsp_put(partner, outgoing, buffer, 0, sizeof (int) * TEST_COMMBALANCE_SIZE);
+		bsp_pop_reg(buffer);
+
+		BSP_END();
+
+		get_mapper()->rebalance();
+
+		{
+			int V = get_mapper()->nprocs();
+			bsp::CommunicationAwareTaskMapper * m = 
+				static_cast<bsp::CommunicationAwareTaskMapper *> (get_mapper());
+			for (int p = 0; p < V && V > 1; ++p) {
+				// the graph holds the pairs which communicated
+				std::vector< std::pair<int, double> > const & edges = m->get_comm_graph()[p];
+				bool found = false;
+				for (size_t l = 0; l < edges.size(); ++l) {
+					CHECK(edges[l].first != p);
+					if (edges[l].first == (p + V / 2) % V) {
+						found = true;
+						CHECK(edges[l].second >= sizeof (int) * TEST_COMMBALANCE_SIZE);
+					}
+				}
+				CHECK(found);
+				CHECK(edges.size() <= 2);
+			}
+			if (V % 2 == 0 && ICD (V, ::bsp_nprocs()) % 2 == 0) {
+				for (int p = 0; p < V; ++p) {
+					CHECK_EQUAL(get_mapper()->global_to_node(p), 
+						get_mapper()->global_to_node((p + V / 2) % V));
+				}
+			}
+		}
+
+		BSP_BEGIN();
+
+		CHECK_EQUAL(3 * bsp_pid() + 2, state);
+
+		// only shared variables move with a context
+		partner = (bsp_pid() + bsp_nprocs() / 2) % bsp_nprocs();
+		source = (bsp_pid() + bsp_nprocs() - bsp_nprocs() / 2) % bsp_nprocs();
+		bsp_push_reg(buffer, sizeof (int) * TEST_COMMBALANCE_SIZE);
+
+		BSP_SYNC();
+
+		bsp_put(partner, &state, buffer, 0, sizeof(int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(3 * source + 2, buffer[0]);
+		bsp_pop_reg(buffer);
+
+		BSP_END();
+	}
+
+	int state;
+
+protected:
+	int partner;
+	int source;
+	int buffer[TEST_COMMBALANCE_SIZE];
+	int outgoing[TEST_COMMBALANCE_SIZE];
+};
+
+
+#endif // __test_commbalance_H__
@@ -122,6 +122,32 @@ public:
 			}
 		}
 
+		// Fetch-and-add a counter and claim a slot on processor 0.
+
+		if (bsp_pid() == 0) {
+			a2a_out[0] = 0;
+			a2a_out[1] = -1;
+		}
+
+		BSP_SYNC();
+
+		{
+			int one = 1, nobody = -1, me = bsp_pid();
+			bsp_fetch_op(0, a2a_out, 0, &one, &myval1, bsp_op_sum, bsp_type_int);
+			bsp_cas(0, a2a_out, sizeof(int), &nobody, &me, &myval2, bsp_type_int);
+		}
+
+		BSP_SYNC();
+
+		CHECK(myval1 >= 0 && myval1 < bsp_nprocs());
+		CHECK(myval2 >= -1 && myval2 < bsp_nprocs());
+		if (bsp_pid() == 0) {
+			CHECK_EQUAL(bsp_nprocs(), a2a_out[0]);
+			CHECK(a2a_out[1] >= 0 && a2a_out[1] < bsp_nprocs());
+		}
+
+		BSP_SYNC();
+
 		bsp_pop_reg(a2a_out);
 
 		delete [] a2a_in;
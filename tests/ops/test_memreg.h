@@ -0,0 +1,141 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_memreg.h
+
+Test registration sequences and node-shared registrations.
+
+@author Peter Krusche
+*/
+#ifndef __test_memreg_H__
+#define __test_memreg_H__
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+#define TEST_MEMREG_MAXPROCS 128
+
+/** all contexts on a node register this array */
+static int test_memreg_node_shared[TEST_MEMREG_MAXPROCS];
+
+class TestMemReg : public bsp::Context {
+public:
+	void init() {
+		var1 = -1;
+		var2 = -1;
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestMemReg);
+		BSP_BEGIN();
+
+		CHECK(bsp_nprocs() <= TEST_MEMREG_MAXPROCS);
+
+		test_memreg_node_shared[bsp_pid()] = -1;
+		bsp_push_reg(&var1, sizeof (int));
+		bsp_push_reg(test_memreg_node_shared, sizeof (int) * TEST_MEMREG_MAXPROCS);
+
+		BSP_SYNC();
+
+		right = (bsp_pid() + 1) % bsp_nprocs();
+		left = (bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs();
+		myval = bsp_pid() + 1;
+
+		bsp_put (right, &myval, &var1, 0, sizeof(int));
+		bsp_put (right, &myval, test_memreg_node_shared, bsp_pid() * sizeof(int), sizeof(int));
+
+		// replace var1 by var2
+		bsp_pop_reg(&var1);
+		bsp_push_reg(&var2, sizeof (int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(left + 1, var1);
+		CHECK_EQUAL(left + 1, test_memreg_node_shared[left]);
+
+		bsp_put (left, &myval, &var2, 0, sizeof(int));
+
+		// register var1 again
+		bsp_push_reg(&var1, sizeof (int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(right + 1, var2);
+
+		bsp_get (left, &var1, 0, &var2, sizeof(int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL((left + bsp_nprocs() - 1) % bsp_nprocs() + 1, var2);
+
+		bsp_pop_reg(&var1);
+		bsp_pop_reg(&var2);
+		bsp_pop_reg(test_memreg_node_shared);
+
+		BSP_SYNC();
+
+		// the register is empty again, so serials start from zero
+		reg_a = bsp_push_reg_handle(&var1, sizeof (int));
+		reg_b = bsp_push_reg_handle(&var2, sizeof (int));
+		CHECK_EQUAL((size_t)0, reg_a.get_serial());
+		CHECK_EQUAL((size_t)1, reg_b.get_serial());
+
+		BSP_SYNC();
+
+		bsp_pop_reg(&var1);
+
+		BSP_SYNC();
+
+		// popped serials are reused
+		reg_a = bsp_push_reg_handle(&myval, sizeof (int));
+		CHECK_EQUAL((size_t)0, reg_a.get_serial());
+
+		BSP_SYNC();
+
+		bsp_put (right, &myval, reg_a, 0, 1);
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(left + 1, myval);
+		bsp_pop_reg(&myval);
+		bsp_pop_reg(&var2);
+
+		BSP_END();
+	}
+
+protected:
+	bsp::Registration reg_a;
+	bsp::Registration reg_b;
+	int var1;
+	int var2;
+	int myval;
+	int left;
+	int right;
+};
+
+
+#endif // __test_memreg_H__
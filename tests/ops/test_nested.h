@@ -0,0 +1,134 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_nested.h
+
+Test nested runners.
+
+@author Peter Krusche
+*/
+#ifndef __test_nested_H__
+#define __test_nested_H__
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+/** Inner level: ring communication within each outer processor */
+class TestNestedInner : public bsp::Context {
+public:
+	TestNestedInner() {
+		base = 0;
+		sum = 0;
+		CONTEXT_SHARED_INIT(base, int);
+		CONTEXT_SHARED_REDUCE(bsp::ReduceSum, sum, int);
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestNestedInner);
+		BSP_BEGIN();
+
+		CHECK_EQUAL(1, bsp_level());
+		CHECK(bsp_enclosing() != NULL);
+		CHECK_EQUAL(base, bsp_enclosing()->bsp_pid());
+
+		bsp_push_reg(&var, sizeof (int));
+
+		BSP_SYNC();
+
+		left = (bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs();
+		value = 100 * base + bsp_pid();
+		bsp_put((bsp_pid() + 1) % bsp_nprocs(), &value, &var, 0, sizeof(int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(100 * base + left, var);
+		sum = var;
+		bsp_pop_reg(&var);
+
+		BSP_END();
+	}
+
+	int base;
+	int sum;
+
+protected:
+	int var;
+	int value;
+	int left;
+};
+
+/** Outer level: every processor runs a nested computation */
+class TestNested : public bsp::Context {
+public:
+	TestNested() {
+		total = 0;
+		CONTEXT_SHARED_REDUCE(bsp::ReduceSum, total, int);
+	}
+
+	void run( ) {
+		using namespace std;
+		BSP_SCOPE(TestNested);
+		BSP_BEGIN();
+
+		CHECK_EQUAL(0, bsp_level());
+
+		int k = inner_procs(bsp_pid());
+		bsp::Runner<TestNestedInner, bsp::NestedTaskMapper> inner (this, k);
+		inner.base = bsp_pid();
+		inner.run();
+
+		CHECK_EQUAL(expected_sum(bsp_pid()), inner.sum);
+
+		// pass the result on to the outer level
+		total = inner.sum;
+
+		BSP_END();
+	}
+
+	/** check the result after the run */
+	void check_total (int processors) {
+		int t = 0;
+		for (int p = 0; p < processors; ++p) {
+			t += expected_sum(p);
+		}
+		CHECK_EQUAL(t, total);
+	}
+
+	int total;
+
+private:
+	static int inner_procs (int p) {
+		return 1 + p % 3;
+	}
+
+	static int expected_sum (int p) {
+		int k = inner_procs(p);
+		return 100 * p * k + k * (k - 1) / 2;
+	}
+};
+
+#endif // __test_nested_H__
@@ -0,0 +1,100 @@
+/*
+BSPonMPI. This is an implementation of the BSPlib standard on top of MPI
+Copyright (C) 2006  Wijnand J. Suijlen, 2012 Peter Krusche
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+See the AUTHORS file distributed with this library for author contact
+information.
+*/
+
+
+/** @file test_numa.h
+
+Test binding of contexts to NUMA nodes by the NUMA task mapper.
+
+@author Peter Krusche
+*/
+#ifndef __test_numa_H__
+#define __test_numa_H__
+
+#include <vector>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "bsp_cpp/bsp_cpp.h"
+#include "../unittest.h"
+
+class TestNuma : public bsp::Context {
+public:
+	void init() {
+		var = -1;
+		init_node = bsp::numa_bound_node();
+	}
+
+	void run( ) {
+		BSP_SCOPE(TestNuma);
+		BSP_BEGIN();
+
+		// consecutive local processors share a node, and every step runs
+		// on the node of its context
+		CHECK(get_mapper()->numa_affinity_enabled());
+		{
+			std::vector<int> nodes;
+			bsp::NumaTopology::get().distribute(get_mapper()->procs_this_node(), nodes);
+			CHECK_EQUAL(nodes[bsp_local_pid()], get_mapper()->numa_node(bsp_local_pid()));
+		}
+		CHECK_EQUAL(get_mapper()->numa_node(bsp_local_pid()), bsp::numa_bound_node());
+		// also when init() is called again for a new run
+		CHECK_EQUAL(get_mapper()->numa_node(bsp_local_pid()), init_node);
+
+		bsp_push_reg(&var, sizeof (int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL(get_mapper()->numa_node(bsp_local_pid()), bsp::numa_bound_node());
+		pid = bsp_pid();
+		bsp_put ((bsp_pid() + 1) % bsp_nprocs(), &pid, &var, 0, sizeof(int));
+
+		BSP_SYNC();
+
+		CHECK_EQUAL((bsp_pid() + bsp_nprocs() - 1) % bsp_nprocs(), var);
+		bsp_pop_reg(&var);
+
+		BSP_END();
+	}
+
+	/** After a run, no thread which ran a step may still be bound */
+	static void check_unbound () {
+		CHECK_EQUAL(-1, bsp::numa_bound_node());
+		tbb::parallel_for (tbb::blocked_range<int> (0, 1024), CheckUnbound());
+	}
+
+protected:
+	int var;
+	int pid;
+	int init_node;
+
+	/** parallel_for body which checks that the worker is not bound */
+	struct CheckUnbound {
+		void operator() (tbb::blocked_range<int> const &) const {
+			CHECK_EQUAL(-1, bsp::numa_bound_node());
+		}
+	};
+};
+
+
+#endif // __test_numa_H__
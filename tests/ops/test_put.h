@@ -113,6 +113,52 @@ public:
 			}
 		}
 
+		// Strided: every P-th element of a2a_out to row pid of a2a_in on j.
+
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			bsp_put_strided(j, a2a_out + j, bsp_nprocs() * sizeof(int), 
+				a2a_in, bsp_pid() * 10 * sizeof(int), sizeof(int), sizeof(int), 10);
+		}
+
+		BSP_SYNC();
+
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			for (int k = 0; k < 10; ++k) {
+				int index = bsp_pid() + k * bsp_nprocs();
+				CHECK_EQUAL(
+					( (index / 10) * bsp_nprocs() + j ) * (index % 10), 
+					a2a_in[j*10 + k]
+				);
+			}
+		}
+
+		BSP_SYNC();
+
+		// Accumulate: every processor adds pid+1 to the first nine 
+		// elements of a2a_in on all processors, and takes the maximum 
+		// of pid+1 with the tenth.
+
+		for (int k = 0; k < 10; ++k) {
+			a2a_in[k] = 0;
+			a2a_out[k] = bsp_pid() + 1;
+		}
+
+		BSP_SYNC();
+
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			bsp_put_accumulate(j, a2a_out, a2a_in, 0, 9 * sizeof(int), 
+				bsp_op_sum, bsp_type_int);
+			bsp_put_accumulate(j, &myval1, a2a_in, 9 * sizeof(int), sizeof(int), 
+				bsp_op_max, bsp_type_int);
+		}
+
+		BSP_SYNC();
+
+		for (int k = 0; k < 9; ++k) {
+			CHECK_EQUAL(bsp_nprocs() * (bsp_nprocs() + 1) / 2, a2a_in[k]);
+		}
+		CHECK_EQUAL(bsp_nprocs(), a2a_in[9]);
+
 		BSP_SYNC();
 
 		bsp_pop_reg(a2a_in);
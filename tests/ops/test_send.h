@@ -98,6 +98,56 @@ public:
 		CHECK_EQUAL( bsp_pid() + 1, myval [1] );
 		CHECK_EQUAL( bsp_nprocs() - bsp_pid(), myval[2] );
 
+		// All-to-all, received in bulk.
+
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			var1 = 100 * bsp_pid() + j;
+			bsp_send (j, &j, &var1, sizeof(int));
+		}
+
+		BSP_SYNC();
+
+		{
+			bsp::MessageRange r = bsp_messages();
+			CHECK_EQUAL( (size_t)bsp_nprocs(), r.size() );
+			int sources = 0;
+			for (bsp::MessageRange::const_iterator it = r.begin(); it != r.end(); ++it) {
+				CHECK_EQUAL( sizeof(int), it->nbytes );
+				CHECK_EQUAL( bsp_pid(), *((const int*)it->tag) );
+				CHECK_EQUAL( 100 * it->source + bsp_pid(), *((const int*)it->payload) );
+				sources += it->source;
+			}
+			CHECK_EQUAL( bsp_nprocs() * (bsp_nprocs() - 1) / 2, sources );
+
+			int messages = -1;
+			size_t bytes = -1;
+			bsp_qsize (&messages, &bytes);
+			CHECK_EQUAL( 0, messages );
+		}
+
+		// All-to-all with a combiner: one message per sender.
+
+		bsp_set_combiner(tag_key, sum_ints);
+		for (int j = 0; j < bsp_nprocs(); ++j) {
+			for (int k = 0; k < 10; ++k) {
+				var1 = 100 * bsp_pid() + k;
+				bsp_send (j, &j, &var1, sizeof(int));
+			}
+		}
+		bsp_set_combiner(NULL, NULL);
+
+		BSP_SYNC();
+
+		{
+			bsp::MessageRange r = bsp_messages();
+			CHECK_EQUAL( (size_t)bsp_nprocs(), r.size() );
+			for (bsp::MessageRange::const_iterator it = r.begin(); it != r.end(); ++it) {
+				CHECK_EQUAL( sizeof(int), it->nbytes );
+				CHECK_EQUAL( bsp_pid(), *((const int*)it->tag) );
+				CHECK_EQUAL( 1000 * it->source + 45, *((const int*)it->payload) );
+			}
+		}
+
 #ifdef MACCAROON
 		a2a_in = new int [bsp_nprocs() * 100];
 		a2a_out = new int [bsp_nprocs() * 100];
@@ -146,6 +196,14 @@ public:
 	}
 
 protected:
+	static long tag_key (const void * tag, const void *, size_t) {
+		return *((const int*)tag);
+	}
+
+	static void sum_ints (void * accumulated, const void * payload, size_t) {
+		*((int*)accumulated) += *((const int*)payload);
+	}
+
 	int var1;
 	int var2;
 	int var3;